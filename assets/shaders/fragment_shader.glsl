@@ -11,12 +11,17 @@ uniform vec3 lightPos2;
 uniform vec3 lightColor;
 uniform vec3 lightColor2;
 
-uniform vec3 viewPos;  // camera position
+// Wspólny blok kamery (UBO)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
 void main()
 {
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
 
     // -------------------------
     // Light 1
@@ -0,0 +1,7 @@
+#version 330 core
+in vec3 GlyphColor;
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(GlyphColor, 1.0);
+}
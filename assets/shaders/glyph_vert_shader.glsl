@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;        // Strzałka o długości 1 wzdłuż +X
+layout (location = 1) in vec3 iPosition;   // Dane instancji
+layout (location = 2) in vec3 iDirection;
+layout (location = 3) in float iMagnitude;
+
+out vec3 GlyphColor;
+
+// Wspólny blok kamery (UBO)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+uniform float glyphLength;    // długość strzałki o największym module
+uniform float maxMagnitude;
+
+void main() {
+    // Baza obrócona tak, by +X strzałki pokrywał się z kierunkiem prędkości
+    vec3 up = abs(iDirection.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 side = normalize(cross(iDirection, up));
+    vec3 normal = cross(side, iDirection);
+
+    float t = maxMagnitude > 0.0 ? clamp(iMagnitude / maxMagnitude, 0.0, 1.0) : 0.0;
+    vec3 world = iPosition + (iDirection * aPos.x + normal * aPos.y + side * aPos.z) * (glyphLength * t);
+
+    gl_Position = projection * view * vec4(world, 1.0);
+
+    // Kolor od niebieskiego (wolno) do czerwonego (szybko)
+    GlyphColor = mix(vec3(0.1, 0.3, 1.0), vec3(1.0, 0.2, 0.1), t);
+}
@@ -1,8 +1,13 @@
 #version 330 core
 layout (location = 0) in vec3 aPos; // Wierzchołki z location 0
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Wspólny blok kamery (UBO)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
 void main() {
     // KLUCZOWE: Wierzchołki MUSZĄ być transformowane przez wszystkie 3 macierze
@@ -4,8 +4,13 @@ layout(location=0) in vec3 aPos;
 layout(location=1) in vec3 aNormal;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Wspólny blok kamery (UBO)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -0,0 +1,66 @@
+#version 330 core
+
+// Raymarching gęstości barwnika przez teksturę 3D
+// Rysowane są tylne ściany kostki, więc działa też z kamerą wewnątrz objętości
+
+in vec3 LocalPos;
+out vec4 FragColor;
+
+uniform sampler3D volume;
+uniform vec3 camLocal;     // pozycja kamery w układzie kostki [0,1]^3
+uniform vec3 volumeColor;
+uniform float opacity;     // pochłanianie na jednostkę długości kostki przy gęstości 1
+uniform int steps;         // liczba kroków wzdłuż przekątnej
+uniform sampler2D sceneDepth;  // głębokość nieprzezroczystej sceny (kopia bufora głębokości okna)
+uniform mat4 clipToLocal;      // odwrotność projection * view * model
+
+void main() {
+    // Rysowane są tylne ściany, więc fragment jest punktem wyjścia promienia z kostki
+    vec3 ray = LocalPos - camLocal;
+    float tFar = length(ray);
+    vec3 dir = ray / tFar;
+
+    // Promień kończy się na nieprzezroczystej scenie: punkt z bufora głębokości leży na tym samym
+    // promieniu kamery, więc jego odległość w układzie kostki ogranicza tFar
+    float depth = texelFetch(sceneDepth, ivec2(gl_FragCoord.xy), 0).r;
+    if (depth < 1.0) {
+        vec2 ndc = gl_FragCoord.xy / vec2(textureSize(sceneDepth, 0)) * 2.0 - 1.0;
+        vec4 scene = clipToLocal * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+        tFar = min(tFar, length(scene.xyz / scene.w - camLocal));
+    }
+
+    // Wejście do kostki -- kamera wewnątrz zaczyna od razu
+    float tNear = 0.0;
+    if (any(lessThan(camLocal, vec3(0.0))) || any(greaterThan(camLocal, vec3(1.0)))) {
+        // Bez dzielenia przez zero (programowy Mesa nie zawsze zwraca tu nieskończoność)
+        vec3 safeDir = mix(vec3(1e-6), dir, greaterThan(abs(dir), vec3(1e-6)));
+        vec3 t0 = -camLocal / safeDir;
+        vec3 t1 = (vec3(1.0) - camLocal) / safeDir;
+        vec3 tMin = min(t0, t1);
+        tNear = max(max(max(tMin.x, tMin.y), tMin.z), 0.0);
+    }
+    if (tFar <= tNear) discard;
+
+    // Środki tekseli leżą w punktach siatki cieczy (0..N-1 rozpięte na [0,1])
+    vec3 size = vec3(textureSize(volume, 0));
+    vec3 texScale = (size - 1.0) / size;
+    vec3 texOffset = 0.5 / size;
+
+    float dt = 1.7320508 / float(steps);
+    vec4 acc = vec4(0.0);
+
+    for (int i = 0; i < steps; i++) {
+        float t = tNear + (float(i) + 0.5) * dt;
+        if (t > tFar || acc.a > 0.99) break;
+
+        vec3 p = camLocal + t * dir;
+        float d = max(textureLod(volume, p * texScale + texOffset, 0.0).r, 0.0);
+
+        // Kompozycja przód-tył (kolor przemnożony przez alfę)
+        float a = 1.0 - exp(-d * opacity * dt);
+        acc.rgb += (1.0 - acc.a) * a * volumeColor;
+        acc.a += (1.0 - acc.a) * a;
+    }
+
+    FragColor = acc;
+}
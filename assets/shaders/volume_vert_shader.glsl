@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // Wierzchołki kostki [0,1]^3
+
+out vec3 LocalPos;
+
+uniform mat4 model;
+
+// Wspólny blok kamery (UBO)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+void main() {
+    LocalPos = aPos;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
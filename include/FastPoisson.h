@@ -0,0 +1,55 @@
+#ifndef FAST_POISSON_H_
+#define FAST_POISSON_H_
+
+#include <complex>
+#include <vector>
+
+// Dokładne rozwiązanie 6 p - (suma 6 sąsiadów) = rhs na sześcianie n^3 z warunkiem Neumanna
+// (komórka za brzegiem równa sąsiedniej, jak set_bounds(0, ...)). Wektory własne tego laplasjanu
+// to baza DCT-II, więc wystarczy DCT wzdłuż trzech osi, dzielenie przez wartości własne i transformata
+// odwrotna -- O(n^3 log n). DCT liczona przez zespolone FFT długości n (mieszana podstawa, dowolne n).
+class FastPoisson {
+
+    public:
+
+        FastPoisson();
+
+        // n -- liczba komórek wewnętrznych na oś
+        void Create(int n);
+
+        int Size() const { return mSize; }
+
+        // Dane n^3 (x najszybciej), wejście: prawa strona, wyjście: p ze średnią zero
+        double* Data() { return mData.data(); }
+
+        // Rozwiązanie w miejscu na Data(), linie transformat dzielone między wątki ThreadPool
+        void Solve();
+
+    private:
+
+        typedef std::complex<double> Complex;
+
+        // Jedna oś: DCT-II (forward) albo odwrotna DCT-II dla wszystkich linii o kroku 'stride'
+        void transformAxis(int stride, bool inverse);
+
+        // Dwie linie naraz w jednym zespolonym FFT
+        void dct(double *a, double *b, Complex *work, Complex *scratch) const;
+        void idct(double *a, double *b, Complex *work, Complex *scratch) const;
+
+        // Rekurencyjne FFT Cooleya-Tukeya po czynnikach mFactors, sign = -1 (w przód) / +1 (wstecz)
+        void fft(const Complex *in, Complex *out, int n, int stride, int factor, int sign, Complex *scratch) const;
+
+        int mSize;
+        std::vector<int> mFactors;
+
+        // Pierwiastki z jedności stopnia n oraz przesunięcia fazy DCT exp(-i pi k / 2n)
+        std::vector<Complex> mRoots;
+        std::vector<Complex> mShift;
+
+        // Wartości własne 2 - 2 cos(pi k / n) jednej osi
+        std::vector<double> mEigen;
+
+        std::vector<double> mData;
+};
+
+#endif
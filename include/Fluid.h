@@ -2,50 +2,194 @@
 #define FLUID_H_
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "FastPoisson.h"
+#include "HalfFloat.h"
+#include "VoxelGrid.h"
 #define IX(x, y, z) ((x) + (y) * N + (z) * N * N)
 
-class Fluid {
+// Bloki aktywności 8^3 -- przy skipQuiet bloki bez barwnika i ruchu są pomijane w advect i dyfuzji barwnika
+static const int activityBlockBits = 3;
+static const float activityDensityEpsilon = 1e-4f;
+static const float activitySpeedEpsilon = 1e-3f;
+
+// Typ przechowywania tablic Vx0/Vy0/Vz0 -- obliczenia zawsze w typie Real solvera
+// Połowa pamięci tych tablic kosztem dokładności (half: 11 bitów mantysy, bfloat16: 8). Gęstość zostaje
+// w typie Real -- renderer i tak potrzebuje jej kopii w Real, a druga, 16-bitowa, kosztowała dwie konwersje na krok.
+enum FieldStorage { storageFloat, storageHalf, storageBFloat16 };
+
+// Rozmieszczenie prędkości: w środkach komórek albo na ściankach (siatka MAC).
+// W układzie MAC Vx[IX(i, j, k)] leży na ściance między komórkami i-1 oraz i (analogicznie Vy, Vz),
+// dywergencja i gradient ciśnienia są wtedy zwartymi różnicami, a ich złożenie to laplasjan 7-punktowy.
+enum FluidLayout { layoutCollocated, layoutMAC };
+
+// Schemat adwekcji: półlagranżowski (1. rzędu) albo MacCormack -- krok w przód i w tył, poprawka
+// o połowę błędu i przycięcie do zakresu 8 próbek z kroku w przód (bez nowych ekstremów)
+enum AdvectionScheme { advectSemiLagrangian, advectMacCormack };
+
+// Rozwiązywanie ciśnienia w project: iteracyjne (lin_solve, 'iter' kroków) albo dokładne spektralne
+// (FastPoisson, tylko bez przeszkód -- same ściany sześcianu). Auto wybiera spektralne w układzie MAC
+// bez przeszkód, gdzie daje dywergencję na poziomie błędu zaokrągleń, a poza nim iteracyjne.
+enum PressureSolver { pressureIterative, pressureSpectral, pressureAuto };
+
+// Grubość warstw z w wymuszaniu wirowości -- każda warstwa liczy dodatkowo wir jednej płaszczyzny
+// nad i pod sobą, więc cieńsze warstwy to więcej powtórzonej pracy
+static const int vorticitySlab = 8;
+
+class NestedFluid;
+
+// Solver z obliczeniami w typie Real: float w symulacji, double jako wzorzec do walidacji
+// (patrz FluidBench::Divergence). Definicje w Fluid.cpp, instancje dla float i double.
+template <typename Real>
+class FluidSolver {
     public:
         int size;
         float dt;
         int iter;
         float diff;
         float visc;
+
+        FieldStorage storage;
+        FluidLayout layout;
+
+        // Można zmieniać między krokami
+        AdvectionScheme advection;
+
+        // Przy przeszkodach zawsze iteracyjnie
+        PressureSolver pressure;
+
+        // Współczynnik wymuszania wirowości (vorticity confinement), 0 -- wyłączone
+        float vorticity;
+
+        // Pomijanie nieaktywnych bloków w advect i dyfuzji barwnika (domyślnie wyłączone).
+        // Przybliżenie: pominięty blok zachowuje poprzednie wartości zamiast wyniku pełnego kroku.
+        bool skipQuiet;
         
-        float *s;
-        float *density;
+        Real *s;
+
+        Real *density;
         
-        float *Vx;
-        float *Vy;
-        float *Vz;
+        Real *Vx;
+        Real *Vy;
+        Real *Vz;
+
+        // nullptr w trybie 16-bitowym
+        Real *Vx0;
+        Real *Vy0;
+        Real *Vz0;
 
-        float *Vx0;
-        float *Vy0;
-        float *Vz0;
+        // Pola 16-bitowe (half_t albo bfloat16_t zależnie od storage), nullptr w trybie float
+        uint16_t *Vx016;
+        uint16_t *Vy016;
+        uint16_t *Vz016;
 
-        Fluid(int size, float dt, int iter, float diffusion, float viscosity);
+        // Maska przeszkód (size^3), w pełnych komórkach prędkość jest zerowana
+        const VoxelGrid *obstacles;
 
-        ~Fluid();
+        // Mapa bitowa aktywnych bloków (siatka o boku size/8), odświeżana na początku kroku przy skipQuiet
+        VoxelGrid activity;
+
+        FluidSolver(int size, float dt, int iter, float diffusion, float viscosity, FieldStorage storage = storageFloat, FluidLayout layout = layoutCollocated);
+
+        ~FluidSolver();
 
         void AddDensity(int x, int y, int z, float amount);
 
         void AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ);
 
-        void set_bounds(int b, float *x);
+        // Maska musi mieć rozdzielczość size; przy innej zgłasza błąd, zdejmuje maskę i zwraca false
+        bool SetObstacles(const VoxelGrid *grid);
+
+        // Jądra działają na tablicach dowolnego typu przechowywania (float, half_t, bfloat16_t)
+        template <typename T>
+        void set_bounds(int b, T *x);
+
+        template <typename T>
+        void apply_obstacles(int b, T *x);
 
-        void lin_solve(int b, float *x, float *x0, float a, float c);
+        void update_activity();
 
-        void diffuse(int b, float *x, float *x0, float diff, float dt);
+        // active != nullptr -- komórki nieaktywnych bloków dostają x0 bez iterowania
+        template <typename X, typename X0>
+        void lin_solve(int b, X *x, X0 *x0, Real a, Real c, const VoxelGrid *active = nullptr);
 
-        void project(float *velX, float *velY, float *velZ, float *p, float *div);
+        template <typename X, typename X0>
+        void diffuse(int b, X *x, X0 *x0, Real diff, Real dt, const VoxelGrid *active = nullptr);
 
-        void advect(int b, float *d, float *d0, float *velX, float *velY, float *velZ, float dt);
+        template <typename V, typename P>
+        void project(V *velX, V *velY, V *velZ, P *p, P *div);
+
+        // active != nullptr -- nieaktywne bloki kopiują d0 (prędkość pomijalna, brak przesunięcia)
+        template <typename D, typename D0, typename V>
+        void advect(int b, D *d, D0 *d0, V *velX, V *velY, V *velZ, Real dt, const VoxelGrid *active = nullptr);
+
+        // Warianty dla układu MAC, wywoływane przez project / advect gdy layout == layoutMAC
+        template <typename V, typename P>
+        void project_mac(V *velX, V *velY, V *velZ, P *p, P *div);
+
+        // b = 1..3 -- składowa na ściankach, b = 0 -- pole w środkach komórek
+        template <typename D, typename D0, typename V>
+        void advect_mac(int b, D *d, D0 *d0, V *velX, V *velY, V *velZ, Real dt, const VoxelGrid *active = nullptr);
+
+        // MacCormack, wywoływany przez advect gdy advection == advectMacCormack (oba układy)
+        template <typename D, typename D0, typename V>
+        void advect_maccormack(int b, D *d, D0 *d0, V *velX, V *velY, V *velZ, Real dt, const VoxelGrid *active = nullptr);
+
+        // Siła eps * (n x w), n = grad|w| / |grad|w||, dodana do Vx/Vy/Vz na początku kroku.
+        // Wir, jego moduł i siła w jednym przejściu po warstwach z (ThreadPool), z pola sprzed kroku;
+        // siła dodawana do prędkości w drugim przejściu.
+        void confine_vorticity();
+
+        // Największa |div u| w komórkach wewnętrznych poza przeszkodami, różnicami zgodnymi z układem
+        double MaxDivergence() const;
             
         void FluidStep();
         
         void fadeDensity(float amount);
-};
 
+    private:
+
+        FastPoisson poisson;
+
+        // Ciśnienie p z prawej strony div (FastPoisson bez przeszkód dla pressureSpectral i dla Auto w układzie MAC)
+        template <typename P>
+        void solve_pressure(P *p, P *div);
+
+        // Rzut złożony przez dwa poziomy podmienia prawą stronę pod drobnym poziomem przed solve_pressure
+        friend class NestedFluid;
+
+        // Tablica pomocnicza MacCormacka (size^3), tworzona przy pierwszym użyciu
+        Real *scratch;
+
+        // Siła wymuszania wirowości (3 * size^3) między dwoma przejściami confine_vorticity
+        std::vector<Real> vortForce;
+
+        // Bufory update_activity: bloki z barwnikiem lub ruchem i największa prędkość w warstwie bloków z
+        std::vector<uint8_t> liveBlocks;
+        std::vector<float> layerSpeed;
+
+        // Prędkość w punkcie pola b (środek komórki dla b = 0, ścianka w układzie MAC)
+        template <typename V>
+        void point_velocity(int b, int index, const V *velX, const V *velY, const V *velZ, Real& u, Real& v, Real& w) const;
+
+        // Trójliniowe próbki f w punktach (begin + n, j, k) - dtN * (u, v, w)[n] dla n < count <= 8,
+        // lo / hi (opcjonalnie) dostają minimum i maksimum ośmiu użytych wartości
+        template <typename F>
+        void interpolate_row(const F *f, int j, int k, int begin, int count, const Real *u, const Real *v, const Real *w,
+                             Real dtN, Real *out, Real *lo = nullptr, Real *hi = nullptr) const;
+
+        // Krok dla typu przechowywania H tablic Vx0/Vy0/Vz0
+        template <typename H>
+        void step(H *velX0, H *velY0, H *velZ0);
+
+        // lin_solve dla x lub x0 w innym typie niż Real: płaszczyzny konwertowane wsadowo do bufora wątku,
+        // iteracja Gaussa-Seidla na buforze i zapis całej płaszczyzny z powrotem
+        template <typename X, typename X0>
+        void lin_solve_rows(int b, X *x, X0 *x0, Real a, Real c, const VoxelGrid *active);
+};
 
+typedef FluidSolver<float> Fluid;
 
 #endif
\ No newline at end of file
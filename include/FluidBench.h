@@ -0,0 +1,47 @@
+#ifndef FLUID_BENCH_H_
+#define FLUID_BENCH_H_
+
+#include "Fluid.h"
+
+// Pomiary solvera cieczy bez okna i OpenGL, uruchamiane z linii poleceń (patrz main.cpp)
+class FluidBench {
+
+    public:
+
+        // Wywołuje tryb wskazany w argv[1]; zwraca false, jeśli argv nie zawiera trybu pomiaru
+        static bool Dispatch(int argc, char** argv, int& exitCode);
+
+        // Porównanie przechowywania pól w float / half / bfloat16 na tej samej smudze barwnika
+        static int Precision(int size, int steps);
+
+        // Rozbieżność solvera float (z wybranym przechowywaniem pól) względem wzorca double, krok po kroku
+        static int Divergence(int size, int steps, FieldStorage storage);
+
+        // Układ zwykły i MAC przy rosnącej liczbie iteracji i z ciśnieniem spektralnym (iter = 0):
+        // czas kroku i dywergencja po rzucie
+        static int Layout(int size, int steps);
+
+        // Kula barwnika w polu obrotu bryły sztywnej, pełny obrót w 'steps' krokach:
+        // błąd i zachowane maksimum dla adwekcji półlagranżowskiej i MacCormacka (oraz półlagranżowskiej na 2N)
+        static int Advection(int size, int steps);
+
+        // Przegląd parametrów dt / diff / visc w FluidEnsemble: wyniki każdego członka, przepustowość
+        // w krokach członków na sekundę i porównanie z osobnymi instancjami Fluid
+        static int Ensemble(int size, int members, int steps);
+
+        // Smuga na rzadkiej siatce SparseFluid: aktywne bloki, pamięć i czas kroku na dużej siatce
+        // oraz różnica gęstości względem Fluid na siatce 'compareSize' (przy iter = 4 i prawie zbieżnym)
+        static int Sparse(int size, int steps, int compareSize);
+
+        // NestedFluid z przeszkodą nad smugą przy różnej liczbie przebiegów rzutu złożonego: dywergencja
+        // na granicy poziomów, czas kroku i pamięć wobec jednolitej Fluid o boku 2 * size
+        static int Nested(int size, int steps);
+
+    private:
+
+        // Źródło barwnika i prędkości w środku dolnej połowy siatki, jak w Simulation
+        template <typename Solver>
+        static void injectPlume(Solver& fluid);
+};
+
+#endif
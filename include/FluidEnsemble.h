@@ -0,0 +1,82 @@
+#ifndef FLUID_ENSEMBLE_H_
+#define FLUID_ENSEMBLE_H_
+
+#include <cstddef>
+#include <vector>
+
+// Liczba członków w jednej partii -- szerokość wektora AVX dla float
+static const int ensembleLanes = 8;
+
+// Parametry jednego członka zespołu
+struct EnsembleMember {
+    float dt;
+    float diff;
+    float visc;
+};
+
+// Podsumowanie stanu członka po krokach
+struct EnsembleStats {
+    double mass;        // suma gęstości barwnika
+    double kinetic;     // 0.5 * suma |v|^2
+    float maxSpeed;
+};
+
+// Wiele niezależnych symulacji Fluid na małych siatkach (przeglądy parametrów dt / diff / visc).
+// Członkowie są grupowani po ensembleLanes; w partii każda komórka trzyma obok siebie wartości
+// wszystkich członków (pole[komórka * ensembleLanes + człon]), więc pętle po członkach są wektorowe,
+// także w lin_solve, którego Gauss-Seidel wzdłuż wiersza sam się nie wektoryzuje. Partie dzielone są
+// między wątki ThreadPool. Krok odpowiada Fluid::FluidStep z układem zwykłym, adwekcją półlagranżowską
+// i ciśnieniem iteracyjnym, bez przeszkód i bez pomijania nieaktywnych bloków.
+class FluidEnsemble {
+
+    public:
+
+        FluidEnsemble();
+
+        bool Create(int size, int iter, const std::vector<EnsembleMember>& members);
+
+        int Size() const { return mSize; }
+        int Count() const { return static_cast<int>(mMembers.size()); }
+        const EnsembleMember& Member(int member) const { return mMembers[member]; }
+
+        void AddDensity(int member, int x, int y, int z, float amount);
+        void AddVelocity(int member, int x, int y, int z, float amountX, float amountY, float amountZ);
+
+        float Density(int member, int x, int y, int z) const;
+
+        // Jeden krok wszystkich członków
+        void Step();
+
+        void fadeDensity(float amount);
+
+        EnsembleStats Stats(int member) const;
+
+    private:
+
+        enum Field { fS, fDensity, fVx, fVy, fVz, fVx0, fVy0, fVz0, fieldCount };
+
+        struct Batch {
+            std::vector<float> fields[fieldCount];
+            float dt[ensembleLanes];
+            float diff[ensembleLanes];
+            float visc[ensembleLanes];
+        };
+
+        void stepBatch(Batch& batch);
+
+        void set_bounds(int b, float *x) const;
+        void lin_solve(int b, float *x, const float *x0, const float *a, const float *c) const;
+        void diffuse(int b, float *x, const float *x0, const float *coefficient, const float *dt) const;
+        void project(float *velX, float *velY, float *velZ, float *p, float *div) const;
+        void advect(int b, float *d, const float *d0, const float *velX, const float *velY, const float *velZ, const float *dt) const;
+
+        // Indeks wartości członka w partii
+        size_t at(int member, int x, int y, int z) const;
+
+        int mSize;
+        int mIter;
+        std::vector<EnsembleMember> mMembers;
+        std::vector<Batch> mBatches;
+};
+
+#endif
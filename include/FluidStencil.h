@@ -0,0 +1,48 @@
+#ifndef FLUID_STENCIL_H_
+#define FLUID_STENCIL_H_
+
+// Wzory jednej komórki wspólne dla Fluid, SparseFluid i FluidEnsemble
+// Solvery różnią się układem pamięci i pętlami, ale komórkę liczą tymi funkcjami w tej samej
+// kolejności działań, więc na tych samych danych dają w float te same wyniki.
+
+// Krok Gaussa-Seidla: prawa strona x0 i sześciu sąsiadów (+x, -x, +y, -y, +z, -z)
+template <typename Real>
+inline Real RelaxCell(Real x0, Real a, Real cRecip, Real xp, Real xm, Real yp, Real ym, Real zp, Real zm) {
+    return (x0 + a * (xp + xm + yp + ym + zp + zm)) * cRecip;
+}
+
+// Prawa strona równania ciśnienia -- dywergencja różnicami centralnymi
+template <typename Real>
+inline Real DivergenceCell(Real xp, Real xm, Real yp, Real ym, Real zp, Real zm, int N) {
+    return -0.5f * (xp - xm + yp - ym + zp - zm) / N;
+}
+
+// Składowa gradientu ciśnienia odejmowana od prędkości
+template <typename Real>
+inline Real GradientCell(Real pp, Real pm, int N) {
+    return 0.5f * (pp - pm) * N;
+}
+
+// Punkt startowy cofnięcia adwekcji (w komórkach), przycięty tak, żeby i0 + 1 <= N - 1
+template <typename Real>
+inline Real ClampBacktrace(Real x, int N) {
+    if (x < Real(0.5)) x = Real(0.5);
+    if (x > Real(N - 1.5)) x = Real(N - 1.5);
+    return x;
+}
+
+// Narożnik siatki z trzech sąsiednich komórek brzegowych
+template <typename Real>
+inline Real CornerCell(Real p, Real q, Real r) {
+    return Real(0.33) * (p + q + r);
+}
+
+// Interpolacja trójliniowa; c[4 * di + 2 * dj + dk], s1 / t1 / u1 -- części ułamkowe x / y / z
+template <typename Real>
+inline Real TrilinearCell(const Real c[8], Real s1, Real t1, Real u1) {
+    Real s0 = 1.0f - s1, t0 = 1.0f - t1, u0 = 1.0f - u1;
+    return s0 * (t0 * (u0 * c[0] + u1 * c[1]) + (t1 * (u0 * c[2] + u1 * c[3])))
+         + s1 * (t0 * (u0 * c[4] + u1 * c[5]) + (t1 * (u0 * c[6] + u1 * c[7])));
+}
+
+#endif
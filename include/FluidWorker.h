@@ -0,0 +1,48 @@
+#ifndef FLUID_WORKER_H_
+#define FLUID_WORKER_H_
+
+#include "Fluid.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Krok symulacji cieczy (FluidStep + zanikanie barwnika) na osobnym wątku
+// Start() zleca krok, Wait() czeka na jego koniec. Pomiędzy nimi wątek główny nie może
+// czytać ani zmieniać tablic Fluid -- krok liczy się podczas renderowania i oczekiwania na klatkę.
+class FluidWorker {
+
+    public:
+
+        FluidWorker(Fluid& fluid, float fade);
+        ~FluidWorker();
+
+        FluidWorker(const FluidWorker&) = delete;
+        FluidWorker& operator=(const FluidWorker&) = delete;
+
+        void Start();
+        void Wait();
+
+        // Czas ostatniego kroku w nanosekundach (0 przed pierwszym krokiem), czytać po Wait()
+        uint64_t LastStepNs() const { return mLastStepNs; }
+
+    private:
+
+        void workerLoop();
+
+        Fluid& mFluid;
+        float mFade;
+
+        std::thread mThread;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mDone;
+
+        bool mPending;
+        bool mStop;
+
+        uint64_t mLastStepNs;
+};
+
+#endif
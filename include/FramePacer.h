@@ -0,0 +1,36 @@
+#ifndef FRAME_PACER_H_
+#define FRAME_PACER_H_
+
+#include <chrono>
+
+// Zapas czasu przed terminem klatki dokańczany aktywnym czekaniem (dokładność usypiania systemu)
+static const std::chrono::microseconds pacerSpinMargin(1000);
+
+// Odmierzanie klatek bez zajmowania rdzenia
+// Wait() usypia wątek do terminu następnej klatki (minus pacerSpinMargin), a resztę
+// dokańcza krótką pętlą z yield. Terminy liczone są od poprzedniego terminu, więc błędy
+// nie kumulują się; po dłuższym przestoju harmonogram startuje od nowa.
+// Przy aktywnym V-sync klatki odmierza SDL_GL_SwapWindow, a Wait() nie czeka.
+class FramePacer {
+
+    public:
+
+        FramePacer();
+
+        void SetRate(int framesPerSecond);
+        void SetVsync(bool enabled) { mVsync = enabled; }
+        bool Vsync() const { return mVsync; }
+
+        // Czekanie do terminu następnej klatki
+        void Wait();
+
+    private:
+
+        typedef std::chrono::steady_clock Clock;
+
+        Clock::duration mPeriod;
+        Clock::time_point mNext;
+        bool mVsync;
+};
+
+#endif
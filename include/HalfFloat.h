@@ -0,0 +1,128 @@
+#ifndef HALF_FLOAT_H_
+#define HALF_FLOAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// 16-bitowe typy przechowywania pól -- obliczenia zawsze we float
+// Osobne typy (zamiast uint16_t), żeby LoadField/StoreField wybierały konwersję po typie tablicy
+struct half_t { uint16_t bits; };       // IEEE 754 binary16
+struct bfloat16_t { uint16_t bits; };   // górne 16 bitów float32
+
+// float -> half, zaokrąglenie do najbliższej parzystej
+inline uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // Nieskończoność / NaN / przepełnienie
+    if (exponent >= 31) {
+        bool nan = (bits & 0x7FFFFFFF) > 0x7F800000;
+        return static_cast<uint16_t>(sign | 0x7C00 | (nan ? 0x200 : 0));
+    }
+
+    // Liczby zdenormalizowane i zero
+    if (exponent <= 0) {
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+
+        mantissa |= 0x800000;
+        uint32_t shift = uint32_t(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Przeniesienie z mantysy do wykładnika przy zaokrągleniu jest poprawne
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return static_cast<uint16_t>(half);
+}
+
+// half -> float (dokładnie), liczby zdenormalizowane przez odejmowanie we float
+inline float HalfToFloat(uint16_t half) {
+    uint32_t bits = uint32_t(half & 0x7FFF) << 13;
+    uint32_t exponent = bits & 0x0F800000;
+
+    bits += uint32_t(127 - 15) << 23;
+    if (exponent == 0x0F800000) {
+        // Nieskończoność / NaN
+        bits += uint32_t(128 - 16) << 23;
+    }
+    else if (exponent == 0) {
+        bits += 1u << 23;
+        float value, magic;
+        uint32_t magicBits = uint32_t(113) << 23;
+        std::memcpy(&value, &bits, sizeof(value));
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        value -= magic;
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+
+    bits |= uint32_t(half & 0x8000) << 16;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// float -> bfloat16, zaokrąglenie do najbliższej parzystej (NaN zostaje NaN)
+inline uint16_t FloatToBFloat16(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) return static_cast<uint16_t>((bits >> 16) | 0x40);
+
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+inline float BFloat16ToFloat(uint16_t value) {
+    uint32_t bits = uint32_t(value) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// Odczyt / zapis elementu pola w dowolnym typie przechowywania
+inline float LoadField(float value) { return value; }
+inline void StoreField(float& field, float value) { field = value; }
+inline double LoadField(double value) { return value; }
+inline void StoreField(double& field, double value) { field = value; }
+
+// Z -mf16c (lub -march=native) pojedyncze konwersje half to jedna instrukcja
+inline float LoadField(half_t value) {
+#if defined(__F16C__)
+    return _cvtsh_ss(value.bits);
+#else
+    return HalfToFloat(value.bits);
+#endif
+}
+
+inline void StoreField(half_t& field, float value) {
+#if defined(__F16C__)
+    field.bits = _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+    field.bits = FloatToHalf(value);
+#endif
+}
+
+inline float LoadField(bfloat16_t value) { return BFloat16ToFloat(value.bits); }
+inline void StoreField(bfloat16_t& field, float value) { field.bits = FloatToBFloat16(value); }
+
+// Konwersja całych tablic -- 8 wartości na instrukcję (F16C dla half, AVX2 dla bfloat16), jeśli procesor je ma
+// (sprawdzane w czasie działania)
+void HalfToFloatArray(const half_t *in, float *out, size_t n);
+void FloatToHalfArray(const float *in, half_t *out, size_t n);
+void BFloat16ToFloatArray(const bfloat16_t *in, float *out, size_t n);
+void FloatToBFloat16Array(const float *in, bfloat16_t *out, size_t n);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef ISOSURFACE_H_
+#define ISOSURFACE_H_
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Siatka indeksowana powierzchni izo (pozycje, normalne z gradientu pola, trójkąty)
+struct IsoMesh {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<uint32_t> indices;
+
+    void Clear() {
+        positions.clear();
+        normals.clear();
+        indices.clear();
+    }
+};
+
+// Tablice marching cubes (generowane raz przy pierwszym użyciu)
+// Narożniki: 0 (0,0,0), 1 (1,0,0), 2 (1,1,0), 3 (0,1,0), 4 (0,0,1), 5 (1,0,1), 6 (1,1,1), 7 (0,1,1)
+// Krawędzie: 0-3 dół (0-1, 1-2, 2-3, 3-0), 4-7 góra (4-5, 5-6, 6-7, 7-4), 8-11 pionowe (0-4, 1-5, 2-6, 3-7)
+// Dla każdego z 256 przypadków lista krawędzi trójkątów zakończona -1
+struct MarchingCubesTables {
+    uint16_t edgeMask[256];
+    uint8_t triangleCount[256];
+    int8_t triangles[256][16];
+
+    static const MarchingCubesTables& Get();
+};
+
+// Marching cubes pola skalarnego N^3 (układ IX: x + y * N + z * N * N)
+// Pole dzielone jest na warstwy wzdłuż Z przetwarzane równolegle, każda warstwa ma własny bufor
+// wyjściowy i współdzieli wierzchołki na krawędziach siatki. Płaszczyzna na granicy dwóch warstw
+// należy do warstwy wyższej, więc każdy wierzchołek powstaje raz. Bufory i pamięć krawędzi
+// zostają między klatkami.
+// Komórki z wartością > iso są "wewnątrz", normalne wskazują na zewnątrz (spadek wartości).
+// Wierzchołek w punkcie siatki p ma pozycję origin + p * cellSize.
+class MarchingCubes {
+
+    public:
+
+        void Extract(const float* field, int N, float iso, float cellSize, const glm::vec3& origin, IsoMesh& out);
+
+    private:
+
+        struct Slab {
+            IsoMesh mesh;
+
+            // Identyfikatory wierzchołków krawędzi X / Y dolnej płaszczyzny warstwy i górnej (z następnej warstwy)
+            std::vector<uint32_t> bottomX, bottomY, topX, topY;
+
+            // Krawędzie X / Y dwóch płaszczyzn pośrednich i krawędzie Z bieżącej warstwy komórek
+            std::vector<uint32_t> xEdges[2], yEdges[2], zEdges;
+        };
+
+        static void extractSlab(const float* f, int N, float iso, float cellSize, const glm::vec3& origin,
+                                int z0, int z1, Slab& slab, const std::vector<uint32_t>& topX, const std::vector<uint32_t>& topY);
+
+        std::vector<Slab> mSlabs;
+
+        // Górna płaszczyzna siatki, jej wierzchołki należą do ostatniej warstwy
+        std::vector<uint32_t> mTopX, mTopY;
+};
+
+// Flying edges (Schroeder i in. 2015) -- dwuprzebiegowa wersja bez alokacji w trakcie ekstrakcji
+// 1. przebieg: dla każdego wiersza siatki (y, z) liczba przeciętych krawędzi X/Y/Z, zakres x
+//    z przecięciami (przycinanie wierszy) oraz liczba trójkątów w wierszu komórek.
+// 2. sumy prefiksowe dają każdemu wierszowi stałe miejsce w buforach wyjściowych,
+// 3. przebieg: wiersze komórek równolegle wpisują wierzchołki i trójkąty w swoje miejsca.
+// Wierzchołki są unikalne w całej siatce (każda krawędź należy do swojego punktu początkowego).
+// Po pierwszych klatkach bufory wewnętrzne i wyjściowe mają już potrzebną pojemność.
+// Konwencje jak w MarchingCubes.
+class FlyingEdges {
+
+    public:
+
+        void Extract(const float* field, int N, float iso, float cellSize, const glm::vec3& origin, IsoMesh& out);
+
+    private:
+
+        // Wiersz punktów (y, z): krawędzie wychodzące z punktów w kierunkach +X, +Y, +Z
+        struct PointRow {
+            uint32_t edges[3];
+            int xl, xr;          // zakres punktów z przeciętą krawędzią
+            uint32_t vertexBase;
+        };
+
+        // Wiersz komórek (y, z)
+        struct CellRow {
+            uint32_t triangles;
+            int xl, xr;          // zakres komórek z trójkątami
+            uint32_t indexBase;
+        };
+
+        std::vector<PointRow> mPointRows;
+        std::vector<CellRow> mCellRows;
+        std::vector<uint8_t> mEdgeCases;   // na punkt: bity przeciętych krawędzi X/Y/Z i bit "wewnątrz"
+        std::vector<uint8_t> mConfigs;     // na komórkę: przypadek marching cubes
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+// Plik zmapowany do pamięci tylko do odczytu
+// Linux: mmap, Windows (MSYS2): CreateFileMapping/MapViewOfFile
+class MappedFile {
+    public:
+
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::string& path);
+        void Close();
+
+        bool IsOpen() const { return mData != nullptr; }
+        const unsigned char* Data() const { return mData; }
+        size_t Size() const { return mSize; }
+
+    private:
+
+        const unsigned char* mData;
+        size_t mSize;
+
+#ifdef _WIN32
+        void* mFile;
+        void* mMapping;
+#else
+        int mFd;
+#endif
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef MESH_H_
+#define MESH_H_
+
+#include "MappedFile.h"
+#include "VoxelGrid.h"
+
+#include "glm/glm.hpp"
+
+#include <tiny_obj_loader.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binarny cache modelu zapisywany obok pliku .obj (np. Propeller.obj.meshcache)
+// Przy kolejnych uruchomieniach plik jest mapowany do pamięci zamiast parsowania tekstu
+static const uint32_t meshCacheMagic   = 0x4853454D; // "MESH"
+static const uint32_t meshCacheVersion = 3;
+
+// Rozmiar symulowanego cache wierzchołków GPU (post-transform) przy sortowaniu trójkątów
+static const int vertexCacheSize = 16;
+
+// Układ pliku: [nagłówek][pozycje xyz][normalne xyz][indeksy]
+// Dane zapisane w natywnej kolejności bajtów, każda sekcja wyrównana do 16 bajtów
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+
+    // Suma kontrolna (FNV-1a) i rozmiar pliku źródłowego .obj
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+
+    float boundsMin[3];
+    float boundsMax[3];
+
+    uint64_t positionsOffset;
+    uint64_t normalsOffset;
+    uint64_t indicesOffset;
+};
+
+// Widok na gotową siatkę -- wskaźniki do zmapowanego cache albo do wektorów w pamięci
+struct MeshView {
+    const float* positions = nullptr;
+    const float* normals = nullptr;
+    const uint32_t* indices = nullptr;
+
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Siatka indeksowana przechowywana w pamięci (unikalne pary pozycja + normalna)
+struct MeshData {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<uint32_t> indices;
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    MeshView View() const;
+    void Clear();
+};
+
+class MeshCache {
+    public:
+
+        static std::string CachePath(const std::string& objPath);
+
+        // Hashuje zawartość pliku źródłowego
+        static bool HashFile(const std::string& path, uint64_t& hash, uint64_t& size);
+
+        static bool Write(const std::string& objPath, uint64_t sourceHash, uint64_t sourceSize,
+                          const MeshView& mesh);
+
+        // Mapuje cache i sprawdza czy odpowiada plikowi źródłowemu
+        bool Open(const std::string& objPath, uint64_t sourceHash, uint64_t sourceSize);
+        void Close();
+
+        bool IsOpen() const { return mFile.IsOpen(); }
+        const MeshView& View() const { return mView; }
+
+    private:
+
+        MappedFile mFile;
+        MeshView mView;
+};
+
+// Wyliczenie prostopadłościanu otaczającego dla tablicy [x0, y0, z0, x1, ...]
+void ComputeBounds(const float* positions, uint32_t vertexCount, glm::vec3& bmin, glm::vec3& bmax);
+
+// Zamiana "zupy" wierzchołków z .obj na siatkę indeksowaną
+// Identyczne pary (pozycja, normalna) trafiają do bufora tylko raz
+void BuildIndexedMesh(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::index_t>& corners, MeshData& out);
+
+// Normalne dla wierzchołków bez normalnych w pliku (średnia ważona polem sąsiednich trójkątów)
+void ComputeMissingNormals(MeshData& mesh);
+
+// Zaznacza komórki siatki res^3 przecinane przez trójkąty modelu (test SAT trójkąt-sześcian)
+// Komórka (x, y, z) zajmuje [origin + (x, y, z) * cellSize, origin + (x+1, y+1, z+1) * cellSize]
+void VoxelizeMesh(const MeshView& mesh, int res, float cellSize, const glm::vec3& origin, VoxelGrid& out);
+
+// Sortowanie trójkątów pod cache wierzchołków GPU (Tipsify) i wierzchołków w kolejności użycia
+void OptimizeVertexCache(MeshData& mesh, int cacheSize = vertexCacheSize);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef MODEL_LOADER_H_
+#define MODEL_LOADER_H_
+
+#include "Mesh.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Wynik wczytania modelu -- gotowe bufory do wysłania na GPU
+struct ModelJob {
+    std::string path;
+
+    // Parametry siatki voxeli, w której zaznaczamy komórki zajęte przez model
+    int voxelRes = 0;
+    float voxelSize = 0.0f;
+    glm::vec3 voxelOrigin = glm::vec3(0.0f);
+
+    // To samo w rozdzielczości siatki cieczy -- maska przeszkód dla Fluid (fluidRes = 0 -- pomijane)
+    int fluidRes = 0;
+    float fluidCellSize = 0.0f;
+    glm::vec3 fluidOrigin = glm::vec3(0.0f);
+
+    bool ok = false;
+
+    // Dane siatki: zmapowany cache albo (gdy nie udało się go zapisać) wektory w pamięci
+    MeshCache cache;
+    MeshData data;
+    MeshView mesh;
+
+    VoxelGrid voxels;
+    VoxelGrid fluidVoxels;
+};
+
+// Wczytywanie i przygotowanie modeli (parsowanie, deduplikacja, normalne, voxelizacja)
+// na osobnym wątku; wątek OpenGL odbiera gotowe zadania przez kolejkę Poll()
+class ModelLoader {
+
+    public:
+
+        ModelLoader();
+        ~ModelLoader();
+
+        ModelLoader(const ModelLoader&) = delete;
+        ModelLoader& operator=(const ModelLoader&) = delete;
+
+        void Request(std::unique_ptr<ModelJob> job);
+
+        // Nieblokujące pobranie ukończonego zadania
+        std::unique_ptr<ModelJob> Poll();
+
+        // Wczytanie modelu w bieżącym wątku
+        static bool Load(ModelJob& job);
+
+    private:
+
+        void workerLoop();
+
+        std::thread mThread;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+
+        std::deque<std::unique_ptr<ModelJob>> mPending;
+        std::deque<std::unique_ptr<ModelJob>> mCompleted;
+
+        bool mStop;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef NESTED_FLUID_H_
+#define NESTED_FLUID_H_
+
+#include "Fluid.h"
+#include "SparseFluid.h"
+
+// Blok grubej siatki jest zagęszczany przy przeszkodzie (i w sąsiednich blokach)
+// oraz tam, gdzie wirowość przekracza próg [1/s]
+static const float nestedVorticityThreshold = 4.0f;
+
+// Domyślna największa liczba przebiegów rzutu złożonego (gruby -> drobny) na jeden rzut kroku
+static const int nestedPressureCycles = 4;
+
+// Ciecz na dwóch zagnieżdżonych poziomach
+// Gruby poziom (Fluid size^3) pokrywa całe pudło, drobny (SparseFluid (2*size)^3) tylko bloki 8^3
+// grubej siatki przy przeszkodzie i w obszarach silnej wirowości. Poziomy liczą każdy etap kroku
+// po kolei: najpierw gruby, potem drobny, którego komórki poza blokami czytają gruby poziom
+// w tej samej roli. Na końcu kroku drobny poziom zastępuje (średnią 2x2x2) komórki grubej siatki pod sobą.
+// Bloki przy ścianach pudła nie są zagęszczane, więc drobny poziom ich nie dotyka.
+// Rzut jest złożony: w każdym przebiegu prawa strona grubego równania Poissona pod drobnym poziomem
+// to uśredniona dywergencja drobnego, ciśnienie grubego jest warunkiem Dirichleta dla drobnego,
+// a poprawiona drobna prędkość wraca do grubej przed następnym przebiegiem. Przebiegi trwają
+// (najwyżej pressureCycles), dopóki dywergencja na granicy poziomów (InterfaceDivergence) maleje.
+class NestedFluid {
+
+    public:
+        int size;
+        float dt;
+        int iter;
+        float diff;
+        float visc;
+
+        Fluid coarse;
+        SparseFluid fine;
+
+        // Zagęszczone bloki grubej siatki (siatka o boku size/8)
+        VoxelGrid refined;
+
+        // Największa liczba przebiegów rzutu złożonego, 1 -- jeden przebieg gruby -> drobny bez poprawki grubego
+        int pressureCycles;
+
+        NestedFluid(int size, float dt, int iter, float diffusion, float viscosity);
+
+        // Współrzędne grubej siatki
+        void AddDensity(int x, int y, int z, float amount);
+
+        void AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ);
+
+        // Maska drobna (2*size)^3 jest opcjonalna -- bez niej powstaje z grubej
+        bool SetObstacles(const VoxelGrid *grid, const VoxelGrid *fineGrid = nullptr);
+
+        void FluidStep();
+
+        void fadeDensity(float amount);
+
+        size_t RefinedBlocks() const { return refined.Count(); }
+
+        // Największa |div u| w komórkach po obu stronach granicy poziomów: drobnych na zewnętrznej
+        // warstwie bloków i grubych, które mają zagęszczonego sąsiada przez ścianę
+        double InterfaceDivergence() const;
+
+        size_t Bytes() const;
+
+    private:
+
+        const VoxelGrid *obstacles;
+        VoxelGrid fineObstacles;
+
+        // Tablice grubego poziomu w rolach kanałów SparseField (tło drobnego poziomu)
+        float *coarseFields[sparseFields];
+
+        void update_refinement();
+
+        // Rzut złożony na kanałach drobnego poziomu i odpowiadających im tablicach grubego
+        void project(int velX, int velY, int velZ, int p, int div);
+
+        double interface_divergence(int velX, int velY, int velZ) const;
+};
+
+#endif
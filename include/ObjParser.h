@@ -0,0 +1,23 @@
+#ifndef OBJ_PARSER_H_
+#define OBJ_PARSER_H_
+
+#include <tiny_obj_loader.h>
+
+#include <string>
+#include <vector>
+
+// Od tego rozmiaru pliku .obj parsujemy go równolegle zamiast przez tinyobj::LoadObj
+static const size_t parallelObjThreshold = 8 * 1024 * 1024;
+
+// Równoległy parser dużych plików .obj (eksporty CAD)
+// Plik jest mapowany do pamięci i dzielony na fragmenty zakończone znakiem nowej linii,
+// każdy fragment parsowany jest na osobnym wątku, a wyniki łączone w kolejności pliku.
+// Obsługiwane są tylko linie 'v', 'vn' i 'f' (wielokąty dzielone na trójkąty wachlarzem),
+// wynik trafia do tych samych struktur co z tinyobj::LoadObj.
+bool ParseObjParallel(const std::string& path, tinyobj::attrib_t& attrib,
+                      std::vector<tinyobj::index_t>& corners, std::string& err);
+
+// Szybka zamiana tekstu na float, zwraca wskaźnik za ostatnim przeczytanym znakiem
+const char* ParseObjFloat(const char* p, const char* end, float& out);
+
+#endif
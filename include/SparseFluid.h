@@ -0,0 +1,125 @@
+#ifndef SPARSE_FLUID_H_
+#define SPARSE_FLUID_H_
+
+#include "SparseGrid.h"
+#include "VoxelGrid.h"
+
+// Kafelek bloku z jedną komórką sąsiadów z każdej strony
+static const int sparseTileDim = sparseBlockDim + 2;
+static const int sparseTileCells = sparseTileDim * sparseTileDim * sparseTileDim;
+
+// Indeks komórki bloku (lx, ly, lz w [-1, 8]) w kafelku
+#define TIX(x, y, z) (((x) + 1) + ((y) + 1) * sparseTileDim + ((z) + 1) * sparseTileDim * sparseTileDim)
+
+// Pola cieczy jako kanały SparseGrid (te same role co tablice Fluid)
+enum SparseField { sfS, sfDensity, sfVx, sfVy, sfVz, sfVx0, sfVy0, sfVz0, sparseFields };
+
+// Blok jest aktywny, gdy ma barwnik lub dowolną składową prędkości powyżej progu
+static const float sparseDensityEpsilon = 1e-4f;
+static const float sparseSpeedEpsilon = 1e-3f;
+
+// Ciecz na rzadkiej siatce bloków 8^3 -- ten sam krok co Fluid (diffuse, project, advect),
+// ale każde jądro przechodzi tylko po liście aktywnych bloków.
+// Lista to bloki z barwnikiem lub ruchem poszerzone o zasięg adwekcji w danym kroku,
+// pozostałe bloki wracają do puli. Poza blokami wszystkie pola (także ciśnienie) są zerowe,
+// więc brzeg aktywnego obszaru działa jak otwarta granica; ściany siatki jak w Fluid.
+// Z tłem (SetBackground) wartości poza blokami pochodzą z grubszej siatki -- tak działa
+// drobny poziom NestedFluid.
+class SparseFluid {
+
+    public:
+        int size;
+        float dt;
+        int iter;
+        float diff;
+        float visc;
+
+        // Maska przeszkód (size^3), w pełnych komórkach prędkość jest zerowana
+        const VoxelGrid *obstacles;
+
+        SparseFluid(int size, float dt, int iter, float diffusion, float viscosity);
+
+        void AddDensity(int x, int y, int z, float amount);
+
+        void AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ);
+
+        // Maska musi mieć rozdzielczość size; przy innej zgłasza błąd, zdejmuje maskę i zwraca false
+        bool SetObstacles(const VoxelGrid *grid);
+
+        void FluidStep();
+
+        void fadeDensity(float amount);
+
+        float Density(int x, int y, int z) const;
+
+        // Gęstość jako gęsta tablica size^3 (np. do wizualizacji małych siatek)
+        void CopyDensity(float *out) const;
+
+        size_t ActiveBlocks() const { return links.size(); }
+
+        // Tło: pola grubszej siatki res^3 (res = size / ratio) w tych samych rolach co kanały,
+        // z których brane są wartości poza blokami zamiast zera
+        void SetBackground(const float *const fields[sparseFields], int res);
+
+        // Stała lista bloków zamiast odświeżania po aktywności, nowe bloki wypełniane z tła
+        void SetBlocks(const std::vector<int>& ids);
+
+        // Średnia bloków (razy scale) do komórek siatki tła (każda komórka tła pokryta blokami)
+        void Restrict(int f, float *coarse, float scale = 1.0f) const;
+
+        size_t Bytes() const;
+
+    private:
+
+        // Aktywny blok: pierwsza komórka i sloty sąsiadów przez ściany (-X, +X, -Y, +Y, -Z, +Z), -1 = brak
+        struct BlockLinks {
+            int slot;
+            int x0, y0, z0;
+            int face[6];
+        };
+
+        SparseGrid grid;
+        std::vector<BlockLinks> links;
+
+        // Indeksy w 'links' według koloru szachownicy bloków ((bx + by + bz) & 1) -- bloki jednego
+        // koloru nie mają wspólnych ścian, więc lin_solve liczy je równolegle
+        std::vector<int> colorBlocks[2];
+
+        const float *background[sparseFields];
+        int backgroundRes;
+        bool fixedBlocks;
+
+        // Znaczniki przy budowie nowej listy bloków (bez zerowania tablicy co krok)
+        std::vector<uint32_t> blockStamp;
+        uint32_t stamp;
+
+        void refreshBlocks();
+        void linkBlocks();
+
+        int activateAt(int x, int y, int z);
+
+        // Nowy blok wypełniony interpolacją tła (bez tła zostaje wyzerowany)
+        void fillFromBackground(int id);
+
+        // Blok z warstwą sąsiadów przez ściany (10^3), żeby stencil nie sprawdzał granic bloku
+        void gatherTile(int f, const BlockLinks& b, float *tile) const;
+        float sample(int f, float x, float y, float z) const;
+
+        // Tło w komórce (x, y, z) tej siatki, 0 bez tła
+        float backgroundAt(int f, int x, int y, int z) const;
+
+        friend class NestedFluid;
+
+        void set_bounds(int b, int f);
+        void apply_obstacles(int b, int f);
+        void lin_solve(int b, int x, int x0, float a, float c);
+        void diffuse(int b, int x, int x0, float diff, float dt);
+        void project(int velX, int velY, int velZ, int p, int div);
+
+        // Etapy project: prawa strona div (p wyzerowane) i odjęcie gradientu p od prędkości
+        void divergence(int velX, int velY, int velZ, int p, int div);
+        void subtract_gradient(int velX, int velY, int velZ, int p);
+        void advect(int b, int d, int d0, int velX, int velY, int velZ, float dt);
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SPARSE_GRID_H_
+#define SPARSE_GRID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Blok liścia 8^3 komórek
+static const int sparseBlockBits = 3;
+static const int sparseBlockDim = 1 << sparseBlockBits;
+static const int sparseBlockMask = sparseBlockDim - 1;
+static const int sparseBlockCells = sparseBlockDim * sparseBlockDim * sparseBlockDim;
+
+// Pula poniżej tej liczby slotów nie jest zmniejszana
+static const int sparseMinSlots = 64;
+
+// Indeks komórki wewnątrz bloku
+#define BIX(x, y, z) ((x) + ((y) << sparseBlockBits) + ((z) << (2 * sparseBlockBits)))
+
+// Rzadka siatka res^3 z blokami 8^3 alokowanymi na żądanie
+// Dwa poziomy: tablica bloków (res/8)^3 -> slot w puli, pula slotów po 512 wartości na kanał.
+// Wszystkie kanały (pola) dzielą tę samą topologię, niezaalokowane bloki mają wartość 0.
+// Zwolnione sloty wracają do puli; gdy wolnych jest więcej niż zajętych, Retain przenosi bloki
+// na początek puli i ją przycina, więc pamięć idzie za bieżącą objętością, a nie za szczytową.
+class SparseGrid {
+
+    public:
+
+        SparseGrid();
+
+        void Create(int res, int channels);
+
+        int Res() const { return mRes; }
+        int BlocksPerAxis() const { return mBlocksPerAxis; }
+        int Channels() const { return mChannels; }
+
+        int BlockId(int bx, int by, int bz) const { return bx + (by + bz * mBlocksPerAxis) * mBlocksPerAxis; }
+
+        // Slot bloku albo -1, gdy blok nie jest zaalokowany
+        int Slot(int id) const { return mTable[id]; }
+        int SlotAt(int x, int y, int z) const {
+            return mTable[BlockId(x >> sparseBlockBits, y >> sparseBlockBits, z >> sparseBlockBits)];
+        }
+
+        // Alokuje blok (wyzerowany) jeśli jeszcze go nie ma, zwraca slot
+        int Activate(int id);
+
+        // Zostawia dokładnie bloki z posortowanej listy 'ids' -- pozostałe wracają do puli
+        // Może zmienić sloty zachowanych bloków (kompaktowanie puli)
+        void Retain(const std::vector<int>& ids);
+
+        // Zaalokowane bloki (id), posortowane po Retain
+        const std::vector<int>& Blocks() const { return mBlocks; }
+
+        float* Data(int channel, int slot) { return &mData[channel][size_t(slot) * sparseBlockCells]; }
+        const float* Data(int channel, int slot) const { return &mData[channel][size_t(slot) * sparseBlockCells]; }
+
+        // Wartość komórki, 0 poza zaalokowanymi blokami i poza siatką
+        float Get(int channel, int x, int y, int z) const;
+
+        // Tablica bloków + pula slotów wszystkich kanałów
+        size_t Bytes() const;
+
+    private:
+
+        void compact();
+
+        int mRes;
+        int mBlocksPerAxis;
+        int mChannels;
+
+        std::vector<int32_t> mTable;
+        std::vector<std::vector<float>> mData;
+
+        std::vector<int> mFreeSlots;
+        std::vector<int> mBlocks;
+        int mSlotCount;
+};
+
+#endif
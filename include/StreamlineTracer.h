@@ -0,0 +1,61 @@
+#ifndef STREAMLINE_TRACER_H_
+#define STREAMLINE_TRACER_H_
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// Liczba linii całkowanych razem (układ SoA, pętle po pasach wektoryzowane przez kompilator)
+static const int tracerLanes = 8;
+
+// Linie prądu pola prędkości (RK4, interpolacja trójliniowa Vx/Vy/Vz)
+// Ziarna trzymane są w układzie SoA, linie liczone równolegle paczkami po tracerLanes.
+// Każda linia ma stałe miejsce na maxPoints punktów w jednym buforze przydzielonym w Create,
+// całość rysowana jest jednym glMultiDrawArrays(GL_LINE_STRIP) shaderem linii.
+class StreamlineTracer {
+
+    public:
+
+        StreamlineTracer();
+        ~StreamlineTracer();
+
+        StreamlineTracer(const StreamlineTracer&) = delete;
+        StreamlineTracer& operator=(const StreamlineTracer&) = delete;
+
+        // Wymaga kontekstu OpenGL; N -- rozmiar siatki cieczy, punkt i leży w origin + i * cellSize
+        bool Create(int N, int seedCount, int maxPoints, float cellSize, const glm::vec3& origin);
+        void Destroy();
+
+        // Losowe ziarna w prostopadłościanie [lo, hi] (współrzędne siatki)
+        void SeedBox(const glm::vec3& lo, const glm::vec3& hi, unsigned rngSeed);
+
+        // Całkowanie wszystkich linii z krokiem 'step' (w komórkach siatki) i wysłanie na GPU
+        void Trace(const float* vx, const float* vy, const float* vz, float step);
+
+        void Draw() const;
+
+        int SeedCount() const { return static_cast<int>(mSeedX.size()); }
+        size_t PointCount() const { return mPointCount; }
+
+    private:
+
+        void traceBatch(int first, const float* vx, const float* vy, const float* vz, float step);
+
+        int mRes;
+        int mMaxPoints;
+        float mCellSize;
+        glm::vec3 mOrigin;
+
+        std::vector<float> mSeedX, mSeedY, mSeedZ;
+
+        // Punkty linii (świat), linia i zaczyna się od punktu i * mMaxPoints
+        std::vector<float> mPoints;
+        std::vector<GLint> mFirsts;
+        std::vector<GLsizei> mCounts;
+        size_t mPointCount;
+
+        GLuint mVAO, mVBO;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Stała pula wątków roboczych dla pętli równoległych
+// Wątek wywołujący ParallelFor również wykonuje pracę
+class ThreadPool {
+
+    public:
+
+        static ThreadPool& Instance() {
+            static ThreadPool sInstance;
+            return sInstance;
+        }
+
+    private:
+
+        std::vector<std::thread> mWorkers;
+
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mDone;
+
+        // Tylko jedno zadanie naraz, pozostałe wywołania wykonują się szeregowo
+        std::mutex mSubmit;
+
+        const std::function<void(int, int)>* mBody;
+        int mEnd;
+        int mGrain;
+        std::atomic<int> mNext;
+
+        int mActive;
+        uint64_t mGeneration;
+        bool mStop;
+
+    public:
+
+        // Liczba wątków biorących udział w ParallelFor (workery + wątek wywołujący)
+        int ThreadCount() const;
+
+        // Wywołuje body(b, e) dla rozłącznych podzakresów [begin, end) po 'grain' elementów
+        // grain <= 0 -- dobierany automatycznie
+        void ParallelFor(int begin, int end, const std::function<void(int, int)>& body, int grain = 0);
+
+    private:
+
+        void workerLoop();
+        void runChunks();
+
+        ThreadPool();
+        ~ThreadPool();
+};
+
+#endif
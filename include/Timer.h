@@ -3,6 +3,48 @@
 
 #include "main.h"
 
+#include <memory>
+#include <mutex>
+
+// Liczba ostatnich próbek, z których liczone są średnia, percentyle i maksimum
+static const int timingWindow = 512;
+
+// Histogram w przedziałach potęg dwójki: [0] < 1 us, [b] = [2^(b-1), 2^b) us
+static const int timingBuckets = 32;
+
+// Podsumowanie okna pomiarów (w milisekundach)
+struct TimingSummary {
+    uint64_t count;     // wszystkie próbki od startu
+    double mean;
+    double p50, p95, p99;
+    double max;
+};
+
+// Pomiary czasu jednej sekcji (klatka, krok cieczy, renderowanie, ...)
+// Zapis może przychodzić z innego wątku niż odczyt, więc dostęp chroni mutex
+class TimingStats {
+
+    public:
+
+        TimingStats();
+
+        void Record(uint64_t ns);
+
+        TimingSummary Summary() const;
+
+        // Histogram od startu programu
+        void Histogram(uint64_t out[timingBuckets]) const;
+
+    private:
+
+        mutable std::mutex mMutex;
+
+        uint64_t mSamples[timingWindow];
+        int mNext;
+        uint64_t mCount;
+        uint64_t mHistogram[timingBuckets];
+};
+
 class Timer {
 
     public:
@@ -12,6 +54,19 @@ class Timer {
             return sInstance;
         }
 
+        // Sekcja mierzona w bieżącym zakresie (RAII)
+        class Scope {
+            public:
+                Scope(int section) : mSection(section), mStart(Timer::Instance().Now()) {}
+                ~Scope() { Timer::Instance().Record(mSection, Timer::Instance().Now() - mStart); }
+            private:
+                int mSection;
+                Uint64 mStart;
+        };
+
+        // Sekcja czasu klatki (rejestrowana przez Update)
+        static const int frameSection = 0;
+
     private:
 
         Uint64 mStartTicks;
@@ -22,6 +77,9 @@ class Timer {
 
         double mTimeScale;
 
+        std::vector<std::string> mSectionNames;
+        std::vector<std::unique_ptr<TimingStats>> mSections;
+
     public: 
 
         void Reset();
@@ -34,6 +92,19 @@ class Timer {
 
         void Update();
 
+        // Zegar w nanosekundach (SDL_GetTicksNS)
+        Uint64 Now() const;
+
+        // Rejestracja sekcji pomiarowej -- zwraca identyfikator do Record/Scope
+        int AddSection(const std::string& name);
+
+        void Record(int section, Uint64 ns);
+
+        TimingSummary Summary(int section) const;
+
+        // Tabela wszystkich sekcji (średnia, percentyle, maksimum) i histogramy
+        void Report(std::ostream& out) const;
+
     private:
 
         Timer();
@@ -41,4 +112,4 @@ class Timer {
 
 };
 
-#endif
\ No newline at end of file
+#endif
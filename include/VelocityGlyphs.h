@@ -0,0 +1,58 @@
+#ifndef VELOCITY_GLYPHS_H_
+#define VELOCITY_GLYPHS_H_
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// Dane jednej strzałki w buforze instancji (upakowane, 28 bajtów)
+struct GlyphInstance {
+    float position[3];
+    float direction[3];   // znormalizowany
+    float magnitude;
+};
+
+// Strzałki pola prędkości rysowane instancjonowaniem
+// Co klatkę Vx/Vy/Vz są próbkowane (równolegle) na rzadszej siatce co 'stride' punktów
+// do jednego bufora instancji, a wszystkie strzałki rysowane są jednym glDrawArraysInstanced.
+// Geometria strzałki (linie wzdłuż +X) jest obracana i skalowana w shaderze.
+class VelocityGlyphs {
+
+    public:
+
+        VelocityGlyphs();
+        ~VelocityGlyphs();
+
+        VelocityGlyphs(const VelocityGlyphs&) = delete;
+        VelocityGlyphs& operator=(const VelocityGlyphs&) = delete;
+
+        // Wymaga kontekstu OpenGL; N -- rozmiar siatki cieczy, punkt i leży w origin + i * cellSize
+        bool Create(int N, int stride, float cellSize, const glm::vec3& origin);
+        void Destroy();
+
+        // Próbkowanie prędkości i wysłanie bufora instancji
+        void Update(const float* vx, const float* vy, const float* vz);
+
+        void Draw() const;
+
+        GLsizei InstanceCount() const { return static_cast<GLsizei>(mInstances.size()); }
+
+        // Największy moduł prędkości z ostatniego Update (do skalowania długości w shaderze)
+        float MaxMagnitude() const { return mMaxMagnitude; }
+
+    private:
+
+        int mRes;
+        int mStride;
+        int mPerAxis;
+
+        GLuint mVAO, mArrowVBO, mInstanceVBO;
+        GLsizei mArrowVertices;
+
+        std::vector<GlyphInstance> mInstances;
+        std::vector<float> mPlaneMax;   // największy moduł w każdej płaszczyźnie z siatki strzałek
+        float mMaxMagnitude;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef VOLUME_TEXTURE_H_
+#define VOLUME_TEXTURE_H_
+
+#include "glad/glad.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Liczba buforów PBO w pierścieniu -- kopiowanie do jednego trwa, gdy GPU czyta poprzednie
+static const int volumePboCount = 3;
+
+// Pole skalarne N^3 (np. Fluid::density) jako tekstura 3D R16F lub R8
+// Wartości są dzielone przez maxValue (R8 dodatkowo obcinane do [0, 1]).
+// Co klatkę pole jest kwantyzowane i porównywane płaszczyznami z kopią ostatnio wysłanej
+// zawartości; na GPU trafiają tylko zmienione płaszczyzny z (w ciągłych zakresach)
+// przez kolejny bufor PBO z pierścienia, chroniony fence'em przed nadpisaniem.
+// Działa na OpenGL 3.3 core, w tym na programowym Mesa (llvmpipe/softpipe).
+class VolumeTexture {
+
+    public:
+
+        VolumeTexture();
+        ~VolumeTexture();
+
+        VolumeTexture(const VolumeTexture&) = delete;
+        VolumeTexture& operator=(const VolumeTexture&) = delete;
+
+        // Wymaga kontekstu OpenGL
+        bool Create(int N, bool halfFloat, float maxValue);
+        void Destroy();
+
+        // Zwraca liczbę wysłanych płaszczyzn z
+        int Update(const float* field);
+
+        void Bind(GLenum unit) const;
+
+        int Res() const { return mRes; }
+
+    private:
+
+        void quantizePlane(const float* src, uint8_t* dst) const;
+
+        int mRes;
+        bool mHalfFloat;
+        float mInvMax;
+        size_t mPlaneBytes;
+
+        GLuint mTexture;
+        GLuint mPBOs[volumePboCount];
+        GLsync mFences[volumePboCount];
+        int mNextPBO;
+
+        // Zawartość tekstury po ostatnim wysłaniu i nowe dane (zamieniane po porównaniu)
+        std::vector<uint8_t> mUploaded;
+        std::vector<uint8_t> mStaging;
+        std::vector<uint8_t> mChanged;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef VOXEL_CHUNK_MESH_H_
+#define VOXEL_CHUNK_MESH_H_
+
+#include "VoxelMesh.h"
+
+#include "glad/glad.h"
+
+// Rozmiar fragmentu siatki voxeli (komórki na oś)
+static const int voxelChunkSize = 16;
+
+// Siatka voxeli podzielona na fragmenty 16^3 z flagami zmian
+// Po zmianie komórek przebudowywane są tylko brudne fragmenty, a ich wierzchołki
+// trafiają przez glBufferSubData do jednego stałego bufora (pula bloków o rozmiarach 2^k).
+// Całość rysowana jest jednym glMultiDrawArrays.
+class VoxelChunkMesh {
+
+    public:
+
+        VoxelChunkMesh();
+        ~VoxelChunkMesh();
+
+        VoxelChunkMesh(const VoxelChunkMesh&) = delete;
+        VoxelChunkMesh& operator=(const VoxelChunkMesh&) = delete;
+
+        // Wymaga kontekstu OpenGL
+        bool Create(int res, float scale, const glm::vec3& offset);
+        void Destroy();
+
+        // Zmieniona komórka -- jej fragment i fragmenty sąsiadów, których ściany mogły się zmienić
+        void MarkDirty(int x, int y, int z);
+        void MarkAllDirty();
+
+        // Oznacza fragmenty komórek różniących się między dwiema siatkami (porównanie słowami)
+        void MarkChanged(const VoxelGrid& before, const VoxelGrid& after);
+
+        // Przebudowa brudnych fragmentów (równolegle) i wysłanie ich na GPU
+        // Zwraca liczbę przebudowanych fragmentów
+        int Update(const VoxelGrid& grid);
+
+        void Draw() const;
+
+        size_t VertexCount() const { return mVertexCount; }
+
+    private:
+
+        struct Chunk {
+            GLint first;
+            GLsizei count;
+            int sizeClass;  // -1 = brak bloku w buforze
+            bool dirty;
+        };
+
+        GLint allocate(int sizeClass);
+        void release(Chunk& chunk);
+        void grow(GLsizei minCapacity);
+
+        int mRes;
+        int mChunksPerAxis;
+        float mScale;
+        glm::vec3 mOffset;
+
+        GLuint mVAO, mVBO;
+        GLsizei mCapacity;   // w wierzchołkach
+        GLsizei mUsed;
+
+        std::vector<Chunk> mChunks;
+        std::vector<std::vector<GLint>> mFreeBlocks;  // wolne bloki dla każdej klasy 2^k
+        bool mAnyDirty;
+
+        // Listy dla glMultiDrawArrays
+        std::vector<GLint> mFirsts;
+        std::vector<GLsizei> mCounts;
+        size_t mVertexCount;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef VOXEL_GRID_H_
+#define VOXEL_GRID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kierunki ścian komórki w kolejności: +X, -X, +Y, -Y, +Z, -Z
+static const int voxelFaceDirs = 6;
+
+// Upakowana bitowo siatka zajętości res^3
+// Każdy wiersz (y, z) to ciąg słów 64-bitowych wzdłuż osi X (bit x % 64 słowa x / 64),
+// więc sąsiedztwo całego wiersza liczy się kilkoma przesunięciami i operacjami AND.
+// Bity za końcem wiersza (x >= res) są zawsze zerowe.
+// 512^3 = 8 słów * 512 * 512 wierszy = 16 MB
+class VoxelGrid {
+
+    public:
+
+        VoxelGrid();
+        explicit VoxelGrid(int res);
+
+        void Resize(int res);
+        void Clear();
+        void Fill();
+
+        int Res() const { return mRes; }
+        int WordsPerRow() const { return mWords; }
+        size_t Bytes() const { return mBits.size() * sizeof(uint64_t); }
+
+        bool Get(int x, int y, int z) const {
+            return (Row(y, z)[x >> 6] >> (x & 63)) & 1;
+        }
+
+        void Set(int x, int y, int z, bool solid) {
+            uint64_t bit = uint64_t(1) << (x & 63);
+            uint64_t& word = Row(y, z)[x >> 6];
+            word = solid ? (word | bit) : (word & ~bit);
+        }
+
+        const uint64_t* Row(int y, int z) const { return &mBits[(size_t(z) * mRes + y) * mWords]; }
+        uint64_t* Row(int y, int z) { return &mBits[(size_t(z) * mRes + y) * mWords]; }
+
+        // Bity komórek wiersza (y, z), których ściana w kierunku 'dir' jest widoczna
+        // (komórka pełna, sąsiad pusty lub poza siatką); out ma WordsPerRow() słów
+        void FaceRow(int dir, int y, int z, uint64_t* out) const;
+
+        // Liczba pełnych komórek
+        size_t Count() const;
+
+    private:
+
+        int mRes;
+        int mWords;
+        std::vector<uint64_t> mBits;
+};
+
+#endif
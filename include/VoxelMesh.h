@@ -0,0 +1,24 @@
+#ifndef VOXEL_MESH_H_
+#define VOXEL_MESH_H_
+
+#include "VoxelGrid.h"
+
+#include "glm/glm.hpp"
+
+#include <vector>
+
+// Greedy meshing siatki voxeli
+// Widoczne ściany leżące w jednej płaszczyźnie są łączone w możliwie duże prostokąty,
+// każdy prostokąt to 2 trójkąty (6 wierzchołków xyz) zamiast 2 trójkątów na każdą ścianę komórki.
+// Maski widocznych ścian liczone są całymi słowami 64-bitowymi z VoxelGrid,
+// a warstwy (6 kierunków x res przekrojów) budowane są równolegle.
+//
+// Wierzchołek w punkcie siatki p trafia do out jako p * scale - offset
+void GreedyMeshVoxels(const VoxelGrid& grid, float scale, const glm::vec3& offset, std::vector<float>& out);
+
+// To samo dla ścian komórek z prostopadłościanu [lo, hi) (jeden wątek, np. fragment siatki)
+// Widoczność ścian na granicy sprawdzana jest względem sąsiadów spoza obszaru
+void GreedyMeshRegion(const VoxelGrid& grid, const glm::ivec3& lo, const glm::ivec3& hi,
+                      float scale, const glm::vec3& offset, std::vector<float>& out);
+
+#endif
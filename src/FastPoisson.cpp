@@ -0,0 +1,200 @@
+#include "FastPoisson.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+
+// Mnożenie bez obsługi inf/nan z operatora std::complex (który wywołuje __muldc3)
+static inline std::complex<double> mul(const std::complex<double>& a, const std::complex<double>& b) {
+    return std::complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+FastPoisson::FastPoisson() {
+    mSize = 0;
+}
+
+void FastPoisson::Create(int n) {
+    mSize = n;
+    mData.assign(size_t(n) * n * n, 0.0);
+
+    // Najpierw czwórki i dwójki, potem nieparzyste czynniki pierwsze (ostatni może być duży)
+    mFactors.clear();
+    int rest = n;
+    while (rest % 4 == 0) { mFactors.push_back(4); rest /= 4; }
+    while (rest % 2 == 0) { mFactors.push_back(2); rest /= 2; }
+    for (int p = 3; p * p <= rest; p += 2)
+        while (rest % p == 0) { mFactors.push_back(p); rest /= p; }
+    if (rest > 1) mFactors.push_back(rest);
+
+    const double pi = 3.14159265358979323846;
+    mRoots.resize(n);
+    mShift.resize(n);
+    mEigen.resize(n);
+    for (int k = 0; k < n; k++) {
+        mRoots[k] = std::polar(1.0, 2.0 * pi * k / n);
+        mShift[k] = std::polar(1.0, -pi * k / (2.0 * n));
+        mEigen[k] = 2.0 - 2.0 * std::cos(pi * k / n);
+    }
+}
+
+void FastPoisson::fft(const Complex *in, Complex *out, int n, int stride, int factor, int sign, Complex *scratch) const {
+    if (n == 1) {
+        out[0] = in[0];
+        return;
+    }
+
+    int p = mFactors[factor];
+    int m = n / p;
+
+    // p podciągów co p-ty element, każdy transformowany rekurencyjnie do out[q * m ...]
+    for (int q = 0; q < p; q++)
+        fft(in + q * stride, out + q * m, m, stride * p, factor + 1, sign, scratch);
+
+    // Motylki: t_q = w_n^(q k) Y_q[k], potem p-punktowa DFT: X[k + r m] = sum_q t_q w_p^(q r)
+    int step = mSize / n;
+    Complex *t = scratch;
+    for (int k = 0; k < m; k++) {
+        Complex base = mRoots[size_t(k) * step];
+        if (sign < 0) base = std::conj(base);
+
+        t[0] = out[k];
+        Complex w = base;
+        for (int q = 1; q < p; q++) {
+            t[q] = mul(out[q * m + k], w);
+            w = mul(w, base);
+        }
+
+        if (p == 2) {
+            out[k] = t[0] + t[1];
+            out[k + m] = t[0] - t[1];
+        }
+        else if (p == 4) {
+            // w_4 = +-i, mnożenie przez nie to zamiana części
+            Complex a0 = t[0] + t[2], a1 = t[0] - t[2], a2 = t[1] + t[3], d = t[1] - t[3];
+            Complex a3 = sign < 0 ? Complex(d.imag(), -d.real()) : Complex(-d.imag(), d.real());
+            out[k] = a0 + a2;
+            out[k + m] = a1 + a3;
+            out[k + 2 * m] = a0 - a2;
+            out[k + 3 * m] = a1 - a3;
+        }
+        else {
+            // Wykładnik q r mod p narasta o r, bez dzielenia
+            int rootStep = mSize / p;
+            for (int r = 0; r < p; r++) {
+                Complex sum = t[0];
+                for (int q = 1, e = r; q < p; q++, e = e + r >= p ? e + r - p : e + r) {
+                    const Complex& root = mRoots[size_t(e) * rootStep];
+                    sum += mul(t[q], sign < 0 ? std::conj(root) : root);
+                }
+                out[k + r * m] = sum;
+            }
+        }
+    }
+}
+
+// DCT-II (Makhoul) dwóch linii naraz: a i b jako część rzeczywista i urojona jednego FFT,
+// rozdzielane z symetrii hermitowskiej. Parzyste próbki w przód, nieparzyste od końca, przesunięcie fazy.
+void FastPoisson::dct(double *a, double *b, Complex *work, Complex *scratch) const {
+    int n = mSize;
+    Complex *v = work, *V = work + n;
+
+    for (int k = 0; 2 * k < n; k++) v[k] = Complex(a[2 * k], b[2 * k]);
+    for (int k = 0; 2 * k + 1 < n; k++) v[n - 1 - k] = Complex(a[2 * k + 1], b[2 * k + 1]);
+
+    fft(v, V, n, 1, 0, -1, scratch);
+
+    for (int k = 0; k < n; k++) {
+        Complex z = V[k], zc = std::conj(V[k == 0 ? 0 : n - k]);
+        Complex va = 0.5 * (z + zc), vb = 0.5 * (z - zc);
+        a[k] = mul(mShift[k], va).real();
+        b[k] = mul(mShift[k], Complex(vb.imag(), -vb.real())).real();
+    }
+}
+
+// Odwrotność dct(): V_k = exp(i pi k / 2n) (X_k - i X_(n-k)) dla obu linii, jedno odwrotne FFT
+// z V_a + i V_b (wyniki obu są rzeczywiste), 1/n i odwrócenie permutacji
+void FastPoisson::idct(double *a, double *b, Complex *work, Complex *scratch) const {
+    int n = mSize;
+    Complex *V = work, *v = work + n;
+
+    V[0] = Complex(a[0], b[0]);
+    for (int k = 1; k < n; k++) {
+        Complex va = mul(std::conj(mShift[k]), Complex(a[k], -a[n - k]));
+        Complex vb = mul(std::conj(mShift[k]), Complex(b[k], -b[n - k]));
+        V[k] = Complex(va.real() - vb.imag(), va.imag() + vb.real());
+    }
+
+    fft(V, v, n, 1, 0, 1, scratch);
+
+    double scale = 1.0 / n;
+    for (int k = 0; 2 * k < n; k++) {
+        a[2 * k] = v[k].real() * scale;
+        b[2 * k] = v[k].imag() * scale;
+    }
+    for (int k = 0; 2 * k + 1 < n; k++) {
+        a[2 * k + 1] = v[n - 1 - k].real() * scale;
+        b[2 * k + 1] = v[n - 1 - k].imag() * scale;
+    }
+}
+
+void FastPoisson::transformAxis(int stride, bool inverse) {
+    int n = mSize;
+    size_t plane = size_t(n) * n;
+
+    // Linia o początku 'base' i kroku 'stride'; numeracja linii zależy od osi
+    auto lineBase = [&](int l) {
+        int a = l % n, b = l / n;
+        return stride == 1 ? size_t(b) * plane + size_t(a) * n
+             : stride == n ? size_t(b) * plane + a
+             : size_t(b) * n + a;
+    };
+
+    // Pary linii; przy nieparzystej liczbie druga linia ostatniej pary to zera
+    int pairs = (n * n + 1) / 2;
+    ThreadPool::Instance().ParallelFor(0, pairs, [&](int begin, int end) {
+        std::vector<double> first(n), second(n);
+        std::vector<Complex> work(2 * n), scratch(n);
+
+        for (int pair = begin; pair < end; pair++) {
+            int l = 2 * pair;
+            bool both = l + 1 < n * n;
+            size_t baseA = lineBase(l), baseB = both ? lineBase(l + 1) : 0;
+
+            for (int i = 0; i < n; i++) {
+                first[i] = mData[baseA + size_t(i) * stride];
+                second[i] = both ? mData[baseB + size_t(i) * stride] : 0.0;
+            }
+
+            if (inverse) idct(first.data(), second.data(), work.data(), scratch.data());
+            else dct(first.data(), second.data(), work.data(), scratch.data());
+
+            for (int i = 0; i < n; i++) {
+                mData[baseA + size_t(i) * stride] = first[i];
+                if (both) mData[baseB + size_t(i) * stride] = second[i];
+            }
+        }
+    });
+}
+
+void FastPoisson::Solve() {
+    int n = mSize;
+    if (n <= 0) return;
+
+    transformAxis(1, false);
+    transformAxis(n, false);
+    transformAxis(n * n, false);
+
+    // Składowa stała jest dowolna (macierz osobliwa przy Neumannie) -- zero
+    ThreadPool::Instance().ParallelFor(0, n, [&](int begin, int end) {
+        for (int k = begin; k < end; k++)
+            for (int j = 0; j < n; j++)
+                for (int i = 0; i < n; i++) {
+                    double lambda = mEigen[i] + mEigen[j] + mEigen[k];
+                    size_t index = (size_t(k) * n + j) * n + i;
+                    mData[index] = lambda > 0.0 ? mData[index] / lambda : 0.0;
+                }
+    });
+
+    transformAxis(n * n, true);
+    transformAxis(n, true);
+    transformAxis(1, true);
+}
@@ -1,28 +1,150 @@
 #include "Fluid.h"
+#include "FluidStencil.h"
+#include "ThreadPool.h"
 
-Fluid::Fluid(int size, float dt, int iter, float diffusion, float viscosity) {
+#include <algorithm>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLUID_X86 1
+#endif
+
+// Konwersja wiersza pola 16-bitowego -- dla float wsadowo (F16C), dla pozostałych typów element po elemencie
+template <typename H, typename Real>
+static void loadArray(const H *src, Real *dst, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] = LoadField(src[i]);
+}
+
+template <typename H, typename Real>
+static void storeArray(const Real *src, H *dst, size_t count) {
+    for (size_t i = 0; i < count; i++) StoreField(dst[i], src[i]);
+}
+
+static void loadArray(const half_t *src, float *dst, size_t count) { HalfToFloatArray(src, dst, count); }
+static void loadArray(const bfloat16_t *src, float *dst, size_t count) { BFloat16ToFloatArray(src, dst, count); }
+static void storeArray(const float *src, half_t *dst, size_t count) { FloatToHalfArray(src, dst, count); }
+static void storeArray(const float *src, bfloat16_t *dst, size_t count) { FloatToBFloat16Array(src, dst, count); }
+
+// Odcinek interpolate_row (do 8 komórek) w jednym rejestrze AVX2: współrzędne, wagi i indeksy
+// wektorowo, osiem narożników przez gather. Działania w tej samej kolejności co w wersji skalarnej
+// (bez FMA), więc wynik jest ten sam. Zwraca false bez AVX2 albo dla pól innych niż float.
+template <typename F, typename Real>
+static bool interpolateRowSIMD(const F *, int, int, int, int, int, const Real *, const Real *, const Real *,
+                               Real, Real *, Real *, Real *) {
+    return false;
+}
+
+#if FLUID_X86
+
+__attribute__((target("avx2")))
+static void interpolateRowAVX2(const float *f, int N, int j, int k, int begin, int count, const float *u, const float *v,
+                               const float *w, float dtN, float *out, float *lo, float *hi) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lane);
+    const __m256 low = _mm256_set1_ps(0.5f), high = _mm256_set1_ps(float(N - 1.5));
+    const __m256 dt = _mm256_set1_ps(dtN);
+
+    // Komórki poza odcinkiem dostają prędkość 0, więc ich indeksy też leżą w siatce
+    __m256 x = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(begin), lane)), _mm256_mul_ps(dt, _mm256_maskload_ps(u, mask)));
+    __m256 y = _mm256_sub_ps(_mm256_set1_ps(float(j)), _mm256_mul_ps(dt, _mm256_maskload_ps(v, mask)));
+    __m256 z = _mm256_sub_ps(_mm256_set1_ps(float(k)), _mm256_mul_ps(dt, _mm256_maskload_ps(w, mask)));
+    x = _mm256_min_ps(_mm256_max_ps(x, low), high);
+    y = _mm256_min_ps(_mm256_max_ps(y, low), high);
+    z = _mm256_min_ps(_mm256_max_ps(z, low), high);
+
+    __m256i i0 = _mm256_cvttps_epi32(x), j0 = _mm256_cvttps_epi32(y), k0 = _mm256_cvttps_epi32(z);
+    __m256 sx = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i0));
+    __m256 sy = _mm256_sub_ps(y, _mm256_cvtepi32_ps(j0));
+    __m256 sz = _mm256_sub_ps(z, _mm256_cvtepi32_ps(k0));
+    __m256i base = _mm256_add_epi32(i0, _mm256_add_epi32(_mm256_mullo_epi32(j0, _mm256_set1_epi32(N)),
+                                                         _mm256_mullo_epi32(k0, _mm256_set1_epi32(N * N))));
+
+    __m256 c000 = _mm256_i32gather_ps(f, base, 4),             c100 = _mm256_i32gather_ps(f + 1, base, 4);
+    __m256 c010 = _mm256_i32gather_ps(f + N, base, 4),         c110 = _mm256_i32gather_ps(f + N + 1, base, 4);
+    __m256 c001 = _mm256_i32gather_ps(f + N*N, base, 4),       c101 = _mm256_i32gather_ps(f + N*N + 1, base, 4);
+    __m256 c011 = _mm256_i32gather_ps(f + N*N + N, base, 4),   c111 = _mm256_i32gather_ps(f + N*N + N + 1, base, 4);
+
+    __m256 x00 = _mm256_add_ps(c000, _mm256_mul_ps(sx, _mm256_sub_ps(c100, c000)));
+    __m256 x10 = _mm256_add_ps(c010, _mm256_mul_ps(sx, _mm256_sub_ps(c110, c010)));
+    __m256 x01 = _mm256_add_ps(c001, _mm256_mul_ps(sx, _mm256_sub_ps(c101, c001)));
+    __m256 x11 = _mm256_add_ps(c011, _mm256_mul_ps(sx, _mm256_sub_ps(c111, c011)));
+    __m256 y0 = _mm256_add_ps(x00, _mm256_mul_ps(sy, _mm256_sub_ps(x10, x00)));
+    __m256 y1 = _mm256_add_ps(x01, _mm256_mul_ps(sy, _mm256_sub_ps(x11, x01)));
+    _mm256_maskstore_ps(out, mask, _mm256_add_ps(y0, _mm256_mul_ps(sz, _mm256_sub_ps(y1, y0))));
+
+    // min_ps(b, a) / max_ps(b, a) wybierają przy równych wartościach to samo co std::min(a, b) / std::max(a, b)
+    if (lo) {
+        __m256 lo0 = _mm256_min_ps(_mm256_min_ps(c110, c010), _mm256_min_ps(c100, c000));
+        __m256 lo1 = _mm256_min_ps(_mm256_min_ps(c111, c011), _mm256_min_ps(c101, c001));
+        __m256 hi0 = _mm256_max_ps(_mm256_max_ps(c110, c010), _mm256_max_ps(c100, c000));
+        __m256 hi1 = _mm256_max_ps(_mm256_max_ps(c111, c011), _mm256_max_ps(c101, c001));
+        _mm256_maskstore_ps(lo, mask, _mm256_min_ps(lo1, lo0));
+        _mm256_maskstore_ps(hi, mask, _mm256_max_ps(hi1, hi0));
+    }
+}
+
+static bool hasAVX2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+static bool interpolateRowSIMD(const float *f, int N, int j, int k, int begin, int count, const float *u, const float *v,
+                               const float *w, float dtN, float *out, float *lo, float *hi) {
+    if (!hasAVX2()) return false;
+    interpolateRowAVX2(f, N, j, k, begin, count, u, v, w, dtN, out, lo, hi);
+    return true;
+}
+
+#endif
+
+template <typename Real>
+FluidSolver<Real>::FluidSolver(int size, float dt, int iter, float diffusion, float viscosity, FieldStorage storage, FluidLayout layout) {
     int N = size;
-    
+
     this->size = size;
     this->dt = dt;
     this->iter = iter;
     this->diff = diffusion;
     this->visc = viscosity;
-    
+    this->storage = storage;
+    this->layout = layout;
+    this->advection = advectSemiLagrangian;
+    this->vorticity = 0.0f;
+    this->pressure = pressureAuto;
+    this->skipQuiet = false;
+
     int total_size = N * N * N;
-    this->s = new float[total_size];
-    this->density = new float[total_size];
-    
-    this->Vx = new float[total_size];
-    this->Vy = new float[total_size];
-    this->Vz = new float[total_size];
-    
-    this->Vx0 = new float[total_size];
-    this->Vy0 = new float[total_size];
-    this->Vz0 = new float[total_size];
-}
-
-Fluid::~Fluid() {
+    this->s = new Real[total_size]();
+    this->density = new Real[total_size]();
+
+    this->Vx = new Real[total_size]();
+    this->Vy = new Real[total_size]();
+    this->Vz = new Real[total_size]();
+
+    this->Vx0 = this->Vy0 = this->Vz0 = nullptr;
+    this->Vx016 = this->Vy016 = this->Vz016 = nullptr;
+
+    // Zero jest zerem również w half i bfloat16
+    if (storage == storageFloat) {
+        this->Vx0 = new Real[total_size]();
+        this->Vy0 = new Real[total_size]();
+        this->Vz0 = new Real[total_size]();
+    }
+    else {
+        this->Vx016 = new uint16_t[total_size]();
+        this->Vy016 = new uint16_t[total_size]();
+        this->Vz016 = new uint16_t[total_size]();
+    }
+
+    this->obstacles = nullptr;
+    this->scratch = nullptr;
+}
+
+template <typename Real>
+FluidSolver<Real>::~FluidSolver() {
     delete[] s;
     delete[] density;
 
@@ -33,72 +155,200 @@ Fluid::~Fluid() {
     delete[] Vx0;
     delete[] Vy0;
     delete[] Vz0;
+
+    delete[] Vx016;
+    delete[] Vy016;
+    delete[] Vz016;
+
+    delete[] scratch;
+}
+
+template <typename Real>
+bool FluidSolver<Real>::SetObstacles(const VoxelGrid *grid) {
+    // Maska musi mieć tę samą rozdzielczość co siatka cieczy
+    if (grid && grid->Res() != this->size) {
+        std::cerr << "[ERROR] Maska przeszkód " << grid->Res() << "^3 nie pasuje do siatki cieczy "
+                  << this->size << "^3" << std::endl;
+        this->obstacles = nullptr;
+        return false;
+    }
+
+    this->obstacles = grid;
+    return true;
 }
 
-void Fluid::set_bounds(int b, float *x) {
+// Zerowanie prędkości w komórkach przeszkód, przechodzimy tylko po niezerowych słowach maski
+template <typename Real>
+template <typename T>
+void FluidSolver<Real>::apply_obstacles(int b, T *x) {
+    if (!this->obstacles || b == 0) return;
+
     int N = this->size;
+    int words = this->obstacles->WordsPerRow();
+
+    // W układzie MAC pełna komórka blokuje obie swoje ścianki wzdłuż osi b
+    bool mac = this->layout == layoutMAC;
+    int stride = b == 1 ? 1 : (b == 2 ? N : N * N);
+
+    for (int k = 0; k < N; k++) {
+        for (int j = 0; j < N; j++) {
+            const uint64_t *row = this->obstacles->Row(j, k);
+            for (int w = 0; w < words; w++) {
+                uint64_t bits = row[w];
+                while (bits) {
+                    int i = (w << 6) + __builtin_ctzll(bits);
+                    StoreField(x[IX(i, j, k)], 0.0f);
+                    if (mac && (b == 1 ? i : (b == 2 ? j : k)) + 1 < N) StoreField(x[IX(i, j, k) + stride], 0.0f);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+}
+
+template <typename Real>
+template <typename T>
+void FluidSolver<Real>::set_bounds(int b, T *x) {
+    int N = this->size;
+
+    // Odbicie komórki brzegowej z sąsiada wewnątrz (ze zmianą znaku dla składowej normalnej)
+    auto mirror = [&](int to, int from, bool flip) {
+        auto v = LoadField(x[from]);
+        StoreField(x[to], flip ? -v : v);
+    };
+    auto corner = [&](int to, int p, int q, int r) {
+        StoreField(x[to], CornerCell<Real>(LoadField(x[p]), LoadField(x[q]), LoadField(x[r])));
+    };
+
     for(int j = 1; j < N - 1; j++) {
         for(int i = 1; i < N - 1; i++) {
-            x[IX(i, j, 0  )] = b == 3 ? -x[IX(i, j, 1  )] : x[IX(i, j, 1  )];
-            x[IX(i, j, N-1)] = b == 3 ? -x[IX(i, j, N-2)] : x[IX(i, j, N-2)];
+            mirror(IX(i, j, 0  ), IX(i, j, 1  ), b == 3);
+            mirror(IX(i, j, N-1), IX(i, j, N-2), b == 3);
         }
     }
     for(int k = 1; k < N - 1; k++) {
         for(int i = 1; i < N - 1; i++) {
-            x[IX(i, 0  , k)] = b == 2 ? -x[IX(i, 1  , k)] : x[IX(i, 1  , k)];
-            x[IX(i, N-1, k)] = b == 2 ? -x[IX(i, N-2, k)] : x[IX(i, N-2, k)];
+            mirror(IX(i, 0  , k), IX(i, 1  , k), b == 2);
+            mirror(IX(i, N-1, k), IX(i, N-2, k), b == 2);
         }
     }
     for(int k = 1; k < N - 1; k++) {
         for(int j = 1; j < N - 1; j++) {
-            x[IX(0  , j, k)] = b == 1 ? -x[IX(1  , j, k)] : x[IX(1  , j, k)];
-            x[IX(N-1, j, k)] = b == 1 ? -x[IX(N-2, j, k)] : x[IX(N-2, j, k)];
-        }
-    }
-    
-    x[IX(0, 0, 0)]       = 0.33f * (x[IX(1, 0, 0)]
-                                  + x[IX(0, 1, 0)]
-                                  + x[IX(0, 0, 1)]);
-    x[IX(0, N-1, 0)]     = 0.33f * (x[IX(1, N-1, 0)]
-                                  + x[IX(0, N-2, 0)]
-                                  + x[IX(0, N-1, 1)]);
-    x[IX(0, 0, N-1)]     = 0.33f * (x[IX(1, 0, N-1)]
-                                  + x[IX(0, 1, N-1)]
-                                  + x[IX(0, 0, N)]);
-    x[IX(0, N-1, N-1)]   = 0.33f * (x[IX(1, N-1, N-1)]
-                                  + x[IX(0, N-2, N-1)]
-                                  + x[IX(0, N-1, N-2)]);
-    x[IX(N-1, 0, 0)]     = 0.33f * (x[IX(N-2, 0, 0)]
-                                  + x[IX(N-1, 1, 0)]
-                                  + x[IX(N-1, 0, 1)]);
-    x[IX(N-1, N-1, 0)]   = 0.33f * (x[IX(N-2, N-1, 0)]
-                                  + x[IX(N-1, N-2, 0)]
-                                  + x[IX(N-1, N-1, 1)]);
-    x[IX(N-1, 0, N-1)]   = 0.33f * (x[IX(N-2, 0, N-1)]
-                                  + x[IX(N-1, 1, N-1)]
-                                  + x[IX(N-1, 0, N-2)]);
-    x[IX(N-1, N-1, N-1)] = 0.33f * (x[IX(N-2, N-1, N-1)]
-                                  + x[IX(N-1, N-2, N-1)]
-                                  + x[IX(N-1, N-1, N-2)]);
-}
-
-void Fluid::lin_solve(int b, float *x, float *x0, float a, float c) {
-    int N = this->size;
-
-    float cRecip = 1.0f / c;
+            mirror(IX(0  , j, k), IX(1  , j, k), b == 1);
+            mirror(IX(N-1, j, k), IX(N-2, j, k), b == 1);
+        }
+    }
+
+    // Ścianki MAC leżące na brzegu (indeks 1 i N-1 wzdłuż osi b) oraz zewnętrzne (0) mają zerową prędkość normalną
+    if (this->layout == layoutMAC && b != 0) {
+        for (int m = 1; m < N - 1; m++) {
+            for (int l = 1; l < N - 1; l++) {
+                for (int face : { 0, 1, N - 1 }) {
+                    int index = b == 1 ? IX(face, l, m) : (b == 2 ? IX(l, face, m) : IX(l, m, face));
+                    StoreField(x[index], 0.0f);
+                }
+            }
+        }
+    }
+
+    corner(IX(0, 0, 0),       IX(1, 0, 0),       IX(0, 1, 0),       IX(0, 0, 1));
+    corner(IX(0, N-1, 0),     IX(1, N-1, 0),     IX(0, N-2, 0),     IX(0, N-1, 1));
+    corner(IX(0, 0, N-1),     IX(1, 0, N-1),     IX(0, 1, N-1),     IX(0, 0, N-2));
+    corner(IX(0, N-1, N-1),   IX(1, N-1, N-1),   IX(0, N-2, N-1),   IX(0, N-1, N-2));
+    corner(IX(N-1, 0, 0),     IX(N-2, 0, 0),     IX(N-1, 1, 0),     IX(N-1, 0, 1));
+    corner(IX(N-1, N-1, 0),   IX(N-2, N-1, 0),   IX(N-1, N-2, 0),   IX(N-1, N-1, 1));
+    corner(IX(N-1, 0, N-1),   IX(N-2, 0, N-1),   IX(N-1, 1, N-1),   IX(N-1, 0, N-2));
+    corner(IX(N-1, N-1, N-1), IX(N-2, N-1, N-1), IX(N-1, N-2, N-1), IX(N-1, N-1, N-2));
+
+    apply_obstacles(b, x);
+}
+
+// Mapa aktywnych bloków: blok z barwnikiem lub ruchem powyżej progu, poszerzony o zasięg adwekcji
+template <typename Real>
+void FluidSolver<Real>::update_activity() {
+    int N = this->size;
+    int B = (N + (1 << activityBlockBits) - 1) >> activityBlockBits;
+    if (this->activity.Res() != B) this->activity.Resize(B);
+
+    std::vector<uint8_t>& live = this->liveBlocks;
+    live.assign(size_t(B) * B * B, 0);
+    this->layerSpeed.assign(B, 0.0f);
+
+    // Warstwy bloków z są rozłączne w 'live', każda ma własne maksimum prędkości
+    ThreadPool::Instance().ParallelFor(0, B, [&](int begin, int end) {
+        for (int bz = begin; bz < end; bz++) {
+            float layerMax = 0.0f;
+            for (int k = bz << activityBlockBits; k < std::min((bz + 1) << activityBlockBits, N); k++) {
+                for (int j = 0; j < N; j++) {
+                    uint8_t *row = &live[(size_t(bz) * B + (j >> activityBlockBits)) * B];
+                    for (int i = 0; i < N; i++) {
+                        int index = IX(i, j, k);
+                        float speed = std::max(std::fabs(this->Vx[index]), std::max(std::fabs(this->Vy[index]), std::fabs(this->Vz[index])));
+                        layerMax = std::max(layerMax, speed);
+                        row[i >> activityBlockBits] |= (this->density[index] > activityDensityEpsilon) | (speed > activitySpeedEpsilon);
+                    }
+                }
+            }
+            this->layerSpeed[bz] = layerMax;
+        }
+    });
+
+    float maxSpeed = *std::max_element(this->layerSpeed.begin(), this->layerSpeed.end());
+
+    // Cofnięcie w adwekcji sięga maxSpeed * dt * (N - 2) komórek wzdłuż każdej osi
+    int reach = 1 + static_cast<int>(maxSpeed * this->dt * (N - 2)) / (1 << activityBlockBits);
+
+    this->activity.Clear();
+    for (int bz = 0; bz < B; bz++) {
+        for (int by = 0; by < B; by++) {
+            for (int bx = 0; bx < B; bx++) {
+                if (!live[(size_t(bz) * B + by) * B + bx]) continue;
+
+                for (int z = std::max(bz - reach, 0); z <= std::min(bz + reach, B - 1); z++)
+                    for (int y = std::max(by - reach, 0); y <= std::min(by + reach, B - 1); y++)
+                        for (int x = std::max(bx - reach, 0); x <= std::min(bx + reach, B - 1); x++)
+                            this->activity.Set(x, y, z, true);
+            }
+        }
+    }
+}
+
+template <typename Real>
+template <typename X, typename X0>
+void FluidSolver<Real>::lin_solve(int b, X *x, X0 *x0, Real a, Real c, const VoxelGrid *active) {
+    if (!std::is_same<X, Real>::value || !std::is_same<X0, Real>::value) {
+        lin_solve_rows(b, x, x0, a, c, active);
+        return;
+    }
+
+    int N = this->size;
+
+    Real cRecip = 1.0f / c;
     for (int k = 0; k < this->iter; k++) {
         for (int m = 1; m < N - 1; m++) {
             for (int j = 1; j < N - 1; j++) {
-                for (int i = 1; i < N - 1; i++) {
-                    x[IX(i, j, m)] =
-                        (x0[IX(i, j, m)]
-                            + a*(    x[IX(i+1, j  , m  )]
-                                    +x[IX(i-1, j  , m  )]
-                                    +x[IX(i  , j+1, m  )]
-                                    +x[IX(i  , j-1, m  )]
-                                    +x[IX(i  , j  , m+1)]
-                                    +x[IX(i  , j  , m-1)]
-                           )) * cRecip;
+                const uint64_t *blocks = active ? active->Row(j >> activityBlockBits, m >> activityBlockBits) : nullptr;
+
+                // Wiersz dzielony na odcinki bloków, nieaktywne dostają x0 w pierwszej iteracji
+                for (int begin = 1, end; begin < N - 1; begin = end) {
+                    int bx = begin >> activityBlockBits;
+                    end = std::min((bx + 1) << activityBlockBits, N - 1);
+
+                    if (blocks && !((blocks[bx >> 6] >> (bx & 63)) & 1)) {
+                        if (k == 0)
+                            for (int i = begin; i < end; i++) StoreField(x[IX(i, j, m)], LoadField(x0[IX(i, j, m)]));
+                        continue;
+                    }
+
+                    for (int i = begin; i < end; i++) {
+                        StoreField(x[IX(i, j, m)], RelaxCell<Real>(LoadField(x0[IX(i, j, m)]), a, cRecip,
+                                                                   LoadField(x[IX(i+1, j  , m  )]),
+                                                                   LoadField(x[IX(i-1, j  , m  )]),
+                                                                   LoadField(x[IX(i  , j+1, m  )]),
+                                                                   LoadField(x[IX(i  , j-1, m  )]),
+                                                                   LoadField(x[IX(i  , j  , m+1)]),
+                                                                   LoadField(x[IX(i  , j  , m-1)])));
+                    }
                 }
             }
         }
@@ -106,111 +356,235 @@ void Fluid::lin_solve(int b, float *x, float *x0, float a, float c) {
     }
 }
 
-void Fluid::diffuse(int b, float *x, float *x0, float diff, float dt) {
+// Pojedyncze konwersje 16-bitowe leżą w łańcuchu zależności Gaussa-Seidla (zapis, odczyt i konwersja
+// x[i-1] przed każdą komórką), więc iteracja idzie po trzech płaszczyznach w Real (m-1, m, m+1):
+// każda płaszczyzna x i x0 jest konwertowana wsadowo raz na przebieg i raz zapisywana z powrotem.
+// Zaktualizowani sąsiedzi (i-1, j-1, m-1) są brani z bufora bez zaokrąglenia do typu X, więc wynik
+// minimalnie różni się od zaokrąglania każdej komórki osobno.
+template <typename Real>
+template <typename X, typename X0>
+void FluidSolver<Real>::lin_solve_rows(int b, X *x, X0 *x0, Real a, Real c, const VoxelGrid *active) {
     int N = this->size;
-    float a = dt * diff * (N - 2) * (N - 2);
-    this->lin_solve(b, x, x0, a, 1 + 6 * a);
+    const int plane = N * N;
+
+    static thread_local std::vector<Real> planes;
+    planes.resize(size_t(4) * plane);
+    Real *below = &planes[0], *cur = below + plane, *above = cur + plane, *rhs = above + plane;
+
+    Real cRecip = 1.0f / c;
+    for (int k = 0; k < this->iter; k++) {
+        loadArray(&x[IX(0, 0, 0)], below, plane);
+        loadArray(&x[IX(0, 0, 1)], cur, plane);
+
+        for (int m = 1; m < N - 1; m++) {
+            loadArray(&x[IX(0, 0, m + 1)], above, plane);
+            loadArray(&x0[IX(0, 0, m)], rhs, plane);
+
+            for (int j = 1; j < N - 1; j++) {
+                const uint64_t *blocks = active ? active->Row(j >> activityBlockBits, m >> activityBlockBits) : nullptr;
+                Real *row = cur + j * N;
+                const Real *src = rhs + j * N, *yp = row + N, *ym = row - N, *zp = above + j * N, *zm = below + j * N;
+
+                // Wiersz dzielony na odcinki bloków, nieaktywne dostają x0 w pierwszej iteracji
+                for (int begin = 1, end; begin < N - 1; begin = end) {
+                    int bx = begin >> activityBlockBits;
+                    end = std::min((bx + 1) << activityBlockBits, N - 1);
+
+                    if (blocks && !((blocks[bx >> 6] >> (bx & 63)) & 1)) {
+                        if (k == 0) std::copy(src + begin, src + end, row + begin);
+                        continue;
+                    }
+
+                    for (int i = begin; i < end; i++)
+                        row[i] = RelaxCell<Real>(src[i], a, cRecip, row[i + 1], row[i - 1], yp[i], ym[i], zp[i], zm[i]);
+                }
+            }
+
+            // Wiersze 1..N-2 w całości -- komórki brzegowe wracają niezmienione
+            storeArray(cur + N, &x[IX(0, 1, m)], size_t(N - 2) * N);
+            std::swap(below, cur);
+            std::swap(cur, above);
+        }
+        set_bounds(b, x);
+    }
 }
 
-void Fluid::advect(int b, float *d, float *d0,  float *velocX, float *velocY, float *velocZ, float dt) {
+template <typename Real>
+template <typename X, typename X0>
+void FluidSolver<Real>::diffuse(int b, X *x, X0 *x0, Real diff, Real dt, const VoxelGrid *active) {
     int N = this->size;
-    float i0, i1, j0, j1, k0, k1;
-    
-    float dtx = dt * (N - 2);
-    float dty = dt * (N - 2);
-    float dtz = dt * (N - 2);
-    
-    float s0, s1, t0, t1, u0, u1;
-    float tmp1, tmp2, tmp3, x, y, z;
-    
-    float Nfloat = N;
-    float ifloat, jfloat, kfloat;
+    Real a = dt * diff * (N - 2) * (N - 2);
+    this->lin_solve(b, x, x0, a, 1 + 6 * a, active);
+}
+
+template <typename Real>
+template <typename D, typename D0, typename V>
+void FluidSolver<Real>::advect(int b, D *d, D0 *d0, V *velocX, V *velocY, V *velocZ, Real dt, const VoxelGrid *active) {
+    if (this->advection == advectMacCormack) {
+        advect_maccormack(b, d, d0, velocX, velocY, velocZ, dt, active);
+        return;
+    }
+    if (this->layout == layoutMAC) {
+        advect_mac(b, d, d0, velocX, velocY, velocZ, dt, active);
+        return;
+    }
+
+    int N = this->size;
+
+    Real dtx = dt * (N - 2);
+    Real dty = dt * (N - 2);
+    Real dtz = dt * (N - 2);
+
+    Real ifloat, jfloat, kfloat;
     int i, j, k;
-    
+
     for(k = 1, kfloat = 1; k < N - 1; k++, kfloat++) {
-        for(j = 1, jfloat = 1; j < N - 1; j++, jfloat++) { 
-            for(i = 1, ifloat = 1; i < N - 1; i++, ifloat++) {
-                tmp1 = dtx * velocX[IX(i, j, k)];
-                tmp2 = dty * velocY[IX(i, j, k)];
-                tmp3 = dtz * velocZ[IX(i, j, k)];
-                x    = ifloat - tmp1; 
-                y    = jfloat - tmp2;
-                z    = kfloat - tmp3;
-                
-                if(x < 0.5f) x = 0.5f; 
-                if(x > Nfloat + 0.5f) x = Nfloat + 0.5f; 
-                i0 = floorf(x); 
-                i1 = i0 + 1.0f;
-                if(y < 0.5f) y = 0.5f; 
-                if(y > Nfloat + 0.5f) y = Nfloat + 0.5f; 
-                j0 = floorf(y);
-                j1 = j0 + 1.0f; 
-                if(z < 0.5f) z = 0.5f;
-                if(z > Nfloat + 0.5f) z = Nfloat + 0.5f;
-                k0 = floorf(z);
-                k1 = k0 + 1.0f;
-                
-                s1 = x - i0; 
-                s0 = 1.0f - s1; 
-                t1 = y - j0; 
-                t0 = 1.0f - t1;
-                u1 = z - k0;
-                u0 = 1.0f - u1;
-                
-                int i0i = i0;
-                int i1i = i1;
-                int j0i = j0;
-                int j1i = j1;
-                int k0i = k0;
-                int k1i = k1;
-                
-                d[IX(i, j, k)] = 
-                
-                    s0 * ( t0 * (u0 * d0[IX(i0i, j0i, k0i)]
-                                +u1 * d0[IX(i0i, j0i, k1i)])
-                        +( t1 * (u0 * d0[IX(i0i, j1i, k0i)]
-                                +u1 * d0[IX(i0i, j1i, k1i)])))
-                   +s1 * ( t0 * (u0 * d0[IX(i1i, j0i, k0i)]
-                                +u1 * d0[IX(i1i, j0i, k1i)])
-                        +( t1 * (u0 * d0[IX(i1i, j1i, k0i)]
-                                +u1 * d0[IX(i1i, j1i, k1i)])));
+        for(j = 1, jfloat = 1; j < N - 1; j++, jfloat++) {
+            const uint64_t *blocks = active ? active->Row(j >> activityBlockBits, k >> activityBlockBits) : nullptr;
+
+            // Wiersz dzielony na odcinki bloków, nieaktywne tylko kopiują d0
+            for (int begin = 1, end; begin < N - 1; begin = end) {
+                int bx = begin >> activityBlockBits;
+                end = std::min((bx + 1) << activityBlockBits, N - 1);
+
+                if (blocks && !((blocks[bx >> 6] >> (bx & 63)) & 1)) {
+                    for (i = begin; i < end; i++) StoreField(d[IX(i, j, k)], LoadField(d0[IX(i, j, k)]));
+                    continue;
+                }
+
+                for(i = begin, ifloat = begin; i < end; i++, ifloat++) {
+                    Real x = ClampBacktrace(ifloat - dtx * LoadField(velocX[IX(i, j, k)]), N);
+                    Real y = ClampBacktrace(jfloat - dty * LoadField(velocY[IX(i, j, k)]), N);
+                    Real z = ClampBacktrace(kfloat - dtz * LoadField(velocZ[IX(i, j, k)]), N);
+
+                    // Współrzędne są dodatnie, więc obcięcie do int to floor
+                    int i0 = int(x), j0 = int(y), k0 = int(z);
+                    int index = IX(i0, j0, k0);
+
+                    Real c[8] = {
+                        LoadField(d0[index]),         LoadField(d0[index + N*N]),
+                        LoadField(d0[index + N]),     LoadField(d0[index + N + N*N]),
+                        LoadField(d0[index + 1]),     LoadField(d0[index + 1 + N*N]),
+                        LoadField(d0[index + 1 + N]), LoadField(d0[index + 1 + N + N*N])
+                    };
+                    StoreField(d[IX(i, j, k)], TrilinearCell(c, x - i0, y - j0, z - k0));
+                }
             }
         }
     }
     set_bounds(b, d);
 }
 
-void  Fluid::project(float *velX, float *velY, float *velZ, float *p, float *div) {
+template <typename Real>
+template <typename V, typename P>
+void FluidSolver<Real>::project(V *velX, V *velY, V *velZ, P *p, P *div) {
+    if (this->layout == layoutMAC) {
+        project_mac(velX, velY, velZ, p, div);
+        return;
+    }
+
     int N = this->size;
     for (int k = 1; k < N - 1; k++) {
         for (int j = 1; j < N - 1; j++) {
             for (int i = 1; i < N - 1; i++) {
-                div[IX(i, j, k)] = -0.5f*(
-                         velX[IX(i+1, j  , k  )]
-                        -velX[IX(i-1, j  , k  )]
-                        +velY[IX(i  , j+1, k  )]
-                        -velY[IX(i  , j-1, k  )]
-                        +velZ[IX(i  , j  , k+1)]
-                        -velZ[IX(i  , j  , k-1)]
-                    )/N;
-                p[IX(i, j, k)] = 0;
+                StoreField(div[IX(i, j, k)], DivergenceCell<Real>(
+                         LoadField(velX[IX(i+1, j  , k  )]),
+                         LoadField(velX[IX(i-1, j  , k  )]),
+                         LoadField(velY[IX(i  , j+1, k  )]),
+                         LoadField(velY[IX(i  , j-1, k  )]),
+                         LoadField(velZ[IX(i  , j  , k+1)]),
+                         LoadField(velZ[IX(i  , j  , k-1)]), N));
+                StoreField(p[IX(i, j, k)], 0.0f);
+            }
+        }
+    }
+
+    solve_pressure(p, div);
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                StoreField(velX[IX(i, j, k)], LoadField(velX[IX(i, j, k)])
+                                              - GradientCell<Real>(LoadField(p[IX(i+1, j, k)]), LoadField(p[IX(i-1, j, k)]), N));
+                StoreField(velY[IX(i, j, k)], LoadField(velY[IX(i, j, k)])
+                                              - GradientCell<Real>(LoadField(p[IX(i, j+1, k)]), LoadField(p[IX(i, j-1, k)]), N));
+                StoreField(velZ[IX(i, j, k)], LoadField(velZ[IX(i, j, k)])
+                                              - GradientCell<Real>(LoadField(p[IX(i, j, k+1)]), LoadField(p[IX(i, j, k-1)]), N));
             }
         }
     }
+    set_bounds(1, velX);
+    set_bounds(2, velY);
+    set_bounds(3, velZ);
+}
+
+template <typename Real>
+template <typename P>
+void FluidSolver<Real>::solve_pressure(P *p, P *div) {
+    int N = this->size;
+
+    // Auto -- spektralnie tylko na siatce MAC; przy różnicach centralnych rzut i tak zostawia
+    // mody szachownicy, więc dokładne rozwiązanie nie zmniejsza |div| względem lin_solve
+    bool spectral = this->pressure == pressureSpectral || (this->pressure == pressureAuto && this->layout == layoutMAC);
+    if (!spectral || this->obstacles || N < 3) {
+        set_bounds(0, div);
+        set_bounds(0, p);
+        lin_solve(0, p, div, 1, 6);
+        return;
+    }
+
+    // Komórki wewnętrzne 1..N-2 do bufora FastPoisson i z powrotem, brzeg z set_bounds jak w lin_solve
+    int n = N - 2;
+    if (this->poisson.Size() != n) this->poisson.Create(n);
+
+    double *data = this->poisson.Data();
+    for (int k = 0; k < n; k++)
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++)
+                data[(size_t(k) * n + j) * n + i] = LoadField(div[IX(i + 1, j + 1, k + 1)]);
 
-    set_bounds(0, div); 
+    this->poisson.Solve();
+
+    for (int k = 0; k < n; k++)
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++)
+                StoreField(p[IX(i + 1, j + 1, k + 1)], Real(data[(size_t(k) * n + j) * n + i]));
     set_bounds(0, p);
-    lin_solve(0, p, div, 1, 6);
-    
+}
+
+// Rzut na siatce MAC: dywergencja komórki z jej sześciu ścianek, gradient ciśnienia na ściance
+// z dwóch sąsiednich komórek. Złożenie obu to dokładnie laplasjan 7-punktowy rozwiązywany w lin_solve,
+// więc nie ma nieuchwytnych dla niego modów szachownicy jak przy różnicach centralnych i +-1.
+template <typename Real>
+template <typename V, typename P>
+void FluidSolver<Real>::project_mac(V *velX, V *velY, V *velZ, P *p, P *div) {
+    int N = this->size;
     for (int k = 1; k < N - 1; k++) {
         for (int j = 1; j < N - 1; j++) {
             for (int i = 1; i < N - 1; i++) {
-                velX[IX(i, j, k)] -= 0.5f * (  p[IX(i+1, j, k)]
-                                                -p[IX(i-1, j, k)]) * N;
-                velY[IX(i, j, k)] -= 0.5f * (  p[IX(i, j+1, k)]
-                                                -p[IX(i, j-1, k)]) * N;
-                velZ[IX(i, j, k)] -= 0.5f * (  p[IX(i, j, k+1)]
-                                                -p[IX(i, j, k-1)]) * N;
+                StoreField(div[IX(i, j, k)], -(
+                         LoadField(velX[IX(i+1, j  , k  )])
+                        -LoadField(velX[IX(i  , j  , k  )])
+                        +LoadField(velY[IX(i  , j+1, k  )])
+                        -LoadField(velY[IX(i  , j  , k  )])
+                        +LoadField(velZ[IX(i  , j  , k+1)])
+                        -LoadField(velZ[IX(i  , j  , k  )])
+                    )/N);
+                StoreField(p[IX(i, j, k)], 0.0f);
+            }
+        }
+    }
+
+    solve_pressure(p, div);
+
+    // Ścianki przy brzegu (i = 1) dostają zero w set_bounds
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                Real pc = LoadField(p[IX(i, j, k)]);
+                StoreField(velX[IX(i, j, k)], LoadField(velX[IX(i, j, k)]) - (pc - LoadField(p[IX(i-1, j, k)])) * N);
+                StoreField(velY[IX(i, j, k)], LoadField(velY[IX(i, j, k)]) - (pc - LoadField(p[IX(i, j-1, k)])) * N);
+                StoreField(velZ[IX(i, j, k)], LoadField(velZ[IX(i, j, k)]) - (pc - LoadField(p[IX(i, j, k-1)])) * N);
             }
         }
     }
@@ -219,34 +593,458 @@ void  Fluid::project(float *velX, float *velY, float *velZ, float *p, float *div
     set_bounds(3, velZ);
 }
 
-void Fluid::FluidStep() {
-    this->diffuse(1, this->Vx0, this->Vx, this->visc, this->dt);
-    this->diffuse(2, this->Vy0, this->Vy, this->visc, this->dt);
-    this->diffuse(3, this->Vz0, this->Vz, this->visc, this->dt);
-    
-    this->project(this->Vx0, this->Vy0, this->Vz0, this->Vx, this->Vy);
-    
-    this->advect(1, this->Vx, this->Vx0, this->Vx0, this->Vy0, this->Vz0, this->dt);
-    this->advect(2, this->Vy, this->Vy0, this->Vx0, this->Vy0, this->Vz0, this->dt);
-    this->advect(3, this->Vz, this->Vz0, this->Vx0, this->Vy0, this->Vz0, this->dt);
-    
-    this->project(this->Vx, this->Vy, this->Vz, this->Vx0, this->Vy0);
-    
-    this->diffuse(0, this->s, this->density, this->diff, this->dt);
-    this->advect(0, this->density, this->s, this->Vx, this->Vy, this->Vz, this->dt);
+// W układzie zwykłym wszystkie składowe leżą w środku komórki
+template <typename Real>
+template <typename V>
+void FluidSolver<Real>::point_velocity(int b, int index, const V *velX, const V *velY, const V *velZ, Real& u, Real& v, Real& w) const {
+    int N = this->size;
+
+    if (this->layout == layoutCollocated) {
+        u = LoadField(velX[index]);
+        v = LoadField(velY[index]);
+        w = LoadField(velZ[index]);
+        return;
+    }
+
+    // Składowa własna leży w punkcie, pozostałe to średnie czterech sąsiednich ścianek
+    if (b == 1) {
+        u = LoadField(velX[index]);
+        v = Real(0.25) * (LoadField(velY[index - 1]) + LoadField(velY[index])
+                        + LoadField(velY[index - 1 + N]) + LoadField(velY[index + N]));
+        w = Real(0.25) * (LoadField(velZ[index - 1]) + LoadField(velZ[index])
+                        + LoadField(velZ[index - 1 + N*N]) + LoadField(velZ[index + N*N]));
+    }
+    else if (b == 2) {
+        u = Real(0.25) * (LoadField(velX[index - N]) + LoadField(velX[index])
+                        + LoadField(velX[index - N + 1]) + LoadField(velX[index + 1]));
+        v = LoadField(velY[index]);
+        w = Real(0.25) * (LoadField(velZ[index - N]) + LoadField(velZ[index])
+                        + LoadField(velZ[index - N + N*N]) + LoadField(velZ[index + N*N]));
+    }
+    else if (b == 3) {
+        u = Real(0.25) * (LoadField(velX[index - N*N]) + LoadField(velX[index])
+                        + LoadField(velX[index - N*N + 1]) + LoadField(velX[index + 1]));
+        v = Real(0.25) * (LoadField(velY[index - N*N]) + LoadField(velY[index])
+                        + LoadField(velY[index - N*N + N]) + LoadField(velY[index + N]));
+        w = LoadField(velZ[index]);
+    }
+    else {
+        u = Real(0.5) * (LoadField(velX[index]) + LoadField(velX[index + 1]));
+        v = Real(0.5) * (LoadField(velY[index]) + LoadField(velY[index + N]));
+        w = Real(0.5) * (LoadField(velZ[index]) + LoadField(velZ[index + N*N]));
+    }
+}
+
+// Adwekcja na siatce MAC: prędkość w punkcie startowym złożona z najbliższych ścianek,
+// cofnięcie o dt * u i próbkowanie pola w jego własnym układzie indeksów
+template <typename Real>
+template <typename D, typename D0, typename V>
+void FluidSolver<Real>::advect_mac(int b, D *d, D0 *d0, V *velocX, V *velocY, V *velocZ, Real dt, const VoxelGrid *active) {
+    int N = this->size;
+    Real dtN = dt * (N - 2);
+
+    // Trójliniowe próbkowanie d0 we współrzędnych indeksów, przycięte do siatki
+    auto sample = [&](Real x, Real y, Real z) {
+        x = std::min(std::max(x, Real(0)), Real(N - 1));
+        y = std::min(std::max(y, Real(0)), Real(N - 1));
+        z = std::min(std::max(z, Real(0)), Real(N - 1));
+        int i0 = std::min(int(x), N - 2), j0 = std::min(int(y), N - 2), k0 = std::min(int(z), N - 2);
+        Real s1 = x - i0, t1 = y - j0, u1 = z - k0;
+        Real s0 = 1 - s1, t0 = 1 - t1, u0 = 1 - u1;
+        int index = IX(i0, j0, k0);
+
+        return s0 * (t0 * (u0 * LoadField(d0[index])         + u1 * LoadField(d0[index + N*N]))
+                   + t1 * (u0 * LoadField(d0[index + N])     + u1 * LoadField(d0[index + N + N*N])))
+             + s1 * (t0 * (u0 * LoadField(d0[index + 1])     + u1 * LoadField(d0[index + 1 + N*N]))
+                   + t1 * (u0 * LoadField(d0[index + 1 + N]) + u1 * LoadField(d0[index + 1 + N + N*N])));
+    };
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            const uint64_t *blocks = active ? active->Row(j >> activityBlockBits, k >> activityBlockBits) : nullptr;
+
+            for (int begin = 1, end; begin < N - 1; begin = end) {
+                int bx = begin >> activityBlockBits;
+                end = std::min((bx + 1) << activityBlockBits, N - 1);
+
+                if (blocks && !((blocks[bx >> 6] >> (bx & 63)) & 1)) {
+                    for (int i = begin; i < end; i++) StoreField(d[IX(i, j, k)], LoadField(d0[IX(i, j, k)]));
+                    continue;
+                }
+
+                for (int i = begin; i < end; i++) {
+                    int index = IX(i, j, k);
+                    Real u, v, w;
+
+                    point_velocity(b, index, velocX, velocY, velocZ, u, v, w);
 
+                    // Przesunięcie ścianek o pół komórki jest takie samo w punkcie i w polu d0, więc się znosi
+                    StoreField(d[index], sample(i - dtN * u, j - dtN * v, k - dtN * w));
+                }
+            }
+        }
+    }
+    set_bounds(b, d);
 }
 
-void Fluid::AddDensity(int x, int y, int z, float amount) {
+// Pola float z AVX2 -- interpolateRowAVX2. W pozostałych przypadkach dwa przebiegi: najpierw
+// współrzędne, wagi i indeksy dla całego odcinka (bez rozgałęzień, z -O3 kompilator sam zamienia
+// tę pętlę na SIMD), potem zbieranie ośmiu sąsiadów i mieszanie.
+template <typename Real>
+template <typename F>
+void FluidSolver<Real>::interpolate_row(const F *f, int j, int k, int begin, int count, const Real *u, const Real *v, const Real *w,
+                                        Real dtN, Real *out, Real *lo, Real *hi) const {
+    const int width = 1 << activityBlockBits;
     int N = this->size;
-    this->density[IX(x, y, z)] += amount;
+
+    if (interpolateRowSIMD(f, N, j, k, begin, count, u, v, w, dtN, out, lo, hi)) return;
+
+    int base[width];
+    Real sx[width], sy[width], sz[width];
+
+    for (int n = 0; n < count; n++) {
+        Real x = ClampBacktrace(Real(begin + n) - dtN * u[n], N);
+        Real y = ClampBacktrace(Real(j)         - dtN * v[n], N);
+        Real z = ClampBacktrace(Real(k)         - dtN * w[n], N);
+
+        // Współrzędne są dodatnie, więc obcięcie do int to floor
+        int i0 = int(x), j0 = int(y), k0 = int(z);
+        sx[n] = x - i0;
+        sy[n] = y - j0;
+        sz[n] = z - k0;
+        base[n] = IX(i0, j0, k0);
+    }
+
+    for (int n = 0; n < count; n++) {
+        const F *c = f + base[n];
+        Real c000 = LoadField(c[0]),     c100 = LoadField(c[1]);
+        Real c010 = LoadField(c[N]),     c110 = LoadField(c[N + 1]);
+        Real c001 = LoadField(c[N*N]),   c101 = LoadField(c[N*N + 1]);
+        Real c011 = LoadField(c[N*N + N]), c111 = LoadField(c[N*N + N + 1]);
+
+        Real x00 = c000 + sx[n] * (c100 - c000);
+        Real x10 = c010 + sx[n] * (c110 - c010);
+        Real x01 = c001 + sx[n] * (c101 - c001);
+        Real x11 = c011 + sx[n] * (c111 - c011);
+        Real y0 = x00 + sy[n] * (x10 - x00);
+        Real y1 = x01 + sy[n] * (x11 - x01);
+        out[n] = y0 + sz[n] * (y1 - y0);
+
+        if (lo) {
+            lo[n] = std::min(std::min(std::min(c000, c100), std::min(c010, c110)), std::min(std::min(c001, c101), std::min(c011, c111)));
+            hi[n] = std::max(std::max(std::max(c000, c100), std::max(c010, c110)), std::max(std::max(c001, c101), std::max(c011, c111)));
+        }
+    }
 }
 
-void Fluid::AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ) {
+// MacCormack: phi^ = A(phi), phi_ = A^-1(phi^), wynik phi^ + (phi - phi_) / 2 przycięty do zakresu
+// próbek phi użytych dla phi^. Nieaktywne bloki kopiują d0 jak w advect.
+template <typename Real>
+template <typename D, typename D0, typename V>
+void FluidSolver<Real>::advect_maccormack(int b, D *d, D0 *d0, V *velocX, V *velocY, V *velocZ, Real dt, const VoxelGrid *active) {
+    const int width = 1 << activityBlockBits;
+    int N = this->size;
+    Real dtN = dt * (N - 2);
+
+    if (!this->scratch) this->scratch = new Real[N * N * N]();
+
+    Real u[width], v[width], w[width];
+    Real forward[width], backward[width], lo[width], hi[width];
+
+    // pass 0: phi^ do d, pass 1: poprawka do scratch
+    for (int pass = 0; pass < 2; pass++) {
+        for (int k = 1; k < N - 1; k++) {
+            for (int j = 1; j < N - 1; j++) {
+                const uint64_t *blocks = active ? active->Row(j >> activityBlockBits, k >> activityBlockBits) : nullptr;
+
+                for (int begin = 1, end; begin < N - 1; begin = end) {
+                    int bx = begin >> activityBlockBits;
+                    end = std::min((bx + 1) << activityBlockBits, N - 1);
+                    int row = IX(begin, j, k), count = end - begin;
+
+                    if (blocks && !((blocks[bx >> 6] >> (bx & 63)) & 1)) {
+                        for (int n = 0; n < count; n++) {
+                            if (pass == 0) StoreField(d[row + n], LoadField(d0[row + n]));
+                            else this->scratch[row + n] = LoadField(d0[row + n]);
+                        }
+                        continue;
+                    }
+
+                    for (int n = 0; n < count; n++)
+                        point_velocity(b, row + n, velocX, velocY, velocZ, u[n], v[n], w[n]);
+
+                    if (pass == 0) {
+                        interpolate_row(d0, j, k, begin, count, u, v, w, dtN, forward);
+                        for (int n = 0; n < count; n++) StoreField(d[row + n], forward[n]);
+                        continue;
+                    }
+
+                    // Krok wstecz z phi^ oraz zakres ośmiu próbek phi z kroku w przód
+                    interpolate_row(d, j, k, begin, count, u, v, w, -dtN, backward);
+                    interpolate_row(d0, j, k, begin, count, u, v, w, dtN, forward, lo, hi);
+                    for (int n = 0; n < count; n++) {
+                        Real corrected = LoadField(d[row + n]) + Real(0.5) * (LoadField(d0[row + n]) - backward[n]);
+                        this->scratch[row + n] = std::min(std::max(corrected, lo[n]), hi[n]);
+                    }
+                }
+            }
+        }
+
+        if (pass == 0) set_bounds(b, d);
+    }
+
+    for (int k = 1; k < N - 1; k++)
+        for (int j = 1; j < N - 1; j++)
+            for (int i = 1; i < N - 1; i++)
+                StoreField(d[IX(i, j, k)], this->scratch[IX(i, j, k)]);
+    set_bounds(b, d);
+}
+
+// Dwa przejścia. Pierwsze idzie warstwami z (równolegle w ThreadPool): w każdej warstwie trzy
+// płaszczyzny prędkości w środkach komórek (tylko MAC), trzy płaszczyzny wiru i jego modułu krążą
+// w buforze wątku, a siła trafia do vortForce. Warstwa liczy sama wir płaszczyzny nad i pod sobą,
+// a Vx/Vy/Vz w tym przejściu tylko czyta, więc kolejność warstw nie ma znaczenia.
+// Drugie przejście dodaje siłę do prędkości.
+template <typename Real>
+void FluidSolver<Real>::confine_vorticity() {
+    int N = this->size;
+    if (N < 5) return;
+
+    const int T = vorticitySlab;
+    const int plane = N * N;
+    const size_t total = size_t(N) * N * N;
+    int slabs = (N - 4 + T - 1) / T;
+    Real scale = Real(this->dt) * this->vorticity;
+    bool mac = this->layout == layoutMAC;
+
+    // Płaszczyzny 0, 1, N-2, N-1 nie dostają siły, reszta jest nadpisywana w całości
+    this->vortForce.resize(3 * total);
+    Real *fx = &this->vortForce[0], *fy = fx + total, *fz = fy + total;
+    for (int k : { 0, 1, N - 2, N - 1 }) {
+        std::fill_n(fx + size_t(k) * plane, plane, Real(0));
+        std::fill_n(fy + size_t(k) * plane, plane, Real(0));
+        std::fill_n(fz + size_t(k) * plane, plane, Real(0));
+    }
+
+    auto slab = [&](int z0, int z1) {
+        static thread_local std::vector<Real> rings;
+        rings.resize(size_t(21) * plane);
+        Real *vel = &rings[0], *curl = vel + 9 * plane, *mag = curl + 9 * plane;
+
+        // Składowa 'axis' prędkości w płaszczyźnie k: w MAC z pierścienia, inaczej wprost z pola
+        auto velocity = [&](int axis, int k) -> const Real* {
+            if (mac) return vel + (3 * (k % 3) + axis) * plane;
+            const Real *field = axis == 0 ? this->Vx : (axis == 1 ? this->Vy : this->Vz);
+            return field + size_t(k) * plane;
+        };
+        auto curlPlane = [&](int axis, int k) { return curl + (3 * (k % 3) + axis) * plane; };
+        auto magPlane = [&](int k) { return mag + (k % 3) * plane; };
+
+        // Komórki brzegowe MAC biorą ścianki bez uśredniania
+        auto loadVelocity = [&](int k) {
+            Real *u = vel + (3 * (k % 3)) * plane, *v = u + plane, *w = v + plane;
+            for (int j = 0; j < N; j++) {
+                for (int i = 0; i < N; i++) {
+                    int index = IX(i, j, k), l = j * N + i;
+                    bool edge = i == 0 || j == 0 || k == 0 || i == N - 1 || j == N - 1 || k == N - 1;
+                    if (!edge) point_velocity(0, index, this->Vx, this->Vy, this->Vz, u[l], v[l], w[l]);
+                    else {
+                        u[l] = this->Vx[index];
+                        v[l] = this->Vy[index];
+                        w[l] = this->Vz[index];
+                    }
+                }
+            }
+        };
+
+        // Wir w płaszczyźnie k (komórki 1..N-2), różnice centralne w jednostkach komórek
+        auto computeCurl = [&](int k) {
+            const Real *u = velocity(0, k), *v = velocity(1, k), *w = velocity(2, k);
+            const Real *uBelow = velocity(0, k - 1), *uAbove = velocity(0, k + 1);
+            const Real *vBelow = velocity(1, k - 1), *vAbove = velocity(1, k + 1);
+            Real *cx = curlPlane(0, k), *cy = curlPlane(1, k), *cz = curlPlane(2, k), *m = magPlane(k);
+            for (int j = 1; j < N - 1; j++) {
+                for (int i = 1; i < N - 1; i++) {
+                    int l = j * N + i;
+                    cx[l] = Real(0.5) * ((w[l + N] - w[l - N]) - (vAbove[l] - vBelow[l]));
+                    cy[l] = Real(0.5) * ((uAbove[l] - uBelow[l]) - (w[l + 1] - w[l - 1]));
+                    cz[l] = Real(0.5) * ((v[l + 1] - v[l - 1]) - (u[l + N] - u[l - N]));
+                    m[l] = std::sqrt(cx[l] * cx[l] + cy[l] * cy[l] + cz[l] * cz[l]);
+                }
+            }
+        };
+
+        // Siła w płaszczyźnie k, zerowa poza komórkami 2..N-3 i w przeszkodach
+        auto computeForce = [&](int k) {
+            const Real *cx = curlPlane(0, k), *cy = curlPlane(1, k), *cz = curlPlane(2, k);
+            const Real *m = magPlane(k), *mBelow = magPlane(k - 1), *mAbove = magPlane(k + 1);
+            Real *ox = fx + size_t(k) * plane, *oy = fy + size_t(k) * plane, *oz = fz + size_t(k) * plane;
+            for (int j = 0; j < N; j++) {
+                for (int i = 0; i < N; i++) {
+                    int l = j * N + i;
+                    bool inner = i >= 2 && j >= 2 && i < N - 2 && j < N - 2;
+                    if (!inner || (this->obstacles && this->obstacles->Get(i, j, k))) {
+                        ox[l] = oy[l] = oz[l] = 0;
+                        continue;
+                    }
+
+                    Real gx = Real(0.5) * (m[l + 1] - m[l - 1]);
+                    Real gy = Real(0.5) * (m[l + N] - m[l - N]);
+                    Real gz = Real(0.5) * (mAbove[l] - mBelow[l]);
+                    Real length = std::sqrt(gx * gx + gy * gy + gz * gz) + Real(1e-20);
+                    gx /= length;
+                    gy /= length;
+                    gz /= length;
+
+                    ox[l] = scale * (gy * cz[l] - gz * cy[l]);
+                    oy[l] = scale * (gz * cx[l] - gx * cz[l]);
+                    oz[l] = scale * (gx * cy[l] - gy * cx[l]);
+                }
+            }
+        };
+
+        // Prędkość z0-2 .. z1+1, wir z0-1 .. z1, siła z0 .. z1-1 -- każda płaszczyzna od razu,
+        // gdy są gotowe jej trzy płaszczyzny wejściowe
+        for (int k = z0 - 2; k <= z1 + 1; k++) {
+            if (mac) loadVelocity(k);
+            if (k - 1 >= z0 - 1) computeCurl(k - 1);
+            if (k - 2 >= z0) computeForce(k - 2);
+        }
+    };
+
+    ThreadPool& pool = ThreadPool::Instance();
+    pool.ParallelFor(0, slabs, [&](int begin, int end) {
+        for (int n = begin; n < end; n++) slab(2 + n * T, std::min(2 + (n + 1) * T, N - 2));
+    }, 1);
+
+    // W układzie MAC ścianka dostaje po połowie siły z obu sąsiednich komórek
+    pool.ParallelFor(2, N - 1, [&](int begin, int end) {
+        for (int k = begin; k < end; k++) {
+            for (int j = 2; j < N - 1; j++) {
+                for (int i = 2; i < N - 1; i++) {
+                    int c = IX(i, j, k);
+                    if (mac) {
+                        this->Vx[c] += Real(0.5) * (fx[c - 1] + fx[c]);
+                        this->Vy[c] += Real(0.5) * (fy[c - N] + fy[c]);
+                        this->Vz[c] += Real(0.5) * (fz[c - plane] + fz[c]);
+                    }
+                    else {
+                        this->Vx[c] += fx[c];
+                        this->Vy[c] += fy[c];
+                        this->Vz[c] += fz[c];
+                    }
+                }
+            }
+        }
+    });
+}
+
+template <typename Real>
+double FluidSolver<Real>::MaxDivergence() const {
+    int N = this->size;
+    double result = 0.0;
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                if (this->obstacles && this->obstacles->Get(i, j, k)) continue;
+
+                double div;
+                if (this->layout == layoutMAC) {
+                    div = double(N) * (double(this->Vx[IX(i+1, j, k)]) - this->Vx[IX(i, j, k)]
+                                     + double(this->Vy[IX(i, j+1, k)]) - this->Vy[IX(i, j, k)]
+                                     + double(this->Vz[IX(i, j, k+1)]) - this->Vz[IX(i, j, k)]);
+                }
+                else {
+                    div = 0.5 * N * (double(this->Vx[IX(i+1, j, k)]) - this->Vx[IX(i-1, j, k)]
+                                   + double(this->Vy[IX(i, j+1, k)]) - this->Vy[IX(i, j-1, k)]
+                                   + double(this->Vz[IX(i, j, k+1)]) - this->Vz[IX(i, j, k-1)]);
+                }
+                result = std::max(result, std::fabs(div));
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Real>
+void FluidSolver<Real>::FluidStep() {
+    // Bloki bez barwnika i ruchu pomijane w adwekcji i dyfuzji barwnika (tylko przy skipQuiet)
+    if (this->skipQuiet) this->update_activity();
+
+    switch (this->storage) {
+        case storageHalf:
+            step(reinterpret_cast<half_t*>(this->Vx016), reinterpret_cast<half_t*>(this->Vy016),
+                 reinterpret_cast<half_t*>(this->Vz016));
+            break;
+        case storageBFloat16:
+            step(reinterpret_cast<bfloat16_t*>(this->Vx016), reinterpret_cast<bfloat16_t*>(this->Vy016),
+                 reinterpret_cast<bfloat16_t*>(this->Vz016));
+            break;
+        default:
+            step(this->Vx0, this->Vy0, this->Vz0);
+            break;
+    }
+}
+
+template <typename Real>
+template <typename H>
+void FluidSolver<Real>::step(H *velX0, H *velY0, H *velZ0) {
+    if (this->vorticity > 0.0f) this->confine_vorticity();
+
+    this->diffuse(1, velX0, this->Vx, this->visc, this->dt);
+    this->diffuse(2, velY0, this->Vy, this->visc, this->dt);
+    this->diffuse(3, velZ0, this->Vz, this->visc, this->dt);
+
+    this->project(velX0, velY0, velZ0, this->Vx, this->Vy);
+
+    const VoxelGrid *active = this->skipQuiet ? &this->activity : nullptr;
+
+    this->advect(1, this->Vx, velX0, velX0, velY0, velZ0, this->dt, active);
+    this->advect(2, this->Vy, velY0, velX0, velY0, velZ0, this->dt, active);
+    this->advect(3, this->Vz, velZ0, velX0, velY0, velZ0, this->dt, active);
+
+    this->project(this->Vx, this->Vy, this->Vz, velX0, velY0);
+
+    this->diffuse(0, this->s, this->density, this->diff, this->dt, active);
+    this->advect(0, this->density, this->s, this->Vx, this->Vy, this->Vz, this->dt, active);
+}
+
+// Zanikanie barwnika -- każda komórka traci ułamek 'amount' swojej gęstości
+template <typename Real>
+void FluidSolver<Real>::fadeDensity(float amount) {
+    int N = this->size;
+    float keep = 1.0f - amount;
+    for (int i = 0; i < N * N * N; i++) {
+        this->density[i] *= keep;
+    }
+}
+
+template <typename Real>
+void FluidSolver<Real>::AddDensity(int x, int y, int z, float amount) {
     int N = this->size;
     int index = IX(x, y, z);
-    
+    this->density[index] += amount;
+}
+
+template <typename Real>
+void FluidSolver<Real>::AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ) {
+    int N = this->size;
+    int index = IX(x, y, z);
+
     this->Vx[index] += amountX;
     this->Vy[index] += amountY;
     this->Vz[index] += amountZ;
-}
\ No newline at end of file
+}
+
+template class FluidSolver<float>;
+template class FluidSolver<double>;
+
+// Jądra na tablicach float używane poza Fluid (NestedFluid)
+template void Fluid::set_bounds<float>(int, float*);
+template void Fluid::apply_obstacles<float>(int, float*);
+template void Fluid::lin_solve<float, float>(int, float*, float*, float, float, const VoxelGrid*);
+template void Fluid::diffuse<float, float>(int, float*, float*, float, float, const VoxelGrid*);
+template void Fluid::project<float, float>(float*, float*, float*, float*, float*);
+template void Fluid::solve_pressure<float>(float*, float*);
+template void Fluid::advect<float, float, float>(int, float*, float*, float*, float*, float*, float, const VoxelGrid*);
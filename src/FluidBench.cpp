@@ -0,0 +1,533 @@
+#include "FluidBench.h"
+#include "FluidEnsemble.h"
+#include "NestedFluid.h"
+#include "SparseFluid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+bool FluidBench::Dispatch(int argc, char** argv, int& exitCode) {
+    if (argc < 2) return false;
+
+    auto arg = [&](int index, int fallback) {
+        return argc > index ? std::max(std::atoi(argv[index]), 1) : fallback;
+    };
+
+    if (std::strcmp(argv[1], "--bench-precision") == 0) {
+        exitCode = Precision(arg(2, 64), arg(3, 100));
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--bench-divergence") == 0) {
+        FieldStorage storage = storageFloat;
+        if (argc > 4 && std::strcmp(argv[4], "half") == 0) storage = storageHalf;
+        else if (argc > 4 && std::strcmp(argv[4], "bfloat16") == 0) storage = storageBFloat16;
+        else if (argc > 4 && std::strcmp(argv[4], "float") != 0) {
+            std::cerr << "[ERROR] Nieznany typ pól: " << argv[4] << " (float / half / bfloat16)" << std::endl;
+            exitCode = 1;
+            return true;
+        }
+
+        exitCode = Divergence(arg(2, 48), arg(3, 100), storage);
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--bench-layout") == 0) {
+        exitCode = Layout(arg(2, 48), arg(3, 60));
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--bench-advection") == 0) {
+        exitCode = Advection(arg(2, 48), arg(3, 96));
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--bench-ensemble") == 0) {
+        exitCode = Ensemble(arg(2, 32), arg(3, 64), arg(4, 50));
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--bench-sparse") == 0) {
+        exitCode = Sparse(arg(2, 512), arg(3, 40), arg(4, 64));
+        return true;
+    }
+
+    if (std::strcmp(argv[1], "--bench-nested") == 0) {
+        exitCode = Nested(arg(2, 48), arg(3, 40));
+        return true;
+    }
+
+    return false;
+}
+
+template <typename Solver>
+void FluidBench::injectPlume(Solver& fluid) {
+    int c = fluid.size / 2;
+    for (int k = -1; k <= 1; k++)
+        for (int j = -1; j <= 1; j++)
+            for (int i = -1; i <= 1; i++) {
+                fluid.AddDensity(c + i, c + j, c / 2 + k, 5.0f);
+                fluid.AddVelocity(c + i, c + j, c / 2 + k, 0.0f, 0.0f, 0.5f);
+            }
+}
+
+int FluidBench::Precision(int size, int steps) {
+    if (size < 8) {
+        std::cerr << "[ERROR] Zbyt mała siatka do pomiaru: " << size << std::endl;
+        return 1;
+    }
+
+    const char *names[] = { "float", "half", "bfloat16" };
+    const FieldStorage modes[] = { storageFloat, storageHalf, storageBFloat16 };
+
+    std::unique_ptr<Fluid> fluids[3];
+    double ms[3] = { 0.0, 0.0, 0.0 };
+    for (int m = 0; m < 3; m++)
+        fluids[m] = std::make_unique<Fluid>(size, 0.1f, 4, 0.0f, 0.0000001f, modes[m]);
+
+    // Kroki na przemian, żeby wszystkie warianty widziały ten sam stan pamięci podręcznej
+    for (int step = 0; step < steps; step++) {
+        for (int m = 0; m < 3; m++) {
+            injectPlume(*fluids[m]);
+
+            auto start = std::chrono::steady_clock::now();
+            fluids[m]->FluidStep();
+            fluids[m]->fadeDensity(0.01f);
+            ms[m] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    const Fluid& ref = *fluids[0];
+    int total = size * size * size;
+
+    double maxDensity = 0.0, maxSpeed = 0.0;
+    for (int i = 0; i < total; i++) {
+        maxDensity = std::max(maxDensity, double(ref.density[i]));
+        maxSpeed = std::max(maxSpeed, double(std::fabs(ref.Vx[i]) + std::fabs(ref.Vy[i]) + std::fabs(ref.Vz[i])));
+    }
+
+    std::cout << "Precyzja pól: N = " << size << ", kroków = " << steps << "\n";
+    // Nagłówek wpisany ręcznie, setw liczy bajty, a nie znaki UTF-8
+    std::cout << "      pola     ms/krok   gęstość max    względny  prędkość max    względny\n";
+
+    for (int m = 0; m < 3; m++) {
+        const Fluid& f = *fluids[m];
+
+        double densityError = 0.0, speedError = 0.0;
+        for (int i = 0; i < total; i++) {
+            densityError = std::max(densityError, double(std::fabs(f.density[i] - ref.density[i])));
+            speedError = std::max(speedError, double(std::fabs(f.Vx[i] - ref.Vx[i])
+                                                   + std::fabs(f.Vy[i] - ref.Vy[i])
+                                                   + std::fabs(f.Vz[i] - ref.Vz[i])));
+        }
+
+        std::cout << std::setw(10) << names[m] << std::setw(12) << std::fixed << std::setprecision(2) << ms[m] / steps
+                  << std::setw(14) << std::scientific << std::setprecision(2) << densityError
+                  << std::setw(12) << densityError / std::max(maxDensity, 1e-30)
+                  << std::setw(14) << speedError
+                  << std::setw(12) << speedError / std::max(maxSpeed, 1e-30) << "\n";
+        std::cout << std::defaultfloat;
+    }
+
+    return 0;
+}
+
+int FluidBench::Divergence(int size, int steps, FieldStorage storage) {
+    if (size < 8) {
+        std::cerr << "[ERROR] Zbyt mała siatka do pomiaru: " << size << std::endl;
+        return 1;
+    }
+
+    Fluid fluid(size, 0.1f, 4, 0.0f, 0.0000001f, storage);
+    FluidSolver<double> reference(size, 0.1f, 4, 0.0f, 0.0000001f);
+
+    int total = size * size * size;
+    const float *fields[] = { fluid.density, fluid.Vx, fluid.Vy, fluid.Vz };
+    const double *refFields[] = { reference.density, reference.Vx, reference.Vy, reference.Vz };
+
+    std::cout << "Rozbieżność float względem double: N = " << size << ", kroków = " << steps << "\n";
+    std::cout << "   krok   gęstość max   gęstość rms        Vx max        Vy max        Vz max   gęstość wzgl.\n";
+
+    double worst = 0.0;
+    for (int step = 0; step < steps; step++) {
+        injectPlume(fluid);
+        injectPlume(reference);
+
+        fluid.FluidStep();
+        fluid.fadeDensity(0.01f);
+        reference.FluidStep();
+        reference.fadeDensity(0.01f);
+
+        double maxError[4] = { 0.0, 0.0, 0.0, 0.0 };
+        double sumSquares = 0.0, maxDensity = 0.0;
+        for (int f = 0; f < 4; f++) {
+            for (int i = 0; i < total; i++) {
+                double error = std::fabs(double(fields[f][i]) - refFields[f][i]);
+                maxError[f] = std::max(maxError[f], error);
+                if (f == 0) {
+                    sumSquares += error * error;
+                    maxDensity = std::max(maxDensity, refFields[f][i]);
+                }
+            }
+        }
+
+        double relative = maxError[0] / std::max(maxDensity, 1e-30);
+        worst = std::max(worst, relative);
+
+        std::cout << std::setw(7) << step + 1 << std::scientific << std::setprecision(3)
+                  << std::setw(14) << maxError[0] << std::setw(14) << std::sqrt(sumSquares / total)
+                  << std::setw(14) << maxError[1] << std::setw(14) << maxError[2] << std::setw(14) << maxError[3]
+                  << std::setw(16) << relative << "\n" << std::defaultfloat;
+    }
+
+    std::cout << "Największa względna rozbieżność gęstości: " << std::scientific << worst << std::defaultfloat << std::endl;
+    return 0;
+}
+
+int FluidBench::Layout(int size, int steps) {
+    if (size < 8) {
+        std::cerr << "[ERROR] Zbyt mała siatka do pomiaru: " << size << std::endl;
+        return 1;
+    }
+
+    const FluidLayout layouts[] = { layoutCollocated, layoutMAC };
+
+    std::cout << "Układ siatki: N = " << size << ", kroków = " << steps << "\n";
+    std::cout << "  iter     układ     ms/krok   div średnia    div ostatnia\n";
+
+    // Ostatni wiersz (iter = 0) -- dokładne ciśnienie z FastPoisson
+    for (int iter = 2; iter <= 64; iter *= 2) {
+        bool spectral = iter == 64;
+
+        for (int l = 0; l < 2; l++) {
+            Fluid fluid(size, 0.1f, spectral ? 4 : iter, 0.0f, 0.0000001f, storageFloat, layouts[l]);
+            fluid.pressure = spectral ? pressureSpectral : pressureIterative;
+
+            double ms = 0.0, divergence = 0.0, last = 0.0;
+            for (int step = 0; step < steps; step++) {
+                injectPlume(fluid);
+
+                auto start = std::chrono::steady_clock::now();
+                fluid.FluidStep();
+                fluid.fadeDensity(0.01f);
+                ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                last = fluid.MaxDivergence();
+                divergence += last;
+            }
+
+            // Nazwy układów ręcznie wyrównane, setw liczy bajty UTF-8
+            std::cout << std::setw(6) << (spectral ? 0 : iter) << "  " << (l == 0 ? "  zwykły" : "     MAC")
+                      << std::setw(12) << std::fixed << std::setprecision(2) << ms / steps
+                      << std::setw(14) << std::scientific << std::setprecision(3) << divergence / steps
+                      << std::setw(16) << last << "\n" << std::defaultfloat;
+        }
+    }
+
+    return 0;
+}
+
+int FluidBench::Advection(int size, int steps) {
+    if (size < 16) {
+        std::cerr << "[ERROR] Zbyt mała siatka do pomiaru: " << size << std::endl;
+        return 1;
+    }
+
+    std::cout << "Adwekcja, obrót kuli barwnika: N = " << size << ", kroków na obrót = " << steps << "\n";
+    std::cout << "      schemat     N     ms/krok   błąd L1 wzgl.   maksimum\n";
+
+    struct Run { const char *name; AdvectionScheme scheme; int size; };
+    const Run runs[] = {
+        { " półlagranżowski", advectSemiLagrangian, size },
+        { "      MacCormack", advectMacCormack, size },
+        { " półlagranżowski", advectSemiLagrangian, 2 * size },
+    };
+
+    for (const Run& run : runs) {
+        int N = run.size;
+        Fluid fluid(N, 0.1f, 4, 0.0f, 0.0f);
+        fluid.advection = run.scheme;
+
+        // Prędkość w jednostkach solvera: przesunięcie o dt * (N - 2) * u komórek na krok
+        float center = 0.5f * (N - 1);
+        float omega = 6.2831853f / steps / (fluid.dt * (N - 2));
+        float radius = N / 8.0f;
+
+        std::unique_ptr<float[]> initial(new float[N * N * N]());
+        for (int k = 0; k < N; k++)
+            for (int j = 0; j < N; j++)
+                for (int i = 0; i < N; i++) {
+                    int index = IX(i, j, k);
+                    fluid.Vx[index] = -(j - center) * omega;
+                    fluid.Vy[index] = (i - center) * omega;
+
+                    float dx = i - center - N / 4.0f, dy = j - center, dz = k - center;
+                    initial[index] = (dx * dx + dy * dy + dz * dz <= radius * radius) ? 1.0f : 0.0f;
+                    fluid.density[index] = initial[index];
+                }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; step++) {
+            fluid.advect(0, fluid.s, fluid.density, fluid.Vx, fluid.Vy, fluid.Vz, fluid.dt);
+            std::swap(fluid.s, fluid.density);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        double error = 0.0, mass = 0.0, peak = 0.0;
+        for (int i = 0; i < N * N * N; i++) {
+            error += std::fabs(fluid.density[i] - initial[i]);
+            mass += initial[i];
+            peak = std::max(peak, double(fluid.density[i]));
+        }
+
+        std::cout << run.name << std::setw(6) << N << std::fixed << std::setprecision(2)
+                  << std::setw(12) << ms / steps << std::setprecision(4)
+                  << std::setw(16) << error / mass << std::setw(11) << peak << "\n" << std::defaultfloat;
+    }
+
+    return 0;
+}
+
+int FluidBench::Ensemble(int size, int members, int steps) {
+    if (size < 8) {
+        std::cerr << "[ERROR] Zbyt mała siatka do pomiaru: " << size << std::endl;
+        return 1;
+    }
+
+    // Siatka 4 x 4 x 4 wartości, kolejni członkowie zmieniają najpierw dt, potem diff, potem visc
+    const float dts[] = { 0.05f, 0.1f, 0.15f, 0.2f };
+    const float diffs[] = { 0.0f, 0.000001f, 0.00001f, 0.0001f };
+    const float viscs[] = { 0.0f, 0.0000001f, 0.000001f, 0.00001f };
+
+    std::vector<EnsembleMember> sweep(members);
+    for (int m = 0; m < members; m++)
+        sweep[m] = { dts[m % 4], diffs[(m / 4) % 4], viscs[(m / 16) % 4] };
+
+    FluidEnsemble ensemble;
+    if (!ensemble.Create(size, 4, sweep)) return 1;
+
+    int c = size / 2;
+    auto inject = [&](auto&& add) {
+        for (int k = -1; k <= 1; k++)
+            for (int j = -1; j <= 1; j++)
+                for (int i = -1; i <= 1; i++) add(c + i, c + j, c / 2 + k);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (int m = 0; m < members; m++)
+            inject([&](int x, int y, int z) {
+                ensemble.AddDensity(m, x, y, z, 5.0f);
+                ensemble.AddVelocity(m, x, y, z, 0.0f, 0.0f, 0.5f);
+            });
+        ensemble.Step();
+        ensemble.fadeDensity(0.01f);
+    }
+    double ensembleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Te same parametry w osobnych instancjach Fluid (ciśnienie iteracyjne jak w zespole), jedna partia
+    int single = std::min(members, ensembleLanes);
+    double singleSeconds = 0.0, difference = 0.0;
+    for (int m = 0; m < single; m++) {
+        Fluid fluid(size, sweep[m].dt, 4, sweep[m].diff, sweep[m].visc);
+        fluid.pressure = pressureIterative;
+
+        start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; step++) {
+            injectPlume(fluid);
+            fluid.FluidStep();
+            fluid.fadeDensity(0.01f);
+        }
+        singleSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (int k = 0; k < size; k++)
+            for (int j = 0; j < size; j++)
+                for (int i = 0; i < size; i++)
+                    difference = std::max(difference, double(std::fabs(fluid.density[i + j * size + k * size * size]
+                                                                       - ensemble.Density(m, i, j, k))));
+    }
+
+    std::cout << "Zespół: N = " << size << ", członków = " << members << ", kroków = " << steps << "\n";
+    std::cout << " członek      dt      diff      visc        masa     energia   prędkość max\n";
+    for (int m = 0; m < members; m++) {
+        EnsembleStats stats = ensemble.Stats(m);
+        std::cout << std::setw(8) << m << std::fixed << std::setprecision(2) << std::setw(8) << sweep[m].dt
+                  << std::scientific << std::setprecision(1) << std::setw(10) << sweep[m].diff << std::setw(10) << sweep[m].visc
+                  << std::fixed << std::setprecision(1) << std::setw(12) << stats.mass
+                  << std::setprecision(3) << std::setw(12) << stats.kinetic << std::setw(15) << stats.maxSpeed << "\n";
+    }
+
+    std::cout << std::setprecision(0)
+              << "Zespół:        " << std::setw(10) << double(members) * steps / ensembleSeconds << " kroków członków/s\n"
+              << "Osobne Fluid:  " << std::setw(10) << double(single) * steps / singleSeconds << " kroków członków/s ("
+              << single << " członków)\n" << std::defaultfloat
+              << "Największa różnica gęstości względem Fluid: " << difference << "\n";
+
+    return 0;
+}
+
+int FluidBench::Sparse(int size, int steps, int compareSize) {
+    if (size < 16 || compareSize < 16) {
+        std::cerr << "[ERROR] Zbyt mała siatka do pomiaru: " << std::min(size, compareSize) << std::endl;
+        return 1;
+    }
+
+    // Gęsta Fluid (8 pól float) tylko jako wielkość odniesienia -- przy 512^3 to 4 GB
+    double denseMB = 8.0 * sizeof(float) * size * size * size / (1024.0 * 1024.0);
+
+    std::cout << "Rzadka siatka: N = " << size << ", kroków = " << steps
+              << ", gęsta Fluid = " << std::fixed << std::setprecision(0) << denseMB << " MB\n" << std::defaultfloat;
+    std::cout << "   krok   bloki    pamięć MB   % gęstej     ms/krok\n";
+
+    SparseFluid sparse(size, 0.1f, 4, 0.0f, 0.0000001f);
+    double ms = 0.0;
+    int report = std::max(steps / 8, 1);
+
+    for (int step = 1; step <= steps; step++) {
+        injectPlume(sparse);
+
+        auto start = std::chrono::steady_clock::now();
+        sparse.FluidStep();
+        sparse.fadeDensity(0.01f);
+        double stepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ms += stepMs;
+
+        if (step % report != 0 && step != steps) continue;
+
+        double mb = sparse.Bytes() / (1024.0 * 1024.0);
+        std::cout << std::setw(7) << step << std::setw(8) << sparse.ActiveBlocks()
+                  << std::setw(13) << std::fixed << std::setprecision(1) << mb
+                  << std::setw(11) << std::setprecision(3) << 100.0 * mb / denseMB
+                  << std::setw(12) << std::setprecision(2) << stepMs << "\n" << std::defaultfloat;
+    }
+    std::cout << "Średnio " << std::fixed << std::setprecision(2) << ms / steps << " ms/krok\n" << std::defaultfloat;
+
+    // Przy iter = 4 ciśnienie jest dalekie od zbieżności, więc różnicę daje sama kolejność relaksacji
+    // (Fluid wierszami, SparseFluid blokami czerwono-czarnie); przy iter = 30 zostaje różnica metod
+    int compareSteps = 20;
+    int total = compareSize * compareSize * compareSize;
+    std::vector<float> density(total);
+
+    std::cout << "\nSparseFluid wobec Fluid: N = " << compareSize << ", kroków = " << compareSteps << "\n";
+    std::cout << "  iter    maks. różnica   maks. gęstość   względna L2\n";
+
+    for (int iter : { 4, 30 }) {
+        Fluid dense(compareSize, 0.1f, iter, 0.0f, 0.0000001f);
+        dense.pressure = pressureIterative;
+        SparseFluid small(compareSize, 0.1f, iter, 0.0f, 0.0000001f);
+
+        for (int step = 0; step < compareSteps; step++) {
+            injectPlume(dense);
+            dense.FluidStep();
+            dense.fadeDensity(0.01f);
+
+            injectPlume(small);
+            small.FluidStep();
+            small.fadeDensity(0.01f);
+        }
+
+        small.CopyDensity(density.data());
+
+        double maxDiff = 0.0, maxDensity = 0.0, diff2 = 0.0, ref2 = 0.0;
+        for (int i = 0; i < total; i++) {
+            double d = density[i] - dense.density[i];
+            maxDiff = std::max(maxDiff, std::fabs(d));
+            maxDensity = std::max(maxDensity, static_cast<double>(dense.density[i]));
+            diff2 += d * d;
+            ref2 += static_cast<double>(dense.density[i]) * dense.density[i];
+        }
+
+        std::cout << std::setw(6) << iter << std::setw(17) << std::scientific << std::setprecision(3) << maxDiff
+                  << std::setw(16) << maxDensity
+                  << std::setw(14) << (ref2 > 0.0 ? std::sqrt(diff2 / ref2) : 0.0) << "\n" << std::defaultfloat;
+    }
+
+    return 0;
+}
+
+int FluidBench::Nested(int size, int steps) {
+    if (size < 32 || size % sparseBlockDim != 0) {
+        std::cerr << "[ERROR] Rozmiar musi być wielokrotnością " << sparseBlockDim << ", co najmniej 32: " << size << std::endl;
+        return 1;
+    }
+
+    // Płyta nad źródłem smugi -- zagęszcza swoje bloki i sąsiednie
+    int c = size / 2, top = 3 * size / 4;
+    VoxelGrid obstacles(size), fineObstacles(2 * size);
+    for (int z = top - 2; z < top + 2; z++)
+        for (int y = c - 3; y < c + 3; y++)
+            for (int x = c - 3; x < c + 3; x++) {
+                obstacles.Set(x, y, z, true);
+                for (int n = 0; n < 8; n++)
+                    fineObstacles.Set(2 * x + (n & 1), 2 * y + ((n >> 1) & 1), 2 * z + ((n >> 2) & 1), true);
+            }
+
+    std::cout << "Dwa poziomy: N = " << size << " (drobny " << 2 * size << "), kroków = " << steps << "\n";
+    std::cout << "                   div granicy      div granicy   div maks.     ms/krok   bloki   pamięć MB\n";
+    std::cout << "                       średnia         ostatnia     grubego\n";
+
+    const int cycles[] = { 1, 2, nestedPressureCycles, 2 * nestedPressureCycles };
+    for (int cycle : cycles) {
+        NestedFluid nested(size, 0.1f, 4, 0.0f, 0.0000001f);
+        nested.pressureCycles = cycle;
+        nested.SetObstacles(&obstacles, &fineObstacles);
+
+        double ms = 0.0, divergence = 0.0;
+        for (int step = 0; step < steps; step++) {
+            injectPlume(nested);
+
+            auto start = std::chrono::steady_clock::now();
+            nested.FluidStep();
+            nested.fadeDensity(0.01f);
+            ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            divergence += nested.InterfaceDivergence();
+        }
+
+        std::cout << "  przebiegi " << std::setw(2) << cycle
+                  << std::setw(16) << std::scientific << std::setprecision(3) << divergence / steps
+                  << std::setw(17) << nested.InterfaceDivergence()
+                  << std::setw(12) << nested.coarse.MaxDivergence()
+                  << std::setw(12) << std::fixed << std::setprecision(2) << ms / steps
+                  << std::setw(8) << nested.RefinedBlocks()
+                  << std::setw(12) << std::setprecision(1) << nested.Bytes() / (1024.0 * 1024.0) << "\n" << std::defaultfloat;
+    }
+
+    // Jednolita siatka 2N: źródło na tych samych 2x2x2 komórkach pod każdą komórką źródła grubego
+    Fluid uniform(2 * size, 0.1f, 4, 0.0f, 0.0000001f);
+    uniform.SetObstacles(&fineObstacles);
+
+    double ms = 0.0, divergence = 0.0;
+    for (int step = 0; step < steps; step++) {
+        for (int k = -1; k <= 1; k++)
+            for (int j = -1; j <= 1; j++)
+                for (int i = -1; i <= 1; i++)
+                    for (int n = 0; n < 8; n++) {
+                        int x = 2 * (c + i) + (n & 1), y = 2 * (c + j) + ((n >> 1) & 1), z = 2 * (c / 2 + k) + ((n >> 2) & 1);
+                        uniform.AddDensity(x, y, z, 5.0f);
+                        uniform.AddVelocity(x, y, z, 0.0f, 0.0f, 0.5f);
+                    }
+
+        auto start = std::chrono::steady_clock::now();
+        uniform.FluidStep();
+        uniform.fadeDensity(0.01f);
+        ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        divergence += uniform.MaxDivergence();
+    }
+
+    // Fluid: 8 tablic float (size^3) i maska przeszkód
+    size_t N = 2 * size;
+    double uniformMB = (8 * N * N * N * sizeof(float) + fineObstacles.Bytes()) / (1024.0 * 1024.0);
+    std::cout << "  Fluid " << std::setw(3) << N << "  div maks. średnia " << std::scientific << std::setprecision(3) << divergence / steps
+              << ", ms/krok " << std::fixed << std::setprecision(2) << ms / steps
+              << ", pamięć MB " << std::setprecision(1) << uniformMB << "\n" << std::defaultfloat;
+
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include "FluidEnsemble.h"
+#include "FluidStencil.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#define IX(x, y, z) ((x) + (y) * N + (z) * N * N)
+
+FluidEnsemble::FluidEnsemble() {
+    mSize = 0;
+    mIter = 0;
+}
+
+bool FluidEnsemble::Create(int size, int iter, const std::vector<EnsembleMember>& members) {
+    if (size < 4 || iter < 1 || members.empty()) {
+        std::cerr << "[ERROR] Niepoprawny zespół: rozmiar " << size << ", iteracje " << iter
+                  << ", członków " << members.size() << std::endl;
+        return false;
+    }
+
+    mSize = size;
+    mIter = iter;
+    mMembers = members;
+
+    // Puste tory ostatniej partii dostają parametry pierwszego członka i pozostają w spoczynku
+    size_t values = size_t(size) * size * size * ensembleLanes;
+    mBatches.assign((members.size() + ensembleLanes - 1) / ensembleLanes, Batch());
+    for (size_t b = 0; b < mBatches.size(); b++) {
+        Batch& batch = mBatches[b];
+        for (int f = 0; f < fieldCount; f++) batch.fields[f].assign(values, 0.0f);
+
+        for (int l = 0; l < ensembleLanes; l++) {
+            size_t m = b * ensembleLanes + l;
+            const EnsembleMember& member = members[m < members.size() ? m : 0];
+            batch.dt[l] = member.dt;
+            batch.diff[l] = member.diff;
+            batch.visc[l] = member.visc;
+        }
+    }
+
+    return true;
+}
+
+size_t FluidEnsemble::at(int member, int x, int y, int z) const {
+    int N = mSize;
+    return size_t(IX(x, y, z)) * ensembleLanes + member % ensembleLanes;
+}
+
+void FluidEnsemble::AddDensity(int member, int x, int y, int z, float amount) {
+    mBatches[member / ensembleLanes].fields[fDensity][at(member, x, y, z)] += amount;
+}
+
+void FluidEnsemble::AddVelocity(int member, int x, int y, int z, float amountX, float amountY, float amountZ) {
+    Batch& batch = mBatches[member / ensembleLanes];
+    size_t index = at(member, x, y, z);
+    batch.fields[fVx][index] += amountX;
+    batch.fields[fVy][index] += amountY;
+    batch.fields[fVz][index] += amountZ;
+}
+
+float FluidEnsemble::Density(int member, int x, int y, int z) const {
+    return mBatches[member / ensembleLanes].fields[fDensity][at(member, x, y, z)];
+}
+
+void FluidEnsemble::Step() {
+    ThreadPool::Instance().ParallelFor(0, static_cast<int>(mBatches.size()), [&](int begin, int end) {
+        for (int b = begin; b < end; b++) stepBatch(mBatches[b]);
+    }, 1);
+}
+
+void FluidEnsemble::fadeDensity(float amount) {
+    float keep = 1.0f - amount;
+    for (Batch& batch : mBatches)
+        for (float& value : batch.fields[fDensity]) value *= keep;
+}
+
+EnsembleStats FluidEnsemble::Stats(int member) const {
+    const Batch& batch = mBatches[member / ensembleLanes];
+    int l = member % ensembleLanes;
+    size_t cells = size_t(mSize) * mSize * mSize;
+
+    EnsembleStats stats = { 0.0, 0.0, 0.0f };
+    for (size_t i = 0; i < cells; i++) {
+        size_t index = i * ensembleLanes + l;
+        float vx = batch.fields[fVx][index], vy = batch.fields[fVy][index], vz = batch.fields[fVz][index];
+        float speed2 = vx * vx + vy * vy + vz * vz;
+
+        stats.mass += batch.fields[fDensity][index];
+        stats.kinetic += 0.5 * speed2;
+        stats.maxSpeed = std::max(stats.maxSpeed, std::sqrt(speed2));
+    }
+    return stats;
+}
+
+// Ta sama kolejność co Fluid::step
+void FluidEnsemble::stepBatch(Batch& batch) {
+    float *s = batch.fields[fS].data(), *density = batch.fields[fDensity].data();
+    float *Vx = batch.fields[fVx].data(), *Vy = batch.fields[fVy].data(), *Vz = batch.fields[fVz].data();
+    float *Vx0 = batch.fields[fVx0].data(), *Vy0 = batch.fields[fVy0].data(), *Vz0 = batch.fields[fVz0].data();
+
+    diffuse(1, Vx0, Vx, batch.visc, batch.dt);
+    diffuse(2, Vy0, Vy, batch.visc, batch.dt);
+    diffuse(3, Vz0, Vz, batch.visc, batch.dt);
+
+    project(Vx0, Vy0, Vz0, Vx, Vy);
+
+    advect(1, Vx, Vx0, Vx0, Vy0, Vz0, batch.dt);
+    advect(2, Vy, Vy0, Vx0, Vy0, Vz0, batch.dt);
+    advect(3, Vz, Vz0, Vx0, Vy0, Vz0, batch.dt);
+
+    project(Vx, Vy, Vz, Vx0, Vy0);
+
+    diffuse(0, s, density, batch.diff, batch.dt);
+    advect(0, density, s, Vx, Vy, Vz, batch.dt);
+}
+
+void FluidEnsemble::set_bounds(int b, float *x) const {
+    const int L = ensembleLanes;
+    int N = mSize;
+
+    auto mirror = [&](int to, int from, bool flip) {
+        float *dst = x + size_t(to) * L;
+        const float *src = x + size_t(from) * L;
+        for (int l = 0; l < L; l++) dst[l] = flip ? -src[l] : src[l];
+    };
+    auto corner = [&](int to, int p, int q, int r) {
+        float *dst = x + size_t(to) * L;
+        const float *a = x + size_t(p) * L, *b = x + size_t(q) * L, *c = x + size_t(r) * L;
+        for (int l = 0; l < L; l++) dst[l] = CornerCell(a[l], b[l], c[l]);
+    };
+
+    for (int j = 1; j < N - 1; j++) {
+        for (int i = 1; i < N - 1; i++) {
+            mirror(IX(i, j, 0  ), IX(i, j, 1  ), b == 3);
+            mirror(IX(i, j, N-1), IX(i, j, N-2), b == 3);
+        }
+    }
+    for (int k = 1; k < N - 1; k++) {
+        for (int i = 1; i < N - 1; i++) {
+            mirror(IX(i, 0  , k), IX(i, 1  , k), b == 2);
+            mirror(IX(i, N-1, k), IX(i, N-2, k), b == 2);
+        }
+    }
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            mirror(IX(0  , j, k), IX(1  , j, k), b == 1);
+            mirror(IX(N-1, j, k), IX(N-2, j, k), b == 1);
+        }
+    }
+
+    corner(IX(0, 0, 0),       IX(1, 0, 0),       IX(0, 1, 0),       IX(0, 0, 1));
+    corner(IX(0, N-1, 0),     IX(1, N-1, 0),     IX(0, N-2, 0),     IX(0, N-1, 1));
+    corner(IX(0, 0, N-1),     IX(1, 0, N-1),     IX(0, 1, N-1),     IX(0, 0, N-2));
+    corner(IX(0, N-1, N-1),   IX(1, N-1, N-1),   IX(0, N-2, N-1),   IX(0, N-1, N-2));
+    corner(IX(N-1, 0, 0),     IX(N-2, 0, 0),     IX(N-1, 1, 0),     IX(N-1, 0, 1));
+    corner(IX(N-1, N-1, 0),   IX(N-2, N-1, 0),   IX(N-1, N-2, 0),   IX(N-1, N-1, 1));
+    corner(IX(N-1, 0, N-1),   IX(N-2, 0, N-1),   IX(N-1, 1, N-1),   IX(N-1, 0, N-2));
+    corner(IX(N-1, N-1, N-1), IX(N-2, N-1, N-1), IX(N-1, N-2, N-1), IX(N-1, N-1, N-2));
+}
+
+// Gauss-Seidel wzdłuż wiersza jak w Fluid::lin_solve; zależność od x[i-1] jest w obrębie członka,
+// więc pętla po torach jest niezależna i wektorowa
+void FluidEnsemble::lin_solve(int b, float *x, const float *x0, const float *a, const float *c) const {
+    const int L = ensembleLanes;
+    int N = mSize;
+    size_t sx = L, sy = size_t(N) * L, sz = size_t(N) * N * L;
+
+    // Lokalne kopie, żeby kompilator nie musiał zakładać, że zapis do x zmienia a
+    float aLane[L], cRecip[L];
+    for (int l = 0; l < L; l++) {
+        aLane[l] = a[l];
+        cRecip[l] = 1.0f / c[l];
+    }
+
+    for (int it = 0; it < mIter; it++) {
+        for (int m = 1; m < N - 1; m++) {
+            for (int j = 1; j < N - 1; j++) {
+                for (int i = 1; i < N - 1; i++) {
+                    size_t index = size_t(IX(i, j, m)) * L;
+                    float *v = x + index;
+                    const float *v0 = x0 + index;
+
+                    // Najpierw wszystkie odczyty, potem zapis -- przesunięcia sy / sz nie są znane
+                    // w czasie kompilacji, a tak tory składają się w jeden wektor
+                    float next[L];
+                    for (int l = 0; l < L; l++) {
+                        next[l] = RelaxCell(v0[l], aLane[l], cRecip[l],
+                                            v[l + sx], v[l - sx], v[l + sy], v[l - sy], v[l + sz], v[l - sz]);
+                    }
+                    for (int l = 0; l < L; l++) v[l] = next[l];
+                }
+            }
+        }
+        set_bounds(b, x);
+    }
+}
+
+void FluidEnsemble::diffuse(int b, float *x, const float *x0, const float *coefficient, const float *dt) const {
+    const int L = ensembleLanes;
+    int N = mSize;
+
+    float a[L], c[L];
+    for (int l = 0; l < L; l++) {
+        a[l] = dt[l] * coefficient[l] * (N - 2) * (N - 2);
+        c[l] = 1 + 6 * a[l];
+    }
+    lin_solve(b, x, x0, a, c);
+}
+
+void FluidEnsemble::project(float *velX, float *velY, float *velZ, float *p, float *div) const {
+    const int L = ensembleLanes;
+    int N = mSize;
+    size_t sx = L, sy = size_t(N) * L, sz = size_t(N) * N * L;
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                size_t index = size_t(IX(i, j, k)) * L;
+                for (int l = 0; l < L; l++) {
+                    size_t v = index + l;
+                    div[v] = DivergenceCell(velX[v + sx], velX[v - sx], velY[v + sy], velY[v - sy],
+                                            velZ[v + sz], velZ[v - sz], N);
+                    p[v] = 0.0f;
+                }
+            }
+        }
+    }
+
+    set_bounds(0, div);
+    set_bounds(0, p);
+
+    float one[L], six[L];
+    std::fill_n(one, L, 1.0f);
+    std::fill_n(six, L, 6.0f);
+    lin_solve(0, p, div, one, six);
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                size_t index = size_t(IX(i, j, k)) * L;
+                for (int l = 0; l < L; l++) {
+                    size_t v = index + l;
+                    velX[v] -= GradientCell(p[v + sx], p[v - sx], N);
+                    velY[v] -= GradientCell(p[v + sy], p[v - sy], N);
+                    velZ[v] -= GradientCell(p[v + sz], p[v - sz], N);
+                }
+            }
+        }
+    }
+    set_bounds(1, velX);
+    set_bounds(2, velY);
+    set_bounds(3, velZ);
+}
+
+// Adwekcja półlagranżowska jak w Fluid::advect
+void FluidEnsemble::advect(int b, float *d, const float *d0, const float *velX, const float *velY, const float *velZ, const float *dt) const {
+    const int L = ensembleLanes;
+    int N = mSize;
+
+    float dtN[L];
+    for (int l = 0; l < L; l++) dtN[l] = dt[l] * (N - 2);
+    size_t sx = L, sy = size_t(N) * L, sz = size_t(N) * N * L;
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                size_t index = size_t(IX(i, j, k)) * L;
+
+                for (int l = 0; l < L; l++) {
+                    float x = ClampBacktrace(i - dtN[l] * velX[index + l], N);
+                    float y = ClampBacktrace(j - dtN[l] * velY[index + l], N);
+                    float z = ClampBacktrace(k - dtN[l] * velZ[index + l], N);
+
+                    int i0 = int(x), j0 = int(y), k0 = int(z);
+                    const float *c = d0 + size_t(IX(i0, j0, k0)) * L + l;
+
+                    float corners[8] = {
+                        c[0],       c[sz],
+                        c[sy],      c[sy + sz],
+                        c[sx],      c[sx + sz],
+                        c[sx + sy], c[sx + sy + sz]
+                    };
+                    d[index + l] = TrilinearCell(corners, x - i0, y - j0, z - k0);
+                }
+            }
+        }
+    }
+    set_bounds(b, d);
+}
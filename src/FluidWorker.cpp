@@ -0,0 +1,58 @@
+#include "FluidWorker.h"
+#include "ThreadPool.h"
+
+FluidWorker::FluidWorker(Fluid& fluid, float fade) : mFluid(fluid), mFade(fade) {
+    // Pula musi powstać przed wątkiem kroku, żeby zniszczyć się dopiero po jego zatrzymaniu
+    ThreadPool::Instance();
+
+    mPending = false;
+    mStop = false;
+    mLastStepNs = 0;
+    mThread = std::thread(&FluidWorker::workerLoop, this);
+}
+
+FluidWorker::~FluidWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+}
+
+void FluidWorker::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending = true;
+    }
+    mWake.notify_one();
+}
+
+void FluidWorker::Wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [&] { return !mPending; });
+}
+
+void FluidWorker::workerLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&] { return mStop || mPending; });
+            if (mStop) return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        mFluid.FluidStep();
+        mFluid.fadeDensity(mFade);
+
+        auto stepTime = std::chrono::steady_clock::now() - start;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mLastStepNs = std::chrono::duration_cast<std::chrono::nanoseconds>(stepTime).count();
+            mPending = false;
+        }
+        mDone.notify_all();
+    }
+}
@@ -0,0 +1,32 @@
+#include "FramePacer.h"
+
+#include <thread>
+
+FramePacer::FramePacer() {
+    mVsync = false;
+    SetRate(60);
+}
+
+void FramePacer::SetRate(int framesPerSecond) {
+    mPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+    mNext = Clock::now() + mPeriod;
+}
+
+void FramePacer::Wait() {
+    Clock::time_point now = Clock::now();
+
+    if (!mVsync) {
+        // Zgrubne uśpienie, potem dokładne dojście do terminu
+        if (mNext - now > pacerSpinMargin)
+            std::this_thread::sleep_for(mNext - now - pacerSpinMargin);
+
+        while (Clock::now() < mNext)
+            std::this_thread::yield();
+
+        now = Clock::now();
+    }
+
+    // Klatka spóźniona o więcej niż okres -- nie nadrabiamy zaległych klatek
+    mNext += mPeriod;
+    if (now - mNext > mPeriod) mNext = now + mPeriod;
+}
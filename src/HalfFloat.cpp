@@ -0,0 +1,115 @@
+#include "HalfFloat.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HALF_FLOAT_X86 1
+#endif
+
+#if HALF_FLOAT_X86
+
+__attribute__((target("avx,f16c")))
+static void halfToFloatF16C(const half_t *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+    }
+    for (; i < n; i++) out[i] = HalfToFloat(in[i].bits);
+}
+
+__attribute__((target("avx,f16c")))
+static void floatToHalfF16C(const float *in, half_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+    for (; i < n; i++) out[i].bits = FloatToHalf(in[i]);
+}
+
+// bfloat16 to górne 16 bitów float -- przesunięcie o 16 bitów, 8 wartości naraz
+__attribute__((target("avx2")))
+static void bfloat16ToFloatAVX2(const bfloat16_t *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_slli_epi32(h, 16));
+    }
+    for (; i < n; i++) out[i] = BFloat16ToFloat(in[i].bits);
+}
+
+// Zaokrąglenie jak w FloatToBFloat16: + 0x7FFF + najmłodszy bit wyniku, NaN przez osobną gałąź
+__attribute__((target("avx2")))
+static void floatToBFloat16AVX2(const float *in, bfloat16_t *out, size_t n) {
+    const __m256i one = _mm256_set1_epi32(1), bias = _mm256_set1_epi32(0x7FFF);
+    const __m256i absMask = _mm256_set1_epi32(0x7FFFFFFF), inf = _mm256_set1_epi32(0x7F800000);
+    const __m256i quiet = _mm256_set1_epi32(0x00400000);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+        __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb));
+
+        __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(bits, absMask), inf);
+        rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(bits, quiet), nan);
+
+        // Górne połówki 32-bitowych słów, packus działa w obrębie 128-bitowych połówek rejestru
+        __m256i high = _mm256_srli_epi32(rounded, 16);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(high, high), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    for (; i < n; i++) out[i].bits = FloatToBFloat16(in[i]);
+}
+
+static bool hasF16C() {
+    static const bool supported = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+    return supported;
+}
+
+static bool hasAVX2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif
+
+void HalfToFloatArray(const half_t *in, float *out, size_t n) {
+#if HALF_FLOAT_X86
+    if (hasF16C()) {
+        halfToFloatF16C(in, out, n);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) out[i] = HalfToFloat(in[i].bits);
+}
+
+void FloatToHalfArray(const float *in, half_t *out, size_t n) {
+#if HALF_FLOAT_X86
+    if (hasF16C()) {
+        floatToHalfF16C(in, out, n);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) out[i].bits = FloatToHalf(in[i]);
+}
+
+void BFloat16ToFloatArray(const bfloat16_t *in, float *out, size_t n) {
+#if HALF_FLOAT_X86
+    if (hasAVX2()) {
+        bfloat16ToFloatAVX2(in, out, n);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) out[i] = BFloat16ToFloat(in[i].bits);
+}
+
+void FloatToBFloat16Array(const float *in, bfloat16_t *out, size_t n) {
+#if HALF_FLOAT_X86
+    if (hasAVX2()) {
+        floatToBFloat16AVX2(in, out, n);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) out[i].bits = FloatToBFloat16(in[i]);
+}
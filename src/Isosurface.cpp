@@ -0,0 +1,513 @@
+#include "Isosurface.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const int cornerOffset[8][3] = {
+    {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}
+};
+
+static const int edgeCorners[12][2] = {
+    {0,1}, {1,2}, {2,3}, {3,0}, {4,5}, {5,6}, {6,7}, {7,4}, {0,4}, {1,5}, {2,6}, {3,7}
+};
+
+// Ściany sześcianu, narożniki przeciwnie do ruchu wskazówek zegara patrząc z zewnątrz
+static const int faceCorners[6][4] = {
+    {0,3,2,1}, {4,5,6,7}, {0,1,5,4}, {3,7,6,2}, {0,4,7,3}, {1,2,6,5}
+};
+
+static int edgeBetween(int a, int b) {
+    for (int e = 0; e < 12; e++)
+        if ((edgeCorners[e][0] == a && edgeCorners[e][1] == b) || (edgeCorners[e][0] == b && edgeCorners[e][1] == a))
+            return e;
+    return -1;
+}
+
+// Generowanie tablic z odcinków na ścianach sześcianu:
+// idąc po ścianie, każdy odcinek łączy krawędź wejścia do wnętrza z następną krawędzią wyjścia.
+// Na ścianach niejednoznacznych narożniki wewnętrzne są więc zawsze rozdzielone -- ta sama reguła
+// po obu stronach wspólnej ściany daje szczelną powierzchnię. Odcinki tworzą zamknięte pętle,
+// które dzielimy na trójkąty wachlarzem.
+static void buildTables(MarchingCubesTables& t) {
+    for (int config = 0; config < 256; config++) {
+        auto inside = [&](int corner) { return (config >> corner) & 1; };
+
+        int next[12];
+        std::fill(next, next + 12, -1);
+        uint16_t mask = 0;
+
+        for (const auto& face : faceCorners) {
+            int edges[4];
+            bool entry[4], exit[4];
+            for (int i = 0; i < 4; i++) {
+                int a = face[i], b = face[(i + 1) % 4];
+                edges[i] = edgeBetween(a, b);
+                entry[i] = !inside(a) && inside(b);
+                exit[i] = inside(a) && !inside(b);
+            }
+
+            for (int i = 0; i < 4; i++) {
+                if (!entry[i]) continue;
+                for (int k = 1; k < 4; k++) {
+                    int j = (i + k) % 4;
+                    if (exit[j]) {
+                        next[edges[i]] = edges[j];
+                        break;
+                    }
+                }
+            }
+        }
+
+        int count = 0;
+        bool used[12] = {};
+        for (int start = 0; start < 12; start++) {
+            if (next[start] < 0 || used[start]) continue;
+
+            int loop[12];
+            int length = 0;
+            for (int e = start; !used[e]; e = next[e]) {
+                used[e] = true;
+                loop[length++] = e;
+                mask |= uint16_t(1) << e;
+            }
+
+            // Pętla biegnie przeciwnie do ruchu wskazówek patrząc z zewnątrz,
+            // więc trójkąty wachlarza mają normalną skierowaną na zewnątrz
+            for (int k = 1; k + 1 < length; k++) {
+                t.triangles[config][count++] = static_cast<int8_t>(loop[0]);
+                t.triangles[config][count++] = static_cast<int8_t>(loop[k]);
+                t.triangles[config][count++] = static_cast<int8_t>(loop[k + 1]);
+            }
+        }
+
+        t.edgeMask[config] = mask;
+        t.triangleCount[config] = static_cast<uint8_t>(count / 3);
+        std::fill(t.triangles[config] + count, t.triangles[config] + 16, int8_t(-1));
+    }
+}
+
+const MarchingCubesTables& MarchingCubesTables::Get() {
+    static MarchingCubesTables sTables = [] {
+        MarchingCubesTables t;
+        buildTables(t);
+        return t;
+    }();
+    return sTables;
+}
+
+// Gradient pola w punkcie siatki (różnice centralne, jednostronne na brzegach)
+static inline glm::vec3 gradientAt(const float* f, int N, int x, int y, int z) {
+    auto at = [&](int i, int j, int k) { return f[i + j * N + k * N * N]; };
+
+    int x0 = std::max(x - 1, 0), x1 = std::min(x + 1, N - 1);
+    int y0 = std::max(y - 1, 0), y1 = std::min(y + 1, N - 1);
+    int z0 = std::max(z - 1, 0), z1 = std::min(z + 1, N - 1);
+
+    return glm::vec3((at(x1, y, z) - at(x0, y, z)) / float(x1 - x0),
+                     (at(x, y1, z) - at(x, y0, z)) / float(y1 - y0),
+                     (at(x, y, z1) - at(x, y, z0)) / float(z1 - z0));
+}
+
+// Punkt siatki na krawędzi od (x, y, z) w kierunku 'axis': pozycja i normalna z gradientu
+static inline void edgeVertex(const float* f, int N, float iso, float cellSize, const glm::vec3& origin,
+                              int x, int y, int z, int axis, float* position, float* normal) {
+    int dx = axis == 0, dy = axis == 1, dz = axis == 2;
+    size_t a = x + y * size_t(N) + z * size_t(N) * N;
+    size_t b = a + dx + dy * size_t(N) + dz * size_t(N) * N;
+
+    float t = (iso - f[a]) / (f[b] - f[a]);
+    glm::vec3 p = origin + (glm::vec3(x, y, z) + t * glm::vec3(dx, dy, dz)) * cellSize;
+
+    glm::vec3 g = glm::mix(gradientAt(f, N, x, y, z), gradientAt(f, N, x + dx, y + dy, z + dz), t);
+    float len = glm::length(g);
+    glm::vec3 n = len > 0.0f ? -g / len : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    position[0] = p.x; position[1] = p.y; position[2] = p.z;
+    normal[0] = n.x;   normal[1] = n.y;   normal[2] = n.z;
+}
+
+// Wierzchołki wszystkich przeciętych krawędzi X i Y płaszczyzny z, identyfikatory w planeX / planeY
+static void extractPlane(const float* f, int N, float iso, float cellSize, const glm::vec3& origin, int z,
+                         std::vector<uint32_t>& planeX, std::vector<uint32_t>& planeY, IsoMesh& out) {
+    const uint32_t none = UINT32_MAX;
+    const size_t plane = size_t(N) * N;
+    const float* p = f + z * plane;
+
+    planeX.assign(plane, none);
+    planeY.assign(plane, none);
+
+    auto vertexOn = [&](int x, int y, int axis) -> uint32_t {
+        float position[3], normal[3];
+        edgeVertex(f, N, iso, cellSize, origin, x, y, z, axis, position, normal);
+        out.positions.insert(out.positions.end(), { position[0], position[1], position[2] });
+        out.normals.insert(out.normals.end(), { normal[0], normal[1], normal[2] });
+        return static_cast<uint32_t>(out.positions.size() / 3 - 1);
+    };
+
+    for (int y = 0; y < N; y++) {
+        for (int x = 0; x < N; x++) {
+            size_t slot = x + y * size_t(N);
+            bool in = p[slot] > iso;
+            if (x < N - 1 && in != (p[slot + 1] > iso)) planeX[slot] = vertexOn(x, y, 0);
+            if (y < N - 1 && in != (p[slot + N] > iso)) planeY[slot] = vertexOn(x, y, 1);
+        }
+    }
+}
+
+// Jedna warstwa komórek z in [z0, z1). Wierzchołki dolnej płaszczyzny są już w slab.bottomX/Y,
+// górnej w topX/Y (dolna płaszczyzna następnej warstwy -- identyfikatory z bitem nextSlabVertex
+// albo własna górna płaszczyzna ostatniej warstwy). Płaszczyzny pośrednie wypełniane są w trakcie.
+static const uint32_t nextSlabVertex = 0x80000000u;
+
+void MarchingCubes::extractSlab(const float* f, int N, float iso, float cellSize, const glm::vec3& origin,
+                                int z0, int z1, Slab& slab, const std::vector<uint32_t>& topX, const std::vector<uint32_t>& topY) {
+    const MarchingCubesTables& tables = MarchingCubesTables::Get();
+    const uint32_t none = UINT32_MAX;
+    const size_t plane = size_t(N) * N;
+    IsoMesh& out = slab.mesh;
+
+    slab.zEdges.resize(plane);
+    for (int p = 0; p < 2; p++) {
+        slab.xEdges[p].resize(plane);
+        slab.yEdges[p].resize(plane);
+    }
+
+    auto vertexOn = [&](int x, int y, int z, int axis) -> uint32_t {
+        float p[3], n[3];
+        edgeVertex(f, N, iso, cellSize, origin, x, y, z, axis, p, n);
+        out.positions.insert(out.positions.end(), { p[0], p[1], p[2] });
+        out.normals.insert(out.normals.end(), { n[0], n[1], n[2] });
+        return static_cast<uint32_t>(out.positions.size() / 3 - 1);
+    };
+
+    for (int z = z0; z < z1; z++) {
+        // Płaszczyzny gotowe (dolna / górna warstwy) mają wszystkie przecięte krawędzie wypełnione
+        // i są tylko czytane; pośrednie idą na przemian przez xEdges / yEdges[0..1]
+        int cached = (z + 1 - z0) & 1;
+        uint32_t* lowerX = z == z0 ? slab.bottomX.data() : slab.xEdges[cached ^ 1].data();
+        uint32_t* lowerY = z == z0 ? slab.bottomY.data() : slab.yEdges[cached ^ 1].data();
+        uint32_t* upperX = const_cast<uint32_t*>(topX.data());
+        uint32_t* upperY = const_cast<uint32_t*>(topY.data());
+        if (z + 1 < z1) {
+            std::fill(slab.xEdges[cached].begin(), slab.xEdges[cached].end(), none);
+            std::fill(slab.yEdges[cached].begin(), slab.yEdges[cached].end(), none);
+            upperX = slab.xEdges[cached].data();
+            upperY = slab.yEdges[cached].data();
+        }
+        std::fill(slab.zEdges.begin(), slab.zEdges.end(), none);
+
+        for (int y = 0; y < N - 1; y++) {
+            for (int x = 0; x < N - 1; x++) {
+                size_t base = x + y * size_t(N) + z * plane;
+
+                int config = 0;
+                for (int c = 0; c < 8; c++) {
+                    size_t idx = base + cornerOffset[c][0] + cornerOffset[c][1] * size_t(N) + cornerOffset[c][2] * plane;
+                    if (f[idx] > iso) config |= 1 << c;
+                }
+                if (config == 0 || config == 255) continue;
+
+                // Wierzchołki na przeciętych krawędziach komórki (z pamięci podręcznej krawędzi)
+                uint32_t ids[12];
+                uint16_t mask = tables.edgeMask[config];
+                for (int e = 0; e < 12; e++) {
+                    if (!(mask & (1 << e))) continue;
+
+                    const int* ca = cornerOffset[edgeCorners[e][0]];
+                    const int* cb = cornerOffset[edgeCorners[e][1]];
+                    int ex = x + std::min(ca[0], cb[0]);
+                    int ey = y + std::min(ca[1], cb[1]);
+                    int ez = z + std::min(ca[2], cb[2]);
+                    int axis = ca[0] != cb[0] ? 0 : (ca[1] != cb[1] ? 1 : 2);
+
+                    size_t slot = ex + ey * size_t(N);
+                    uint32_t& id = axis == 2 ? slab.zEdges[slot]
+                                 : (axis == 0 ? (ez == z ? lowerX : upperX)[slot]
+                                              : (ez == z ? lowerY : upperY)[slot]);
+                    if (id == none) id = vertexOn(ex, ey, ez, axis);
+                    ids[e] = id;
+                }
+
+                for (const int8_t* tri = tables.triangles[config]; *tri >= 0; tri++)
+                    out.indices.push_back(ids[*tri]);
+            }
+        }
+    }
+}
+
+void MarchingCubes::Extract(const float* field, int N, float iso, float cellSize, const glm::vec3& origin, IsoMesh& out) {
+    ThreadPool& pool = ThreadPool::Instance();
+
+    // Kilka warstw na wątek; każda warstwa ma swój bufor i pamięć krawędzi, używane ponownie w następnych klatkach
+    const int cells = N - 1;
+    const int slabCount = std::max(1, std::min(cells, 2 * pool.ThreadCount()));
+    mSlabs.resize(slabCount);
+
+    MarchingCubesTables::Get();
+
+    auto slabBegin = [&](int s) { return cells * s / slabCount; };
+
+    // 1. dolna płaszczyzna każdej warstwy (i górna płaszczyzna siatki) -- wierzchołki na granicy warstw
+    //    powstają raz, w warstwie powyżej granicy
+    pool.ParallelFor(0, slabCount, [&](int begin, int end) {
+        for (int s = begin; s < end; s++) {
+            Slab& slab = mSlabs[s];
+            slab.mesh.Clear();
+            extractPlane(field, N, iso, cellSize, origin, slabBegin(s), slab.bottomX, slab.bottomY, slab.mesh);
+            if (s == slabCount - 1)
+                extractPlane(field, N, iso, cellSize, origin, cells, mTopX, mTopY, slab.mesh);
+        }
+    }, 1);
+
+    // Górna płaszczyzna warstwy s to dolna warstwy s + 1, z identyfikatorami oznaczonymi bitem nextSlabVertex
+    for (int s = 0; s + 1 < slabCount; s++) {
+        const Slab& next = mSlabs[s + 1];
+        Slab& slab = mSlabs[s];
+        slab.topX.resize(next.bottomX.size());
+        slab.topY.resize(next.bottomY.size());
+        for (size_t i = 0; i < next.bottomX.size(); i++) {
+            slab.topX[i] = next.bottomX[i] == UINT32_MAX ? UINT32_MAX : next.bottomX[i] | nextSlabVertex;
+            slab.topY[i] = next.bottomY[i] == UINT32_MAX ? UINT32_MAX : next.bottomY[i] | nextSlabVertex;
+        }
+    }
+
+    // 2. komórki warstw
+    pool.ParallelFor(0, slabCount, [&](int begin, int end) {
+        for (int s = begin; s < end; s++) {
+            Slab& slab = mSlabs[s];
+            bool last = s == slabCount - 1;
+            extractSlab(field, N, iso, cellSize, origin, slabBegin(s), slabBegin(s + 1), slab,
+                        last ? mTopX : slab.topX, last ? mTopY : slab.topY);
+        }
+    }, 1);
+
+    // Złączenie warstw -- indeksy przesunięte o liczbę wierzchołków wcześniejszych warstw
+    std::vector<size_t> vertexBase(slabCount + 1, 0), indexBase(slabCount + 1, 0);
+    for (int s = 0; s < slabCount; s++) {
+        vertexBase[s + 1] = vertexBase[s] + mSlabs[s].mesh.positions.size() / 3;
+        indexBase[s + 1] = indexBase[s] + mSlabs[s].mesh.indices.size();
+    }
+
+    out.positions.resize(3 * vertexBase[slabCount]);
+    out.normals.resize(3 * vertexBase[slabCount]);
+    out.indices.resize(indexBase[slabCount]);
+
+    pool.ParallelFor(0, slabCount, [&](int begin, int end) {
+        for (int s = begin; s < end; s++) {
+            const IsoMesh& slab = mSlabs[s].mesh;
+            std::copy(slab.positions.begin(), slab.positions.end(), out.positions.begin() + 3 * vertexBase[s]);
+            std::copy(slab.normals.begin(), slab.normals.end(), out.normals.begin() + 3 * vertexBase[s]);
+
+            uint32_t base = static_cast<uint32_t>(vertexBase[s]);
+            uint32_t nextBase = static_cast<uint32_t>(vertexBase[s + 1]);
+            uint32_t* dst = out.indices.data() + indexBase[s];
+            for (uint32_t idx : slab.indices)
+                *dst++ = (idx & nextSlabVertex) ? (idx & ~nextSlabVertex) + nextBase : idx + base;
+        }
+    }, 1);
+}
+
+// Bity przypadku krawędzi punktu w mEdgeCases
+static const uint8_t edgeCutX = 1, edgeCutY = 2, edgeCutZ = 4, pointInside = 8;
+
+void FlyingEdges::Extract(const float* f, int N, float iso, float cellSize, const glm::vec3& origin, IsoMesh& out) {
+    const MarchingCubesTables& tables = MarchingCubesTables::Get();
+    ThreadPool& pool = ThreadPool::Instance();
+
+    const size_t plane = size_t(N) * N;
+    const int cells = N - 1;
+
+    mPointRows.resize(plane);
+    mCellRows.resize(size_t(cells) * cells);
+    mEdgeCases.resize(plane * N);
+    mConfigs.resize(size_t(cells) * cells * cells);
+
+    // 1a. przebieg: przypadki krawędzi wszystkich punktów, zliczanie i przycinanie wierszy punktów
+    pool.ParallelFor(0, N, [&](int zb, int ze) {
+        for (int z = zb; z < ze; z++) {
+            for (int y = 0; y < N; y++) {
+                const float* row = f + y * size_t(N) + z * plane;
+                const float* rowY = y < cells ? row + N : nullptr;
+                const float* rowZ = z < cells ? row + plane : nullptr;
+                uint8_t* cases = &mEdgeCases[y * size_t(N) + z * plane];
+
+                PointRow& info = mPointRows[y + size_t(z) * N];
+                info.edges[0] = info.edges[1] = info.edges[2] = 0;
+                info.xl = N;
+                info.xr = -1;
+
+                bool in = row[0] > iso;
+                for (int x = 0; x < N; x++) {
+                    bool inX = x < cells && row[x + 1] > iso;
+                    uint8_t c = in ? pointInside : 0;
+                    if (x < cells && in != inX) c |= edgeCutX;
+                    if (rowY && in != (rowY[x] > iso)) c |= edgeCutY;
+                    if (rowZ && in != (rowZ[x] > iso)) c |= edgeCutZ;
+                    cases[x] = c;
+
+                    if (c & (edgeCutX | edgeCutY | edgeCutZ)) {
+                        info.edges[0] += (c & edgeCutX) != 0;
+                        info.edges[1] += (c & edgeCutY) != 0;
+                        info.edges[2] += (c & edgeCutZ) != 0;
+                        info.xl = std::min(info.xl, x);
+                        info.xr = x;
+                    }
+                    in = inX;
+                }
+            }
+        }
+    }, 1);
+
+    // 1b. przebieg: przypadki komórek z bitów "wewnątrz" czterech wierszy punktów, zliczanie trójkątów
+    pool.ParallelFor(0, cells, [&](int zb, int ze) {
+        for (int z = zb; z < ze; z++) {
+            for (int y = 0; y < cells; y++) {
+                const uint8_t* r00 = &mEdgeCases[y * size_t(N) + z * plane];
+                const uint8_t* r10 = r00 + N;
+                const uint8_t* r01 = r00 + plane;
+                const uint8_t* r11 = r01 + N;
+
+                CellRow& info = mCellRows[y + size_t(z) * cells];
+                info.triangles = 0;
+                info.xl = cells;
+                info.xr = -1;
+
+                // Bez przeciętych krawędzi w żadnym z wierszy wszystkie komórki są puste lub pełne
+                const PointRow* rows[4] = {
+                    &mPointRows[y + size_t(z) * N],     &mPointRows[y + 1 + size_t(z) * N],
+                    &mPointRows[y + size_t(z + 1) * N], &mPointRows[y + 1 + size_t(z + 1) * N]
+                };
+                int L = cells, R = -1;
+                for (const PointRow* row : rows) {
+                    if (row->xr < 0) continue;
+                    L = std::min(L, std::max(row->xl - 1, 0));
+                    R = std::max(R, std::min(row->xr, cells - 1));
+                }
+
+                uint8_t* configs = &mConfigs[(y + size_t(z) * cells) * cells];
+                for (int x = L; x <= R; x++) {
+                    int config = ((r00[x] & pointInside) >> 3)      | ((r00[x + 1] & pointInside) >> 2)
+                               | ((r10[x + 1] & pointInside) >> 1)  | (r10[x] & pointInside)
+                               | ((r01[x] & pointInside) << 1)      | ((r01[x + 1] & pointInside) << 2)
+                               | ((r11[x + 1] & pointInside) << 3)  | ((r11[x] & pointInside) << 4);
+
+                    configs[x] = static_cast<uint8_t>(config);
+                    if (tables.triangleCount[config]) {
+                        info.triangles += tables.triangleCount[config];
+                        info.xl = std::min(info.xl, x);
+                        info.xr = x;
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    // 2. sumy prefiksowe -- stałe miejsce każdego wiersza w buforach wyjściowych
+    uint32_t vertexCount = 0;
+    for (PointRow& row : mPointRows) {
+        row.vertexBase = vertexCount;
+        vertexCount += row.edges[0] + row.edges[1] + row.edges[2];
+    }
+
+    uint32_t indexCount = 0;
+    for (CellRow& row : mCellRows) {
+        row.indexBase = indexCount;
+        indexCount += 3 * row.triangles;
+    }
+
+    // resize nie alokuje, jeśli pojemność z poprzednich klatek wystarcza
+    out.positions.resize(3 * size_t(vertexCount));
+    out.normals.resize(3 * size_t(vertexCount));
+    out.indices.resize(indexCount);
+
+    // Wiersz punktów (0..3 wokół wiersza komórek) i oś krawędzi każdej z 12 krawędzi komórki,
+    // oraz czy krawędź wychodzi z punktu x+1
+    int edgeRow[12], edgeAxis[12], edgeNext[12];
+    for (int e = 0; e < 12; e++) {
+        const int* ca = cornerOffset[edgeCorners[e][0]];
+        const int* cb = cornerOffset[edgeCorners[e][1]];
+        edgeRow[e] = std::min(ca[1], cb[1]) + 2 * std::min(ca[2], cb[2]);
+        edgeAxis[e] = ca[0] != cb[0] ? 0 : (ca[1] != cb[1] ? 1 : 2);
+        edgeNext[e] = std::min(ca[0], cb[0]);
+    }
+
+    // 3. przebieg: wiersze komórek wpisują swoje wierzchołki i trójkąty
+    pool.ParallelFor(0, cells, [&](int zb, int ze) {
+        for (int z = zb; z < ze; z++) {
+            for (int y = 0; y < cells; y++) {
+                // Cztery wiersze punktów wokół wiersza komórek: (y, z), (y+1, z), (y, z+1), (y+1, z+1)
+                const int rowY[4] = { y, y + 1, y, y + 1 };
+                const int rowZ[4] = { z, z, z + 1, z + 1 };
+                const PointRow* rows[4];
+                const uint8_t* cases[4];
+                for (int r = 0; r < 4; r++) {
+                    rows[r] = &mPointRows[rowY[r] + size_t(rowZ[r]) * N];
+                    cases[r] = &mEdgeCases[rowY[r] * size_t(N) + rowZ[r] * plane];
+                }
+                const CellRow& cellRow = mCellRows[y + size_t(z) * cells];
+
+                // Wiersz komórek zapisuje wierzchołki swojego wiersza punktów oraz wierszy na brzegu siatki
+                const bool writes[4] = { true, y + 1 == cells, z + 1 == cells, y + 1 == cells && z + 1 == cells };
+
+                int L = cellRow.xr >= 0 ? cellRow.xl : N;
+                int R = cellRow.xr;
+                for (int r = 0; r < 4; r++) {
+                    if (rows[r]->xr < 0 || (!writes[r] && cellRow.xr < 0)) continue;
+                    L = std::min(L, rows[r]->xl);
+                    R = std::max(R, rows[r]->xr);
+                }
+                if (R < 0) continue;
+
+                // Liczniki przeciętych krawędzi przed punktem x: [wiersz][oś]
+                // Krawędzie przed przyciętym zakresem wiersza nie istnieją, więc start od L jest poprawny
+                uint32_t next[4][3];
+                for (int r = 0; r < 4; r++) {
+                    next[r][0] = rows[r]->vertexBase;
+                    next[r][1] = next[r][0] + rows[r]->edges[0];
+                    next[r][2] = next[r][1] + rows[r]->edges[1];
+                }
+
+                const uint8_t* configs = &mConfigs[(y + size_t(z) * cells) * cells];
+                uint32_t* indexOut = out.indices.data() + cellRow.indexBase;
+
+                for (int x = L; x <= R; x++) {
+                    for (int r = 0; r < 4; r++) {
+                        if (!writes[r] || !(cases[r][x] & (edgeCutX | edgeCutY | edgeCutZ))) continue;
+                        for (int a = 0; a < 3; a++) {
+                            if (!(cases[r][x] & (1 << a))) continue;
+                            uint32_t id = next[r][a];
+                            edgeVertex(f, N, iso, cellSize, origin, x, rowY[r], rowZ[r], a,
+                                       &out.positions[3 * size_t(id)], &out.normals[3 * size_t(id)]);
+                        }
+                    }
+
+                    if (x >= cellRow.xl && x <= cellRow.xr) {
+                        int config = configs[x];
+                        if (tables.triangleCount[config]) {
+                            // Identyfikatory wierzchołków przeciętych krawędzi komórki
+                            uint32_t ids[12];
+                            uint16_t mask = tables.edgeMask[config];
+                            for (int e = 0; e < 12; e++) {
+                                if (!(mask & (1 << e))) continue;
+                                int r = edgeRow[e], a = edgeAxis[e];
+                                // Krawędź punktu x+1: licznik po uwzględnieniu punktu x
+                                ids[e] = next[r][a] + (edgeNext[e] ? (cases[r][x] >> a & 1) : 0);
+                            }
+
+                            for (const int8_t* tri = tables.triangles[config]; *tri >= 0; tri++)
+                                *indexOut++ = ids[*tri];
+                        }
+                    }
+
+                    for (int r = 0; r < 4; r++) {
+                        uint8_t c = cases[r][x];
+                        next[r][0] += c & edgeCutX;
+                        next[r][1] += (c & edgeCutY) >> 1;
+                        next[r][2] += (c & edgeCutZ) >> 2;
+                    }
+                }
+            }
+        }
+    }, 1);
+}
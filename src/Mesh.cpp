@@ -0,0 +1,440 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+static const uint64_t fnvOffset = 0xcbf29ce484222325ULL;
+static const uint64_t fnvPrime  = 0x100000001b3ULL;
+
+// Wyrównanie sekcji w pliku cache
+static uint64_t alignUp(uint64_t value) {
+    return (value + 15) & ~uint64_t(15);
+}
+
+std::string MeshCache::CachePath(const std::string& objPath) {
+    return objPath + ".meshcache";
+}
+
+bool MeshCache::HashFile(const std::string& path, uint64_t& hash, uint64_t& size) {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+
+    const unsigned char* data = file.Data();
+    size_t n = file.Size();
+
+    // FNV-1a liczony po słowach 64-bitowych -- kilka razy szybszy niż bajt po bajcie
+    uint64_t h = fnvOffset;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h = (h ^ word) * fnvPrime;
+    }
+    for (; i < n; i++)
+        h = (h ^ data[i]) * fnvPrime;
+
+    hash = h;
+    size = n;
+    return true;
+}
+
+bool MeshCache::Write(const std::string& objPath, uint64_t sourceHash, uint64_t sourceSize,
+                      const MeshView& mesh) {
+    MeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+
+    header.magic = meshCacheMagic;
+    header.version = meshCacheVersion;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.vertexCount = mesh.vertexCount;
+    header.indexCount = mesh.indexCount;
+
+    for (int i = 0; i < 3; i++) {
+        header.boundsMin[i] = mesh.boundsMin[i];
+        header.boundsMax[i] = mesh.boundsMax[i];
+    }
+
+    uint64_t attribBytes = uint64_t(mesh.vertexCount) * 3 * sizeof(float);
+    uint64_t indexBytes  = uint64_t(mesh.indexCount) * sizeof(uint32_t);
+
+    header.positionsOffset = alignUp(sizeof(MeshCacheHeader));
+    header.normalsOffset   = alignUp(header.positionsOffset + attribBytes);
+    header.indicesOffset   = alignUp(header.normalsOffset + attribBytes);
+
+    // Najpierw zapis do pliku tymczasowego, żeby przerwany zapis nie zostawił uszkodzonego cache
+    std::string path = CachePath(objPath);
+    std::string tmpPath = path + ".tmp";
+
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    const char padding[16] = {};
+    auto writeSection = [&](uint64_t offset, const void* data, uint64_t bytes) {
+        uint64_t pos = static_cast<uint64_t>(file.tellp());
+        file.write(padding, static_cast<std::streamsize>(offset - pos));
+        if (bytes) file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeSection(header.positionsOffset, mesh.positions, attribBytes);
+    writeSection(header.normalsOffset, mesh.normals, attribBytes);
+    writeSection(header.indicesOffset, mesh.indices, indexBytes);
+    file.close();
+
+    if (!file) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // Na Windowsie rename nie nadpisuje istniejącego pliku
+    std::remove(path.c_str());
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool MeshCache::Open(const std::string& objPath, uint64_t sourceHash, uint64_t sourceSize) {
+    Close();
+
+    if (!mFile.Open(CachePath(objPath))) return false;
+
+    if (mFile.Size() < sizeof(MeshCacheHeader)) {
+        Close();
+        return false;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy(&header, mFile.Data(), sizeof(header));
+
+    // Inna wersja formatu albo zmieniony plik .obj -- cache jest nieaktualny
+    if (header.magic != meshCacheMagic || header.version != meshCacheVersion ||
+        header.sourceHash != sourceHash || header.sourceSize != sourceSize) {
+        Close();
+        return false;
+    }
+
+    uint64_t attribBytes = uint64_t(header.vertexCount) * 3 * sizeof(float);
+    uint64_t indexBytes  = uint64_t(header.indexCount) * sizeof(uint32_t);
+
+    // Sprawdzenie czy sekcje mieszczą się w pliku (np. po przerwanym zapisie)
+    if (header.positionsOffset + attribBytes > mFile.Size() ||
+        header.normalsOffset + attribBytes > mFile.Size() ||
+        header.indicesOffset + indexBytes > mFile.Size() ||
+        (header.positionsOffset | header.normalsOffset | header.indicesOffset) & 3) {
+        Close();
+        return false;
+    }
+
+    const unsigned char* base = mFile.Data();
+    mView.positions = reinterpret_cast<const float*>(base + header.positionsOffset);
+    mView.normals = reinterpret_cast<const float*>(base + header.normalsOffset);
+    mView.indices = header.indexCount ? reinterpret_cast<const uint32_t*>(base + header.indicesOffset) : nullptr;
+    mView.vertexCount = header.vertexCount;
+    mView.indexCount = header.indexCount;
+    mView.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    mView.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+    return true;
+}
+
+void MeshCache::Close() {
+    mFile.Close();
+    mView = MeshView();
+}
+
+void ComputeBounds(const float* positions, uint32_t vertexCount, glm::vec3& bmin, glm::vec3& bmax) {
+    if (vertexCount == 0) {
+        bmin = bmax = glm::vec3(0.0f);
+        return;
+    }
+
+    bmin = glm::vec3(std::numeric_limits<float>::max());
+    bmax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        glm::vec3 p(positions[3 * v + 0], positions[3 * v + 1], positions[3 * v + 2]);
+        bmin = glm::min(bmin, p);
+        bmax = glm::max(bmax, p);
+    }
+}
+
+MeshView MeshData::View() const {
+    MeshView view;
+    view.positions = positions.data();
+    view.normals = normals.data();
+    view.indices = indices.data();
+    view.vertexCount = static_cast<uint32_t>(positions.size() / 3);
+    view.indexCount = static_cast<uint32_t>(indices.size());
+    view.boundsMin = boundsMin;
+    view.boundsMax = boundsMax;
+    return view;
+}
+
+void MeshData::Clear() {
+    std::vector<float>().swap(positions);
+    std::vector<float>().swap(normals);
+    std::vector<uint32_t>().swap(indices);
+}
+
+// Hash 6 floatów (pozycja + normalna) po ich reprezentacji bitowej
+static uint64_t hashVertex(const float* p, const float* n) {
+    uint32_t bits[6];
+    std::memcpy(bits, p, 3 * sizeof(float));
+    std::memcpy(bits + 3, n, 3 * sizeof(float));
+
+    uint64_t h = fnvOffset;
+    for (int i = 0; i < 6; i++)
+        h = (h ^ bits[i]) * fnvPrime;
+    return h ^ (h >> 32);
+}
+
+void BuildIndexedMesh(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::index_t>& corners, MeshData& out) {
+    static const float zeroNormal[3] = {0.0f, 0.0f, 0.0f};
+
+    out.Clear();
+    out.indices.resize(corners.size());
+
+    // Tablica z adresowaniem otwartym, przechowuje indeks wierzchołka w out (+1, 0 = pusty slot)
+    size_t capacity = 16;
+    while (capacity < corners.size() * 2) capacity <<= 1;
+    std::vector<uint32_t> table(capacity, 0);
+    size_t mask = capacity - 1;
+
+    for (size_t c = 0; c < corners.size(); c++) {
+        const tinyobj::index_t& idx = corners[c];
+        const float* p = &attrib.vertices[3 * idx.vertex_index];
+        const float* n = idx.normal_index >= 0 ? &attrib.normals[3 * idx.normal_index] : zeroNormal;
+
+        size_t slot = hashVertex(p, n) & mask;
+        uint32_t found = 0;
+
+        while (table[slot]) {
+            uint32_t v = table[slot] - 1;
+            if (std::memcmp(&out.positions[3 * v], p, 3 * sizeof(float)) == 0 &&
+                std::memcmp(&out.normals[3 * v], n, 3 * sizeof(float)) == 0) {
+                found = table[slot];
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        if (!found) {
+            out.positions.insert(out.positions.end(), p, p + 3);
+            out.normals.insert(out.normals.end(), n, n + 3);
+            found = static_cast<uint32_t>(out.positions.size() / 3);
+            table[slot] = found;
+        }
+
+        out.indices[c] = found - 1;
+    }
+
+    ComputeBounds(out.positions.data(), static_cast<uint32_t>(out.positions.size() / 3), out.boundsMin, out.boundsMax);
+}
+
+// Tipsify: Sander, Nehab, Barczak "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007)
+void OptimizeVertexCache(MeshData& mesh, int cacheSize) {
+    const uint32_t vertexCount = static_cast<uint32_t>(mesh.positions.size() / 3);
+    const uint32_t triCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+    if (triCount == 0) return;
+
+    const std::vector<uint32_t>& idx = mesh.indices;
+
+    // Lista trójkątów przylegających do każdego wierzchołka (CSR)
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (uint32_t i = 0; i < 3 * triCount; i++) live[idx[i]]++;
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+
+    std::vector<uint32_t> adjacency(3 * triCount);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t t = 0; t < triCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[idx[3 * t + k]]++] = t;
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(3 * triCount);
+
+    uint32_t time = cacheSize + 1;
+    uint32_t cursor = 1;
+    int64_t fan = 0;
+
+    while (fan >= 0) {
+        candidates.clear();
+
+        // Emitujemy wszystkie jeszcze nie wypisane trójkąty wokół wierzchołka 'fan'
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = idx[3 * t + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+
+                if (time - cacheTime[v] > static_cast<uint32_t>(cacheSize))
+                    cacheTime[v] = time++;
+            }
+            emitted[t] = 1;
+        }
+
+        // Następny wierzchołek: ten, który wciąż będzie w cache po wypisaniu jego trójkątów
+        int64_t best = -1;
+        int bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+
+            int priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= static_cast<uint32_t>(cacheSize))
+                priority = time - cacheTime[v];
+
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        // Ślepy zaułek -- najpierw ostatnio użyte wierzchołki, potem kolejne w buforze
+        if (best < 0) {
+            while (!deadEnd.empty()) {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0) {
+                    best = v;
+                    break;
+                }
+            }
+        }
+
+        if (best < 0) {
+            while (cursor < vertexCount && live[cursor] == 0) cursor++;
+            if (cursor < vertexCount) best = cursor;
+        }
+
+        fan = best;
+    }
+
+    // Przenumerowanie wierzchołków w kolejności pierwszego użycia (lepsza lokalność odczytu)
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    std::vector<float> positions(mesh.positions.size());
+    std::vector<float> normals(mesh.normals.size());
+    uint32_t next = 0;
+
+    for (uint32_t& v : result) {
+        if (remap[v] == UINT32_MAX) {
+            std::memcpy(&positions[3 * next], &mesh.positions[3 * v], 3 * sizeof(float));
+            std::memcpy(&normals[3 * next], &mesh.normals[3 * v], 3 * sizeof(float));
+            remap[v] = next++;
+        }
+        v = remap[v];
+    }
+
+    positions.resize(3 * next);
+    normals.resize(3 * next);
+
+    mesh.positions.swap(positions);
+    mesh.normals.swap(normals);
+    mesh.indices.swap(result);
+}
+
+void ComputeMissingNormals(MeshData& mesh) {
+    const size_t vertexCount = mesh.positions.size() / 3;
+
+    // Tylko wierzchołki z zerową normalną (brak 'vn' w pliku)
+    std::vector<char> missing(vertexCount, 0);
+    bool any = false;
+    for (size_t v = 0; v < vertexCount; v++) {
+        const float* n = &mesh.normals[3 * v];
+        if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) missing[v] = any = true;
+    }
+    if (!any) return;
+
+    std::vector<glm::vec3> accum(vertexCount, glm::vec3(0.0f));
+    for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+        uint32_t i0 = mesh.indices[t], i1 = mesh.indices[t + 1], i2 = mesh.indices[t + 2];
+        glm::vec3 p0(mesh.positions[3 * i0], mesh.positions[3 * i0 + 1], mesh.positions[3 * i0 + 2]);
+        glm::vec3 p1(mesh.positions[3 * i1], mesh.positions[3 * i1 + 1], mesh.positions[3 * i1 + 2]);
+        glm::vec3 p2(mesh.positions[3 * i2], mesh.positions[3 * i2 + 1], mesh.positions[3 * i2 + 2]);
+
+        // Długość iloczynu wektorowego = 2x pole trójkąta, więc to od razu ważenie polem
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        accum[i0] += n;
+        accum[i1] += n;
+        accum[i2] += n;
+    }
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (!missing[v]) continue;
+        float len = glm::length(accum[v]);
+        glm::vec3 n = len > 0.0f ? accum[v] / len : glm::vec3(0.0f, 0.0f, 1.0f);
+        mesh.normals[3 * v + 0] = n.x;
+        mesh.normals[3 * v + 1] = n.y;
+        mesh.normals[3 * v + 2] = n.z;
+    }
+}
+
+// Test nakładania się trójkąta i sześcianu (Akenine-Möller), trójkąt w układzie środka sześcianu
+static bool triangleBoxOverlap(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float half) {
+    const glm::vec3 e[3] = { v1 - v0, v2 - v1, v0 - v2 };
+
+    // 9 osi: iloczyny krawędzi trójkąta z osiami sześcianu
+    for (int i = 0; i < 3; i++) {
+        for (int a = 0; a < 3; a++) {
+            glm::vec3 axis(0.0f);
+            axis[(a + 1) % 3] = -e[i][(a + 2) % 3];
+            axis[(a + 2) % 3] =  e[i][(a + 1) % 3];
+
+            float p0 = glm::dot(v0, axis), p1 = glm::dot(v1, axis), p2 = glm::dot(v2, axis);
+            float r = half * (std::fabs(axis.x) + std::fabs(axis.y) + std::fabs(axis.z));
+            if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r) return false;
+        }
+    }
+
+    // Płaszczyzna trójkąta
+    glm::vec3 n = glm::cross(e[0], e[1]);
+    float d = glm::dot(n, v0);
+    float r = half * (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    return std::fabs(d) <= r;
+}
+
+void VoxelizeMesh(const MeshView& mesh, int res, float cellSize, const glm::vec3& origin, VoxelGrid& out) {
+    out.Resize(res);
+
+    const float half = 0.5f * cellSize;
+    const uint32_t triCount = mesh.indexCount / 3;
+
+    for (uint32_t t = 0; t < triCount; t++) {
+        glm::vec3 v[3];
+        for (int k = 0; k < 3; k++) {
+            const float* p = &mesh.positions[3 * mesh.indices[3 * t + k]];
+            v[k] = (glm::vec3(p[0], p[1], p[2]) - origin) / cellSize;
+        }
+
+        // Zakres komórek pokrytych przez AABB trójkąta
+        glm::ivec3 lo = glm::ivec3(glm::floor(glm::min(v[0], glm::min(v[1], v[2]))));
+        glm::ivec3 hi = glm::ivec3(glm::floor(glm::max(v[0], glm::max(v[1], v[2]))));
+        lo = glm::clamp(lo, glm::ivec3(0), glm::ivec3(res - 1));
+        hi = glm::clamp(hi, glm::ivec3(0), glm::ivec3(res - 1));
+
+        for (int z = lo.z; z <= hi.z; z++)
+            for (int y = lo.y; y <= hi.y; y++)
+                for (int x = lo.x; x <= hi.x; x++) {
+                    if (out.Get(x, y, z)) continue;
+
+                    glm::vec3 center = (glm::vec3(x, y, z) + 0.5f) * cellSize;
+                    glm::vec3 a = v[0] * cellSize - center;
+                    glm::vec3 b = v[1] * cellSize - center;
+                    glm::vec3 c = v[2] * cellSize - center;
+                    if (triangleBoxOverlap(a, b, c, half)) out.Set(x, y, z, true);
+                }
+    }
+}
@@ -0,0 +1,148 @@
+#include "ModelLoader.h"
+#include "ObjParser.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+
+ModelLoader::ModelLoader() {
+    // Pula musi powstać przed loaderem, żeby zniszczyć się dopiero po zatrzymaniu jego wątku
+    ThreadPool::Instance();
+
+    mStop = false;
+    mThread = std::thread(&ModelLoader::workerLoop, this);
+}
+
+ModelLoader::~ModelLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+}
+
+void ModelLoader::Request(std::unique_ptr<ModelJob> job) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.push_back(std::move(job));
+    }
+    mWake.notify_one();
+}
+
+std::unique_ptr<ModelJob> ModelLoader::Poll() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mCompleted.empty()) return nullptr;
+
+    std::unique_ptr<ModelJob> job = std::move(mCompleted.front());
+    mCompleted.pop_front();
+    return job;
+}
+
+void ModelLoader::workerLoop() {
+    while (true) {
+        std::unique_ptr<ModelJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&] { return mStop || !mPending.empty(); });
+            if (mStop) return;
+
+            job = std::move(mPending.front());
+            mPending.pop_front();
+        }
+
+        job->ok = Load(*job);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCompleted.push_back(std::move(job));
+    }
+}
+
+// Załadowanie prostego pliku .obj
+// Jeśli obok pliku istnieje aktualny cache (.meshcache), jest on tylko mapowany do pamięci
+static bool loadMesh(const std::string& path, ModelJob& job) {
+    // Hash zawartości pliku .obj -- cache jest ważny tylko dla identycznego pliku
+    uint64_t sourceHash = 0, sourceSize = 0;
+    if (!MeshCache::HashFile(path, sourceHash, sourceSize)) {
+        std::cerr << "[ERROR] Nie można otworzyć pliku OBJ: " << path << std::endl;
+        return false;
+    }
+
+    if (job.cache.Open(path, sourceHash, sourceSize)) {
+        job.mesh = job.cache.View();
+        return true;
+    }
+
+    // Struktura do przechowywania współrzędnych wierzchołków, wektorów normalnych i texcoords
+    tinyobj::attrib_t attrib;
+
+    // Wszystkie narożniki trójkątów ze wszystkich kształtów
+    std::vector<tinyobj::index_t> corners;
+
+    // Ostrzeżenia
+    std::string warn, err;
+
+    // Duże pliki (eksporty CAD) parsujemy równolegle, w razie błędu zostaje tinyobj
+    bool ret = false;
+    if (sourceSize >= parallelObjThreshold) {
+        ret = ParseObjParallel(path, attrib, corners, err);
+        if (!ret) std::cerr << "[WARNING] Równoległy parser OBJ: " << err << std::endl;
+    }
+
+    if (!ret) {
+        // Wektory przechowujące kształty (mesh) i materiały z pliku OBJ
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+
+        attrib = tinyobj::attrib_t();
+        err.clear();
+
+        // Wczytywanie pliku
+        ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+        if (!ret) {
+            std::cerr << "[ERROR] Nie można załadować pliku OBJ: " << warn << err << std::endl;
+            return false;
+        }
+
+        size_t cornerCount = 0;
+        for (const auto& shape : shapes) cornerCount += shape.mesh.indices.size();
+        corners.reserve(cornerCount);
+        for (const auto& shape : shapes)
+            corners.insert(corners.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+    }
+
+    const size_t cornerCount = corners.size();
+
+    // Każda para (pozycja, normalna) tylko raz + bufor indeksów
+    BuildIndexedMesh(attrib, corners, job.data);
+    ComputeMissingNormals(job.data);
+    OptimizeVertexCache(job.data);
+    job.mesh = job.data.View();
+
+    std::cout << "Model: " << cornerCount << " wierzchołków -> " << job.mesh.vertexCount
+              << " unikalnych, " << job.mesh.indexCount / 3 << " trójkątów" << std::endl;
+
+    // Zapis cache na następne uruchomienie, po czym dane czytamy już z mapowania
+    if (MeshCache::Write(path, sourceHash, sourceSize, job.mesh) &&
+        job.cache.Open(path, sourceHash, sourceSize)) {
+        job.mesh = job.cache.View();
+        job.data.Clear();
+    }
+    else {
+        std::cerr << "[WARNING] Nie zapisano cache modelu: " << MeshCache::CachePath(path) << std::endl;
+    }
+
+    return true;
+}
+
+bool ModelLoader::Load(ModelJob& job) {
+    if (!loadMesh(job.path, job)) return false;
+
+    // Komórki siatki voxeli zajęte przez model
+    if (job.voxelRes > 0)
+        VoxelizeMesh(job.mesh, job.voxelRes, job.voxelSize, job.voxelOrigin, job.voxels);
+
+    if (job.fluidRes > 0)
+        VoxelizeMesh(job.mesh, job.fluidRes, job.fluidCellSize, job.fluidOrigin, job.fluidVoxels);
+
+    return true;
+}
@@ -0,0 +1,312 @@
+#include "NestedFluid.h"
+#include "FluidStencil.h"
+
+#include <algorithm>
+#include <cmath>
+
+NestedFluid::NestedFluid(int size, float dt, int iter, float diffusion, float viscosity) :
+    coarse(size, dt, iter, diffusion, viscosity),
+    fine(2 * size, dt, iter, diffusion, viscosity) {
+
+    this->size = size;
+    this->dt = dt;
+    this->iter = iter;
+    this->diff = diffusion;
+    this->visc = viscosity;
+
+    this->obstacles = nullptr;
+    this->pressureCycles = nestedPressureCycles;
+
+    refined.Resize((size + sparseBlockMask) >> sparseBlockBits);
+
+    // Kanały drobnego poziomu czytają grube tablice w tych samych rolach
+    coarseFields[sfS] = coarse.s;
+    coarseFields[sfDensity] = coarse.density;
+    coarseFields[sfVx] = coarse.Vx;
+    coarseFields[sfVy] = coarse.Vy;
+    coarseFields[sfVz] = coarse.Vz;
+    coarseFields[sfVx0] = coarse.Vx0;
+    coarseFields[sfVy0] = coarse.Vy0;
+    coarseFields[sfVz0] = coarse.Vz0;
+    fine.SetBackground(coarseFields, size);
+    fine.SetBlocks(std::vector<int>());
+}
+
+bool NestedFluid::SetObstacles(const VoxelGrid *grid, const VoxelGrid *fineGrid) {
+    bool ok = coarse.SetObstacles(grid);
+    this->obstacles = coarse.obstacles;
+
+    if (fineGrid && fineGrid->Res() == 2 * this->size) {
+        fine.SetObstacles(fineGrid);
+        return ok;
+    }
+    if (!this->obstacles) {
+        fine.SetObstacles(nullptr);
+        return ok;
+    }
+
+    // Każda pełna komórka grubej maski to 2x2x2 komórek drobnej
+    int N = this->size;
+    fineObstacles.Resize(2 * N);
+    for (int z = 0; z < N; z++)
+        for (int y = 0; y < N; y++)
+            for (int x = 0; x < N; x++) {
+                if (!this->obstacles->Get(x, y, z)) continue;
+                for (int n = 0; n < 8; n++)
+                    fineObstacles.Set(2 * x + (n & 1), 2 * y + ((n >> 1) & 1), 2 * z + ((n >> 2) & 1), true);
+            }
+    fine.SetObstacles(&fineObstacles);
+    return ok;
+}
+
+void NestedFluid::AddDensity(int x, int y, int z, float amount) {
+    coarse.AddDensity(x, y, z, amount);
+
+    if (!refined.Get(x >> sparseBlockBits, y >> sparseBlockBits, z >> sparseBlockBits)) return;
+    for (int n = 0; n < 8; n++)
+        fine.AddDensity(2 * x + (n & 1), 2 * y + ((n >> 1) & 1), 2 * z + ((n >> 2) & 1), amount);
+}
+
+void NestedFluid::AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ) {
+    coarse.AddVelocity(x, y, z, amountX, amountY, amountZ);
+
+    if (!refined.Get(x >> sparseBlockBits, y >> sparseBlockBits, z >> sparseBlockBits)) return;
+    for (int n = 0; n < 8; n++)
+        fine.AddVelocity(2 * x + (n & 1), 2 * y + ((n >> 1) & 1), 2 * z + ((n >> 2) & 1), amountX, amountY, amountZ);
+}
+
+size_t NestedFluid::Bytes() const {
+    size_t N = this->size;
+    return 8 * N * N * N * sizeof(float) + fine.Bytes() + refined.Bytes() + fineObstacles.Bytes();
+}
+
+// Zagęszczenie: bloki z przeszkodą (z sąsiadami) i bloki o wirowości powyżej progu
+void NestedFluid::update_refinement() {
+    int N = this->size;
+    int B = refined.Res();
+    const float *u = coarse.Vx, *v = coarse.Vy, *w = coarse.Vz;
+
+    std::vector<uint8_t> flag(size_t(B) * B * B, 0);
+    auto block = [&](int x, int y, int z) -> uint8_t& {
+        return flag[(size_t(z >> sparseBlockBits) * B + (y >> sparseBlockBits)) * B + (x >> sparseBlockBits)];
+    };
+
+    float threshold2 = nestedVorticityThreshold * nestedVorticityThreshold;
+    float h = 0.5f * N;
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                float wx = (w[IX(i, j + 1, k)] - w[IX(i, j - 1, k)]) - (v[IX(i, j, k + 1)] - v[IX(i, j, k - 1)]);
+                float wy = (u[IX(i, j, k + 1)] - u[IX(i, j, k - 1)]) - (w[IX(i + 1, j, k)] - w[IX(i - 1, j, k)]);
+                float wz = (v[IX(i + 1, j, k)] - v[IX(i - 1, j, k)]) - (u[IX(i, j + 1, k)] - u[IX(i, j - 1, k)]);
+                if ((wx * wx + wy * wy + wz * wz) * h * h > threshold2) block(i, j, k) = 1;
+            }
+        }
+    }
+
+    // Przeszkoda zagęszcza swój blok i sąsiednie
+    if (this->obstacles) {
+        for (int z = 0; z < N; z++)
+            for (int y = 0; y < N; y++)
+                for (int x = 0; x < N; x++)
+                    if (this->obstacles->Get(x, y, z)) block(x, y, z) = 2;
+    }
+
+    refined.Clear();
+    for (int bz = 1; bz < B - 1; bz++) {
+        for (int by = 1; by < B - 1; by++) {
+            for (int bx = 1; bx < B - 1; bx++) {
+                uint8_t f = flag[(size_t(bz) * B + by) * B + bx];
+                if (!f) continue;
+
+                int r = f == 2 ? 1 : 0;
+                for (int z = std::max(bz - r, 1); z <= std::min(bz + r, B - 2); z++)
+                    for (int y = std::max(by - r, 1); y <= std::min(by + r, B - 2); y++)
+                        for (int x = std::max(bx - r, 1); x <= std::min(bx + r, B - 2); x++)
+                            refined.Set(x, y, z, true);
+            }
+        }
+    }
+
+    // Blok grubej siatki = 2x2x2 bloki drobnej
+    int FB = 2 * B;
+    std::vector<int> ids;
+    for (int bz = 0; bz < B; bz++)
+        for (int by = 0; by < B; by++)
+            for (int bx = 0; bx < B; bx++) {
+                if (!refined.Get(bx, by, bz)) continue;
+                for (int n = 0; n < 8; n++) {
+                    int x = 2 * bx + (n & 1), y = 2 * by + ((n >> 1) & 1), z = 2 * bz + ((n >> 2) & 1);
+                    ids.push_back(x + (y + z * FB) * FB);
+                }
+            }
+
+    fine.SetBlocks(ids);
+}
+
+// Rzut przez oba poziomy. Ciśnienie na obu siatkach ma tę samą skalę (laplasjan dzielony przez h^2),
+// a prawa strona div ~ h^2, więc średnia dywergencji drobnej trafia do grubej razy 4.
+void NestedFluid::project(int velX, int velY, int velZ, int p, int div) {
+    Fluid& c = coarse;
+    SparseFluid& f = fine;
+    int N = this->size;
+
+    float *u = coarseFields[velX], *v = coarseFields[velY], *w = coarseFields[velZ];
+    float *cp = coarseFields[p], *cd = coarseFields[div];
+
+    double previous = 0.0;
+    for (int cycle = 0; cycle < std::max(this->pressureCycles, 1); cycle++) {
+        // Prawa strona drobnego poziomu (jego tło to bieżąca gruba prędkość) wchodzi pod bloki grubej
+        f.divergence(velX, velY, velZ, p, div);
+
+        for (int k = 1; k < N - 1; k++) {
+            for (int j = 1; j < N - 1; j++) {
+                for (int i = 1; i < N - 1; i++) {
+                    cd[IX(i, j, k)] = DivergenceCell(u[IX(i + 1, j, k)], u[IX(i - 1, j, k)],
+                                                     v[IX(i, j + 1, k)], v[IX(i, j - 1, k)],
+                                                     w[IX(i, j, k + 1)], w[IX(i, j, k - 1)], N);
+                    cp[IX(i, j, k)] = 0.0f;
+                }
+            }
+        }
+        f.Restrict(div, cd, 4.0f);
+
+        c.solve_pressure(cp, cd);
+
+        for (int k = 1; k < N - 1; k++) {
+            for (int j = 1; j < N - 1; j++) {
+                for (int i = 1; i < N - 1; i++) {
+                    u[IX(i, j, k)] -= GradientCell(cp[IX(i + 1, j, k)], cp[IX(i - 1, j, k)], N);
+                    v[IX(i, j, k)] -= GradientCell(cp[IX(i, j + 1, k)], cp[IX(i, j - 1, k)], N);
+                    w[IX(i, j, k)] -= GradientCell(cp[IX(i, j, k + 1)], cp[IX(i, j, k - 1)], N);
+                }
+            }
+        }
+        c.set_bounds(1, u);
+        c.set_bounds(2, v);
+        c.set_bounds(3, w);
+
+        // Bez drobnych bloków to zwykły rzut grubego poziomu
+        if (!f.ActiveBlocks()) return;
+
+        // Ciśnienie grubego poziomu jako brzeg, prawa strona od nowa -- tło (gruba prędkość) się zmieniło
+        f.project(velX, velY, velZ, p, div);
+
+        // Drobna prędkość pod bloki grubej: następny przebieg widzi strumień drobnego poziomu na granicy
+        f.Restrict(velX, u);
+        f.Restrict(velY, v);
+        f.Restrict(velZ, w);
+
+        double mismatch = interface_divergence(velX, velY, velZ);
+        if (cycle > 0 && mismatch >= previous) break;
+        previous = mismatch;
+    }
+}
+
+double NestedFluid::InterfaceDivergence() const {
+    return interface_divergence(sfVx, sfVy, sfVz);
+}
+
+double NestedFluid::interface_divergence(int velX, int velY, int velZ) const {
+    const int D = sparseBlockDim;
+    const int ty = sparseTileDim, tz = sparseTileDim * sparseTileDim;
+    int NF = fine.size;
+    double result = 0.0;
+
+    // Drobna strona: komórki bloków przy ścianie bez drobnego sąsiada (tam tile czyta gruby poziom)
+    float tu[sparseTileCells], tv[sparseTileCells], tw[sparseTileCells];
+    for (const SparseFluid::BlockLinks& bl : fine.links) {
+        const int *face = bl.face;
+        if (face[0] >= 0 && face[1] >= 0 && face[2] >= 0 && face[3] >= 0 && face[4] >= 0 && face[5] >= 0) continue;
+
+        fine.gatherTile(velX, bl, tu);
+        fine.gatherTile(velY, bl, tv);
+        fine.gatherTile(velZ, bl, tw);
+
+        for (int lz = 0; lz < D; lz++) {
+            for (int ly = 0; ly < D; ly++) {
+                for (int lx = 0; lx < D; lx++) {
+                    bool edge = (lx == 0 && face[0] < 0) || (lx == D - 1 && face[1] < 0)
+                             || (ly == 0 && face[2] < 0) || (ly == D - 1 && face[3] < 0)
+                             || (lz == 0 && face[4] < 0) || (lz == D - 1 && face[5] < 0);
+                    if (!edge) continue;
+                    if (fine.obstacles && fine.obstacles->Get(bl.x0 + lx, bl.y0 + ly, bl.z0 + lz)) continue;
+
+                    int t = TIX(lx, ly, lz);
+                    double div = 0.5 * NF * (double(tu[t + 1]) - tu[t - 1] + double(tv[t + ty]) - tv[t - ty]
+                                           + double(tw[t + tz]) - tw[t - tz]);
+                    result = std::max(result, std::fabs(div));
+                }
+            }
+        }
+    }
+
+    // Gruba strona: komórki poza blokami z zagęszczonym sąsiadem przez ścianę
+    int N = this->size;
+    const float *u = coarseFields[velX], *v = coarseFields[velY], *w = coarseFields[velZ];
+    auto isRefined = [&](int x, int y, int z) {
+        return refined.Get(x >> sparseBlockBits, y >> sparseBlockBits, z >> sparseBlockBits);
+    };
+
+    for (int k = 1; k < N - 1; k++) {
+        for (int j = 1; j < N - 1; j++) {
+            for (int i = 1; i < N - 1; i++) {
+                if (isRefined(i, j, k)) continue;
+                if (!isRefined(i - 1, j, k) && !isRefined(i + 1, j, k) && !isRefined(i, j - 1, k)
+                    && !isRefined(i, j + 1, k) && !isRefined(i, j, k - 1) && !isRefined(i, j, k + 1)) continue;
+                if (this->obstacles && this->obstacles->Get(i, j, k)) continue;
+
+                double div = 0.5 * N * (double(u[IX(i + 1, j, k)]) - u[IX(i - 1, j, k)]
+                                      + double(v[IX(i, j + 1, k)]) - v[IX(i, j - 1, k)]
+                                      + double(w[IX(i, j, k + 1)]) - w[IX(i, j, k - 1)]);
+                result = std::max(result, std::fabs(div));
+            }
+        }
+    }
+
+    return result;
+}
+
+// Każdy etap najpierw na grubym poziomie, potem na drobnym (ten czyta gruby poza swoimi blokami)
+void NestedFluid::FluidStep() {
+    update_refinement();
+
+    Fluid& c = coarse;
+    SparseFluid& f = fine;
+
+    c.diffuse(1, c.Vx0, c.Vx, this->visc, this->dt);
+    c.diffuse(2, c.Vy0, c.Vy, this->visc, this->dt);
+    c.diffuse(3, c.Vz0, c.Vz, this->visc, this->dt);
+    f.diffuse(1, sfVx0, sfVx, this->visc, this->dt);
+    f.diffuse(2, sfVy0, sfVy, this->visc, this->dt);
+    f.diffuse(3, sfVz0, sfVz, this->visc, this->dt);
+
+    // Ciśnienie grubego poziomu (w c.Vx) jest brzegiem dla ciśnienia drobnego (kanał sfVx)
+    project(sfVx0, sfVy0, sfVz0, sfVx, sfVy);
+
+    c.advect(1, c.Vx, c.Vx0, c.Vx0, c.Vy0, c.Vz0, this->dt);
+    c.advect(2, c.Vy, c.Vy0, c.Vx0, c.Vy0, c.Vz0, this->dt);
+    c.advect(3, c.Vz, c.Vz0, c.Vx0, c.Vy0, c.Vz0, this->dt);
+    f.advect(1, sfVx, sfVx0, sfVx0, sfVy0, sfVz0, this->dt);
+    f.advect(2, sfVy, sfVy0, sfVx0, sfVy0, sfVz0, this->dt);
+    f.advect(3, sfVz, sfVz0, sfVx0, sfVy0, sfVz0, this->dt);
+
+    project(sfVx, sfVy, sfVz, sfVx0, sfVy0);
+
+    c.diffuse(0, c.s, c.density, this->diff, this->dt);
+    f.diffuse(0, sfS, sfDensity, this->diff, this->dt);
+
+    c.advect(0, c.density, c.s, c.Vx, c.Vy, c.Vz, this->dt);
+    f.advect(0, sfDensity, sfS, sfVx, sfVy, sfVz, this->dt);
+
+    // Drobny poziom zastępuje grube komórki pod sobą
+    f.Restrict(sfDensity, c.density);
+    f.Restrict(sfVx, c.Vx);
+    f.Restrict(sfVy, c.Vy);
+    f.Restrict(sfVz, c.Vz);
+}
+
+void NestedFluid::fadeDensity(float amount) {
+    coarse.fadeDensity(amount);
+    fine.fadeDensity(amount);
+}
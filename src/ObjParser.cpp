@@ -0,0 +1,310 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Minimalny rozmiar fragmentu -- mniejsze nie opłacają się przy podziale na wątki
+static const size_t minChunkSize = 1024 * 1024;
+
+// Dokładne potęgi 10 w double (do 10^22)
+static const double pow10Table[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Wynik parsowania jednego fragmentu pliku
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<tinyobj::index_t> corners;
+
+    // Narożniki z indeksami względnymi (ujemnymi) -- do przesunięcia o bazę fragmentu
+    std::vector<uint32_t> relativeVertex;
+    std::vector<uint32_t> relativeNormal;
+
+    size_t line;
+    std::string err;
+};
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+static inline const char* skipLine(const char* p, const char* end) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return nl ? nl + 1 : end;
+}
+
+static double scalePow10(double value, int exp) {
+    while (exp > 22)  { value *= 1e22; exp -= 22; }
+    while (exp < -22) { value /= 1e22; exp += 22; }
+    return exp >= 0 ? value * pow10Table[exp] : value / pow10Table[-exp];
+}
+
+const char* ParseObjFloat(const char* p, const char* end, float& out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exp = 0;
+    const char* start = p;
+
+    // Maksymalnie 19 cyfr mieści się w uint64, dalsze tylko przesuwają wykładnik
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; }
+        else exp++;
+    }
+
+    if (p < end && *p == '.') {
+        p++;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; exp--; }
+        }
+    }
+
+    if (p == start) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '-' || *q == '+')) expNegative = *q++ == '-';
+
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; q++)
+                if (e < 10000) e = e * 10 + (*q - '0');
+            exp += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (exp) value = scalePow10(value, exp);
+
+    out = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+static inline const char* parseInt(const char* p, const char* end, int& out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    const char* start = p;
+    int value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) value = value * 10 + (*p - '0');
+
+    if (p == start) return nullptr;
+    out = negative ? -value : value;
+    return p;
+}
+
+// Zamiana indeksu z pliku (od 1 albo ujemny względny) na indeks od 0
+// Indeksy względne liczone są od liczby elementów już przeczytanych w tym fragmencie
+static inline int resolveIndex(int idx, size_t localCount, bool& relative) {
+    relative = idx < 0;
+    return relative ? static_cast<int>(localCount) + idx : idx - 1;
+}
+
+// Jeden narożnik ściany: v, v/vt, v//vn, v/vt/vn
+static const char* parseCorner(const char* p, const char* end, ObjChunk& chunk,
+                               tinyobj::index_t& idx, bool& relV, bool& relN) {
+    int v = 0, n = 0;
+
+    p = parseInt(p, end, v);
+    if (!p || v == 0) return nullptr;
+
+    idx.vertex_index = resolveIndex(v, chunk.vertices.size() / 3, relV);
+    idx.normal_index = -1;
+    idx.texcoord_index = -1;
+    relN = false;
+
+    if (p < end && *p == '/') {
+        p++;
+        // Współrzędne tekstur pomijamy
+        while (p < end && (*p == '-' || (*p >= '0' && *p <= '9'))) p++;
+
+        if (p < end && *p == '/') {
+            p++;
+            p = parseInt(p, end, n);
+            if (!p || n == 0) return nullptr;
+            idx.normal_index = resolveIndex(n, chunk.normals.size() / 3, relN);
+        }
+    }
+    return p;
+}
+
+static void parseChunk(ObjChunk& chunk) {
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+
+    std::vector<tinyobj::index_t> face;
+    std::vector<char> faceRelV, faceRelN;
+
+    chunk.line = 0;
+
+    while (p < end) {
+        chunk.line++;
+        p = skipSpaces(p, end);
+
+        if (p + 1 < end && p[0] == 'v' && isSpace(p[1])) {
+            float xyz[3];
+            p += 2;
+            for (int k = 0; k < 3; k++) {
+                p = skipSpaces(p, end);
+                p = ParseObjFloat(p, end, xyz[k]);
+                if (!p) { chunk.err = "niepoprawna linia 'v'"; return; }
+            }
+            chunk.vertices.insert(chunk.vertices.end(), xyz, xyz + 3);
+        }
+        else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+            float xyz[3];
+            p += 3;
+            for (int k = 0; k < 3; k++) {
+                p = skipSpaces(p, end);
+                p = ParseObjFloat(p, end, xyz[k]);
+                if (!p) { chunk.err = "niepoprawna linia 'vn'"; return; }
+            }
+            chunk.normals.insert(chunk.normals.end(), xyz, xyz + 3);
+        }
+        else if (p + 1 < end && p[0] == 'f' && isSpace(p[1])) {
+            p += 2;
+            face.clear();
+            faceRelV.clear();
+            faceRelN.clear();
+
+            while (true) {
+                p = skipSpaces(p, end);
+                if (p >= end || *p == '\n' || *p == '#') break;
+
+                tinyobj::index_t idx;
+                bool relV, relN;
+                p = parseCorner(p, end, chunk, idx, relV, relN);
+                if (!p) { chunk.err = "niepoprawna linia 'f'"; return; }
+
+                face.push_back(idx);
+                faceRelV.push_back(relV);
+                faceRelN.push_back(relN);
+            }
+
+            // Podział wielokąta na trójkąty (wachlarz od pierwszego wierzchołka)
+            for (size_t k = 2; k < face.size(); k++) {
+                const size_t tri[3] = {0, k - 1, k};
+                for (size_t c : tri) {
+                    uint32_t pos = static_cast<uint32_t>(chunk.corners.size());
+                    if (faceRelV[c]) chunk.relativeVertex.push_back(pos);
+                    if (faceRelN[c]) chunk.relativeNormal.push_back(pos);
+                    chunk.corners.push_back(face[c]);
+                }
+            }
+        }
+
+        p = skipLine(p, end);
+    }
+}
+
+bool ParseObjParallel(const std::string& path, tinyobj::attrib_t& attrib,
+                      std::vector<tinyobj::index_t>& corners, std::string& err) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        err = "nie można zmapować pliku " + path;
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(file.Data());
+    const size_t size = file.Size();
+
+    ThreadPool& pool = ThreadPool::Instance();
+
+    // Kilka fragmentów na wątek dla równomiernego obciążenia
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(4 * pool.ThreadCount(), size / minChunkSize));
+    std::vector<ObjChunk> chunks(chunkCount);
+
+    // Granice fragmentów zawsze tuż za znakiem nowej linii
+    const char* cursor = data;
+    for (size_t c = 0; c < chunkCount; c++) {
+        const char* target = data + size * (c + 1) / chunkCount;
+        const char* chunkEnd = c + 1 == chunkCount ? data + size : std::max(cursor, target);
+        if (chunkEnd < data + size) chunkEnd = skipLine(chunkEnd, data + size);
+
+        chunks[c].begin = cursor;
+        chunks[c].end = chunkEnd;
+        cursor = chunkEnd;
+    }
+
+    pool.ParallelFor(0, static_cast<int>(chunkCount), [&](int b, int e) {
+        for (int c = b; c < e; c++) parseChunk(chunks[c]);
+    }, 1);
+
+    // Przesunięcia fragmentów w tablicach wynikowych
+    std::vector<size_t> vertexBase(chunkCount + 1, 0), normalBase(chunkCount + 1, 0), cornerBase(chunkCount + 1, 0);
+    size_t lineBase = 0;
+
+    for (size_t c = 0; c < chunkCount; c++) {
+        if (!chunks[c].err.empty()) {
+            err = path + ":" + std::to_string(lineBase + chunks[c].line) + ": " + chunks[c].err;
+            return false;
+        }
+        lineBase += std::count(chunks[c].begin, chunks[c].end, '\n');
+
+        vertexBase[c + 1] = vertexBase[c] + chunks[c].vertices.size();
+        normalBase[c + 1] = normalBase[c] + chunks[c].normals.size();
+        cornerBase[c + 1] = cornerBase[c] + chunks[c].corners.size();
+    }
+
+    attrib.vertices.resize(vertexBase[chunkCount]);
+    attrib.normals.resize(normalBase[chunkCount]);
+    corners.resize(cornerBase[chunkCount]);
+
+    const int vertexCount = static_cast<int>(vertexBase[chunkCount] / 3);
+    const int normalCount = static_cast<int>(normalBase[chunkCount] / 3);
+    std::vector<char> invalid(chunkCount, 0);
+
+    // Kopiowanie wyników na swoje miejsca i poprawienie indeksów względnych
+    pool.ParallelFor(0, static_cast<int>(chunkCount), [&](int b, int e) {
+        for (int c = b; c < e; c++) {
+            ObjChunk& chunk = chunks[c];
+
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(), attrib.vertices.begin() + vertexBase[c]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), attrib.normals.begin() + normalBase[c]);
+
+            for (uint32_t pos : chunk.relativeVertex) chunk.corners[pos].vertex_index += static_cast<int>(vertexBase[c] / 3);
+            for (uint32_t pos : chunk.relativeNormal) {
+                chunk.corners[pos].normal_index += static_cast<int>(normalBase[c] / 3);
+                if (chunk.corners[pos].normal_index < 0) invalid[c] = 1;
+            }
+
+            for (const auto& idx : chunk.corners) {
+                if (idx.vertex_index < 0 || idx.vertex_index >= vertexCount || idx.normal_index >= normalCount) {
+                    invalid[c] = 1;
+                    break;
+                }
+            }
+
+            std::copy(chunk.corners.begin(), chunk.corners.end(), corners.begin() + cornerBase[c]);
+
+            // Zwolnienie pamięci fragmentu od razu po skopiowaniu
+            std::vector<float>().swap(chunk.vertices);
+            std::vector<float>().swap(chunk.normals);
+            std::vector<tinyobj::index_t>().swap(chunk.corners);
+        }
+    }, 1);
+
+    if (std::find(invalid.begin(), invalid.end(), 1) != invalid.end()) {
+        err = "indeks wierzchołka lub normalnej poza zakresem w " + path;
+        return false;
+    }
+
+    return true;
+}
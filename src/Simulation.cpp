@@ -1,17 +1,36 @@
 #include "Simulation.h"
 
-Simulation::Simulation(): mTimer(Timer::Instance()) {
+Simulation::Simulation(): mTimer(Timer::Instance()),
+    fluid(fluidSize, fluidDt, fluidIter, fluidDiff, fluidVisc),
+    fluidWorker(fluid, densityFade) {
+    fluid.advection = fluidAdvection;
+    fluid.vorticity = fluidVorticity;
+    fluid.pressure = fluidPressure;
+    fluid.skipQuiet = fluidSkipQuiet;
+    fluidObstaclesPending = false;
+
     // Nazwa okna
     window_name = "Fluid Simulation";
 
     // Ścieżka do naszego modelu 3D
-    model_path  = "assets/models/Propeller.obj";
+    model_path  = propellerPath;
 
     // Ścieżka do shaderów
     shader_path = "assets/shaders/";
 
     // Zmienna upewniająca się, że symulacja pracuje
     running = true;
+
+    // Sekcje mierzone co klatkę (czas całej klatki mierzy sam Timer)
+    timing.update      = mTimer.AddSection("update");
+    timing.render      = mTimer.AddSection("render");
+    timing.fluidStep   = mTimer.AddSection("fluid step");
+    timing.fluidWait   = mTimer.AddSection("fluid wait");
+    timing.voxelMesh   = mTimer.AddSection("voxel mesh");
+    timing.isosurface  = mTimer.AddSection("isosurface");
+    timing.volume      = mTimer.AddSection("volume");
+    timing.glyphs      = mTimer.AddSection("glyphs");
+    timing.streamlines = mTimer.AddSection("streamlines");
     
     // Initializujemy symulacje
     if (!Init()) running = false;
@@ -20,6 +39,15 @@ Simulation::Simulation(): mTimer(Timer::Instance()) {
     std::fill(keys, keys + numKeys, false);
     std::fill(simState, simState + numStates, true);
 
+    // Renderowanie objętościowe domyślnie wyłączone (klawisz 5)
+    simState[4] = false;
+
+    // Strzałki prędkości domyślnie wyłączone (klawisz 6)
+    simState[5] = false;
+
+    // Linie prądu domyślnie wyłączone (klawisz 7)
+    simState[6] = false;
+
     // Pozycja początkowa kamery
     camPos   = glm::vec3(0.0f, 0.0f, 5.0f);
     camFront = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -36,6 +64,7 @@ Simulation::Simulation(): mTimer(Timer::Instance()) {
 
     // Kąt obrotu naszej śruby
     propAngle = 0.0f;
+    titleTimer = titleInterval;
 
     // Matryce modeli przydatne jeśli chcemy transformacje, rotacje, czy skalownie
     propModel = glm::mat4(1.0f);
@@ -47,21 +76,41 @@ Simulation::Simulation(): mTimer(Timer::Instance()) {
 }
 
 Simulation::~Simulation() {
+    // Statystyki czasów z całego przebiegu
+    mTimer.Report(std::cout);
+
     std::cout << "Simulation -- Destroyed" << std::endl;
     
     if (propVAO) glDeleteVertexArrays(1, &propVAO);
     if (propVBO) glDeleteBuffers(1, &propVBO);
     if (propNBO) glDeleteBuffers(1, &propNBO);
+    if (propEBO) glDeleteBuffers(1, &propEBO);
 
     if (lineVAO) glDeleteVertexArrays(1, &lineVAO);
     if (lineVBO) glDeleteBuffers(1, &lineVBO);
 
-    if (voxelMeshVAO) glDeleteVertexArrays(1, &voxelMeshVAO);
-    if (voxelMeshVBO) glDeleteBuffers(1, &voxelMeshVBO);
+    voxelMesh.Destroy();
+
+    if (densityVAO) glDeleteVertexArrays(1, &densityVAO);
+    if (densityVBO) glDeleteBuffers(1, &densityVBO);
+    if (densityNBO) glDeleteBuffers(1, &densityNBO);
+    if (densityEBO) glDeleteBuffers(1, &densityEBO);
+
+    densityVolume.Destroy();
+    if (volumeVAO) glDeleteVertexArrays(1, &volumeVAO);
+    if (volumeVBO) glDeleteBuffers(1, &volumeVBO);
+    if (sceneDepthTex) glDeleteTextures(1, &sceneDepthTex);
+
+    velocityGlyphs.Destroy();
+    streamlines.Destroy();
+
+    if (cameraUBO) glDeleteBuffers(1, &cameraUBO);
 
     if (shaderProgramProp) glDeleteProgram(shaderProgramProp);
     if (shaderProgramLine) glDeleteProgram(shaderProgramLine);
     if (shaderProgramMesh) glDeleteProgram(shaderProgramMesh);
+    if (shaderProgramVolume) glDeleteProgram(shaderProgramVolume);
+    if (shaderProgramGlyph) glDeleteProgram(shaderProgramGlyph);
 
     if (glContext) {
         SDL_GL_DestroyContext(glContext);
@@ -182,6 +231,10 @@ GLuint Simulation::createShaderProgram(const std::string& vertName, const std::s
 
     if (!success) std::cerr << "[ERROR] Linkowanie programu nie powiodło się." << std::endl;
 
+    // Blok kamery (jeśli shader go używa) podpięty do wspólnego bufora
+    GLuint cameraIndex = glGetUniformBlockIndex(program, "Camera");
+    if (cameraIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, cameraIndex, cameraBlockBinding);
+
     // Po połączeniu programu shadery można usunąć z pamięci GPU
     glDeleteShader(vertex);
     glDeleteShader(fragment);
@@ -189,44 +242,21 @@ GLuint Simulation::createShaderProgram(const std::string& vertName, const std::s
     return program;
 }
 
-// Załadowanie prostego pliku .obj
-bool Simulation::loadObj(const std::string& path) {
-    // Struktura do przechowywania współrzędnych wierzchołków, wektorów normalnych i texcoords
-    tinyobj::attrib_t attrib;
-
-    // Wektory przechowujące kształty (mesh) i materiały z pliku OBJ
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-
-    // Ostrzeżenia
-    std::string warn, err;
-
-    // Wczytywanie pliku
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
-    if (!ret) {
-        std::cerr << "[ERROR] Nie można załadować pliku OBJ: " << warn << err << std::endl;
-        return false;
-    }
-
-    for (const auto& shape : shapes) {
-
-        // Iteracja po wszystkich indeksach w mesh (trójkątach)
-        for (const auto& idx : shape.mesh.indices) {
-            // Każdy - idx - posiada:
-            //      vertex_index -> index w attrib.vertices
-            //      normal_index -> index w attrib.normals
-            //      texcoord_index -> index w attrib.texcoords
-            // Prosty 1D array [x0, y0, z0, x1, y1, z1, ...]
-            propVertices.push_back(attrib.vertices[3 * idx.vertex_index + 0]);
-            propVertices.push_back(attrib.vertices[3 * idx.vertex_index + 1]);
-            propVertices.push_back(attrib.vertices[3 * idx.vertex_index + 2]);
-
-            propNormals.push_back(attrib.normals[3 * idx.normal_index + 0]);
-            propNormals.push_back(attrib.normals[3 * idx.normal_index + 1]);
-            propNormals.push_back(attrib.normals[3 * idx.normal_index + 2]);
-        }
-    }
-    return true;
+// Zlecenie wczytania pliku .obj w tle, model pojawi się po odebraniu wyniku w EarlyUpdate
+void Simulation::loadObj(const std::string& path) {
+    std::unique_ptr<ModelJob> job(new ModelJob());
+    job->path = path;
+    job->voxelRes = cubeNum;
+    job->voxelSize = voxelMeshScale;
+    job->voxelOrigin = -glm::vec3(cubeNum, cubeNum, cubeNum) * voxelMeshScale * 0.5f;
+
+    // Środki komórek maski w węzłach siatki cieczy (ten sam rozstaw co powierzchnia barwnika)
+    float fluidCell = cubeNum * voxelMeshScale / (fluidSize - 1);
+    job->fluidRes = fluidSize;
+    job->fluidCellSize = fluidCell;
+    job->fluidOrigin = job->voxelOrigin - glm::vec3(0.5f * fluidCell);
+
+    modelLoader.Request(std::move(job));
 }
 
 // Initializacja SDL3, Glad (opengl), shaderów i załadowanie pliku Propeller.obj
@@ -267,11 +297,19 @@ bool Simulation::Init() {
 
     glEnable(GL_DEPTH_TEST);
 
-    // Wczytanie modelu z pliku OBJ
-    if (!loadObj(model_path)) return false;
+    if (!CreateCameraBlock()) {
+        std::cerr << "[ERROR] Nie utworzono bufora bloku kamery." << std::endl;
+        return false;
+    }
+
+    // Wczytanie modelu z pliku OBJ -- w tle, okno działa od razu
+    loadObj(model_path);
 
-    // Funkcja niepotrzebna ponieważ została zaimplementowna klasa Timer
-    // SDL_GL_SetSwapInterval(1); // V-sync
+    // V-sync, jeśli dostępny -- wtedy klatki odmierza SDL_GL_SwapWindow
+    // W przeciwnym razie FramePacer usypia wątek do terminu następnej klatki
+    framePacer.SetRate(FRAME_RATE);
+    framePacer.SetVsync(useVsync && SDL_GL_SetSwapInterval(1));
+    std::cout << "V-sync: " << (framePacer.Vsync() ? "tak" : "nie") << std::endl;
 
     if (!CreatePropeller()) {
         std::cerr << "[ERROR] Nie utworzono programu dla shadera śruby." << std::endl;
@@ -287,11 +325,48 @@ bool Simulation::Init() {
         std::cerr << "[ERROR] Nie utworzono programu dla shadera linii osi." << std::endl;
         return false;
     }
+
+    if (!CreateDensity()) {
+        std::cerr << "[ERROR] Nie utworzono buforów gęstości barwnika." << std::endl;
+        return false;
+    }
+
+    if (!CreateVolume()) {
+        std::cerr << "[ERROR] Nie utworzono tekstury 3D dla renderowania objętościowego." << std::endl;
+        return false;
+    }
+
+    if (!CreateGlyphs()) {
+        std::cerr << "[ERROR] Nie utworzono programu dla shadera strzałek prędkości." << std::endl;
+        return false;
+    }
+
+    if (!CreateStreamlines()) {
+        std::cerr << "[ERROR] Nie utworzono buforów linii prądu." << std::endl;
+        return false;
+    }
     
     return true;
 }
 
+// Wspólny UBO z macierzami kamery, podpięty na stałe do cameraBlockBinding
+bool Simulation::CreateCameraBlock() {
+    glGenBuffers(1, &cameraUBO);
+    if (!cameraUBO) return false;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, cameraBlockBinding, cameraUBO);
+
+    return true;
+}
+
 bool Simulation::CreatePropeller() {
+    // Bufory są puste do czasu wczytania modelu przez ModelLoader
+    propIndexCount = 0;
+
     // Tworzenie i wiązanie Vertex Array Object (VAO)
     glGenVertexArrays(1, &propVAO);
     glBindVertexArray(propVAO);
@@ -299,17 +374,21 @@ bool Simulation::CreatePropeller() {
     // Tworzenie Vertex Buffer Object (VBO) dla wierzchołków
     glGenBuffers(1, &propVBO);
     glBindBuffer(GL_ARRAY_BUFFER, propVBO);
-    glBufferData(GL_ARRAY_BUFFER, propVertices.size() * sizeof(float), propVertices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
     glEnableVertexAttribArray(0);
 
     // Tworzenie Vertex Buffer Object (NBO) dla wektorów normalnych
     glGenBuffers(1, &propNBO);
     glBindBuffer(GL_ARRAY_BUFFER, propNBO);
-    glBufferData(GL_ARRAY_BUFFER, propNormals.size() * sizeof(float), propNormals.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
     glEnableVertexAttribArray(1);
 
+    // Tworzenie Element Buffer Object (EBO) dla indeksów trójkątów
+    glGenBuffers(1, &propEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, propEBO);
+
+    glBindVertexArray(0);
+
     // Shadery
     shaderProgramProp = createShaderProgram(
         "vertex_shader.glsl", 
@@ -321,121 +400,113 @@ bool Simulation::CreatePropeller() {
     glUseProgram(shaderProgramProp);
 
     // Pobranie informacji z shaderów
-    uLocPropeller["model"] = glGetUniformLocation(shaderProgramProp, "model");
-    uLocPropeller["view"] = glGetUniformLocation(shaderProgramProp, "view");
-    uLocPropeller["projection"] = glGetUniformLocation(shaderProgramProp, "projection");
-    uLocPropeller["objectColor"] = glGetUniformLocation(shaderProgramProp, "objectColor");
-    uLocPropeller["lightPos"] = glGetUniformLocation(shaderProgramProp, "lightPos");
-    uLocPropeller["lightColor"] = glGetUniformLocation(shaderProgramProp, "lightColor");
-    uLocPropeller["lightPos2"] = glGetUniformLocation(shaderProgramProp, "lightPos2");
-    uLocPropeller["lightColor2"] = glGetUniformLocation(shaderProgramProp, "lightColor2");
-
-    // Ustawienie koloru obiektu (szare)
-    glUniform3f(uLocPropeller["objectColor"], 0.5f, 0.5f, 0.5f); 
+    uLocPropeller.model = glGetUniformLocation(shaderProgramProp, "model");
+    uLocPropeller.objectColor = glGetUniformLocation(shaderProgramProp, "objectColor");
+    uLocPropeller.lightPos = glGetUniformLocation(shaderProgramProp, "lightPos");
+    uLocPropeller.lightColor = glGetUniformLocation(shaderProgramProp, "lightColor");
+    uLocPropeller.lightPos2 = glGetUniformLocation(shaderProgramProp, "lightPos2");
+    uLocPropeller.lightColor2 = glGetUniformLocation(shaderProgramProp, "lightColor2");
 
     // Ustawienie pozycji i koloru pierwszego światła
-    glUniform3f(uLocPropeller["lightPos"], 0.0f, 0.0f, 3.0f); 
-    glUniform3f(uLocPropeller["lightColor"], 1.0f, 1.0f, 1.0f); 
+    glUniform3f(uLocPropeller.lightPos, 0.0f, 0.0f, 3.0f); 
+    glUniform3f(uLocPropeller.lightColor, 1.0f, 1.0f, 1.0f); 
 
     // Ustawienie pozycji i koloru drugiego światła
-    glUniform3f(uLocPropeller["lightPos2"], 0.0f, 0.0f, -3.0f); 
-    glUniform3f(uLocPropeller["lightColor2"], 1.0f, 1.0f, 1.0f); 
+    glUniform3f(uLocPropeller.lightPos2, 0.0f, 0.0f, -3.0f); 
+    glUniform3f(uLocPropeller.lightColor2, 1.0f, 1.0f, 1.0f); 
 
     return true;
 }
 
+// Wysłanie wczytanego w tle modelu na GPU (wątek OpenGL)
+// Dane czytane są bezpośrednio ze zmapowanego cache, po czym zadanie jest zwalniane
+void Simulation::UploadPropeller(const ModelJob& job) {
+    const MeshView& mesh = job.mesh;
+
+    glBindVertexArray(propVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, propVBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * 3 * sizeof(float), mesh.positions, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, propNBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * 3 * sizeof(float), mesh.normals, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, propEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount * sizeof(uint32_t), mesh.indices, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+
+    propIndexCount = static_cast<GLsizei>(mesh.indexCount);
+    obstacleVoxels = job.voxels;
+
+    // Fluid może właśnie liczyć krok w tle -- maska zostanie podpięta po Wait() w UpdateDensity
+    pendingFluidObstacles = job.fluidVoxels;
+    fluidObstaclesPending = true;
+
+    if (showObstacles) setVoxels(obstacleVoxels);
+}
+
+// Podmiana zawartości siatki voxeli, przebudowane zostaną tylko fragmenty ze zmienionymi komórkami
+void Simulation::setVoxels(const VoxelGrid& grid) {
+    if (grid.Res() != cubeNum) return;
+
+    voxelMesh.MarkChanged(voxels, grid);
+    voxels = grid;
+}
+
+// Przełączanie siatki voxeli: pełna kostka / komórki zajęte przez model
+void Simulation::toggleObstacleView() {
+    showObstacles = !showObstacles;
+
+    if (showObstacles) {
+        setVoxels(obstacleVoxels);
+    }
+    else {
+        VoxelGrid full(cubeNum);
+        full.Fill();
+        setVoxels(full);
+    }
+}
+
+// Odebranie ukończonych zadań z kolejki ModelLoader
+void Simulation::pollLoadedModels() {
+    while (std::unique_ptr<ModelJob> job = modelLoader.Poll()) {
+        if (!job->ok) {
+            std::cerr << "[ERROR] Nie udało się wczytać modelu: " << job->path << std::endl;
+            continue;
+        }
+        UploadPropeller(*job);
+    }
+}
+
 void Simulation::DrawPropeller() {
+    // Model jeszcze się wczytuje
+    if (propIndexCount == 0) return;
+
+
     // Renderowanie śruby
     glUseProgram(shaderProgramProp);
-    glUniformMatrix4fv(uLocPropeller["model"], 1, GL_FALSE, glm::value_ptr(propModel));
-    glUniformMatrix4fv(uLocPropeller["view"], 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniformMatrix4fv(uLocPropeller["projection"], 1, GL_FALSE, glm::value_ptr(projMatrix));
+    glUniformMatrix4fv(uLocPropeller.model, 1, GL_FALSE, glm::value_ptr(propModel));
+
+    // Ustawienie koloru obiektu (szare)
+    glUniform3f(uLocPropeller.objectColor, 0.5f, 0.5f, 0.5f);
 
     glBindVertexArray(propVAO);
-    glDrawArrays(GL_TRIANGLES, 0, propVertices.size() / 3);
+    glDrawElements(GL_TRIANGLES, propIndexCount, GL_UNSIGNED_INT, (void*)0);
     glBindVertexArray(0);
 }
 
 bool Simulation::CreateVoxelMesh() {
-    float voxelMeshScale = 0.2f; // zmiana skali na 1:5
     glm::vec3 voxelMeshOffset = glm::vec3(cubeNum, cubeNum, cubeNum) * voxelMeshScale * 0.5f;
 
-    const glm::vec3 faceVertices[faceNum][vertsPerFace] = {
-        // +X
-        { {1,0,0},{1,1,0},{1,1,1},  {1,1,1},{1,0,1},{1,0,0} },
-        // -X
-        { {0,0,0},{0,0,1},{0,1,1},  {0,1,1},{0,1,0},{0,0,0} },
-        // +Y
-        { {0,1,0},{0,1,1},{1,1,1},  {1,1,1},{1,1,0},{0,1,0} },
-        // -Y
-        { {0,0,0},{1,0,0},{1,0,1},  {1,0,1},{0,0,1},{0,0,0} },
-        // +Z
-        { {0,0,1},{1,0,1},{1,1,1},  {1,1,1},{0,1,1},{0,0,1} },
-        // -Z
-        { {0,0,0},{0,1,0},{1,1,0},  {1,1,0},{1,0,0},{0,0,0} }
-    };
-
-    // Kierunki są używane do sprawdzania sąsiadów każdej komórki 'voxel'
-    // Każdy indeks odpowiada jednej ścianie (face) w kolejności: +X, -X, +Y, -Y, +Z, -Z
-    const int dirX[faceNum] = {1, -1, 0, 0, 0, 0}; // zmiana w osi X dla sąsiada
-    const int dirY[faceNum] = {0, 0, 1, -1, 0, 0}; // zmiana w osi Y dla sąsiada
-    const int dirZ[faceNum] = {0, 0, 0, 0, 1, -1}; // zmiana w osi Z dla sąsiada
-
-    voxelMeshVertices.clear();
-
     // Inicjalizacja wszystkich voxelów jako "solid" (pełne)
-    for(int x = 0; x < cubeNum; x++)
-        for(int y = 0; y < cubeNum; y++)
-            for(int z = 0; z < cubeNum; z++)
-                voxels[x][y][z] = true;
-
-    // Generowanie wierzchołków siatki tylko dla widocznych ścian
-    for (int x = 0; x < cubeNum; x++)
-        for (int y = 0; y < cubeNum; y++)
-            for (int z = 0; z < cubeNum; z++) {
-
-                if (!voxels[x][y][z]) continue; // pomiń puste komórki
-
-                // Sprawdzenie każdej ze 6 ścian komórki
-                for (int face = 0; face < faceNum; face++) {
-
-                    // Pozycja sąsiada w danym kierunku
-                    int nx = x + dirX[face];
-                    int ny = y + dirY[face];
-                    int nz = z + dirZ[face];
-
-                    // Sprawdzenie, czy sąsiad istnieje i jest pełny
-                    bool neighborSolid =
-                        nx >= 0 && nx < cubeNum &&
-                        ny >= 0 && ny < cubeNum &&
-                        nz >= 0 && nz < cubeNum &&
-                        voxels[nx][ny][nz];
-
-                    if (!neighborSolid) {
-                        // Ta ściana jest widoczna (nie ma pełnego sąsiada)
-                        for (int i = 0; i < vertsPerFace; i++) {
-                            // Dodanie wierzchołków ściany do wektora mesh
-                            // Uwzględniamy skalowanie i przesunięcie, żeby cała siatka była wycentrowana
-                            voxelMeshVertices.push_back((faceVertices[face][i].x + x) * voxelMeshScale - voxelMeshOffset.x);
-                            voxelMeshVertices.push_back((faceVertices[face][i].y + y) * voxelMeshScale - voxelMeshOffset.y);
-                            voxelMeshVertices.push_back((faceVertices[face][i].z + z) * voxelMeshScale - voxelMeshOffset.z);
-                        }
-                    }
-                }
-            }
-            
-    glGenVertexArrays(1, &voxelMeshVAO);
-    glGenBuffers(1, &voxelMeshVBO);
-
-    glBindVertexArray(voxelMeshVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, voxelMeshVBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 voxelMeshVertices.size() * sizeof(float),
-                 voxelMeshVertices.data(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT,GL_FALSE,3*sizeof(float),(void*)0);
-    glEnableVertexAttribArray(0);
+    showObstacles = false;
+    voxels.Resize(cubeNum);
+    voxels.Fill();
+
+    // Siatka podzielona na fragmenty 16^3, po zmianach przebudowywane są tylko zmienione fragmenty
+    if (!voxelMesh.Create(cubeNum, voxelMeshScale, voxelMeshOffset)) return false;
+    voxelMesh.Update(voxels);
 
     shaderProgramMesh = createShaderProgram(
         "mesh_vert_shader.glsl", 
@@ -446,15 +517,8 @@ bool Simulation::CreateVoxelMesh() {
 
     glUseProgram(shaderProgramMesh);
 
-    uLocMesh["projection"] = glGetUniformLocation(shaderProgramMesh, "projection");
-    uLocMesh["view"] = glGetUniformLocation(shaderProgramMesh, "view");
-    uLocMesh["model"] = glGetUniformLocation(shaderProgramMesh, "model");
-    uLocMesh["meshColor"] = glGetUniformLocation(shaderProgramMesh, "meshColor");
-    
-    std::cout << "model=" << uLocMesh["model"] 
-          << ", view=" << uLocMesh["view"]
-          << ", projection=" << uLocMesh["projection"]
-          << ", meshColor=" << uLocMesh["meshColor"] << std::endl;
+    uLocMesh.model = glGetUniformLocation(shaderProgramMesh, "model");
+    uLocMesh.meshColor = glGetUniformLocation(shaderProgramMesh, "meshColor");
 
     return true;
 }
@@ -462,16 +526,12 @@ bool Simulation::CreateVoxelMesh() {
 void Simulation::DrawVoxelMesh() {
     glUseProgram(shaderProgramMesh);
 
-    glUniformMatrix4fv(uLocMesh["model"], 1, GL_FALSE, glm::value_ptr(voxelMeshModel));
-    glUniformMatrix4fv(uLocMesh["view"], 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniformMatrix4fv(uLocMesh["projection"], 1, GL_FALSE, glm::value_ptr(projMatrix));
-    glUniform3f(uLocMesh["meshColor"], 1.0f, 0.0f, 0.0f);
+    glUniformMatrix4fv(uLocMesh.model, 1, GL_FALSE, glm::value_ptr(voxelMeshModel));
+    glUniform3f(uLocMesh.meshColor, 1.0f, 0.0f, 0.0f);
     
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     
-    glBindVertexArray(voxelMeshVAO);
-    glDrawArrays(GL_TRIANGLES, 0, voxelMeshVertices.size() / 3);
-    glBindVertexArray(0);
+    voxelMesh.Draw();
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
@@ -510,10 +570,8 @@ bool Simulation::CreateAxis() {
     if (!shaderProgramLine) return false;
 
     glUseProgram(shaderProgramLine);
-    uLocLine["projection"] = glGetUniformLocation(shaderProgramLine, "projection");
-    uLocLine["view"] = glGetUniformLocation(shaderProgramLine, "view");
-    uLocLine["model"] = glGetUniformLocation(shaderProgramLine, "model");
-    uLocLine["lineColor"] = glGetUniformLocation(shaderProgramLine, "lineColor");
+    uLocLine.model = glGetUniformLocation(shaderProgramLine, "model");
+    uLocLine.lineColor = glGetUniformLocation(shaderProgramLine, "lineColor");
 
     return true;
 }
@@ -522,28 +580,334 @@ bool Simulation::CreateAxis() {
 void Simulation::DrawAxis() {
     glUseProgram(shaderProgramLine);
 
-    glUniformMatrix4fv(uLocLine["model"], 1, GL_FALSE, glm::value_ptr(lineModel));
-    glUniformMatrix4fv(uLocLine["view"], 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniformMatrix4fv(uLocLine["projection"], 1, GL_FALSE, glm::value_ptr(projMatrix));
+    glUniformMatrix4fv(uLocLine.model, 1, GL_FALSE, glm::value_ptr(lineModel));
 
     glBindVertexArray(lineVAO);
     glLineWidth(2.0f);
     // Draw x-axis (red)
-    glUniform3f(uLocLine["lineColor"], 1.0f, 0.0f, 0.0f);
+    glUniform3f(uLocLine.lineColor, 1.0f, 0.0f, 0.0f);
     glDrawArrays(GL_LINES, 0, 2);
     
     // Draw y-axis (green)  
-    glUniform3f(uLocLine["lineColor"], 0.0f, 1.0f, 0.0f);
+    glUniform3f(uLocLine.lineColor, 0.0f, 1.0f, 0.0f);
     glDrawArrays(GL_LINES, 2, 2);
     
     // Draw z-axis (blue)
-    glUniform3f(uLocLine["lineColor"], 0.0f, 0.0f, 1.0f);
+    glUniform3f(uLocLine.lineColor, 0.0f, 0.0f, 1.0f);
     glDrawArrays(GL_LINES, 4, 2);
 
     glBindVertexArray(0);
 }
 
+bool Simulation::CreateDensity() {
+    densityIndexCount = 0;
+    densityVertexBytes = densityIndexBytes = 0;
+
+    glGenVertexArrays(1, &densityVAO);
+    glBindVertexArray(densityVAO);
+
+    // Bufory wypełniane co klatkę w UpdateDensity
+    glGenBuffers(1, &densityVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, densityVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &densityNBO);
+    glBindBuffer(GL_ARRAY_BUFFER, densityNBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glEnableVertexAttribArray(1);
+
+    glGenBuffers(1, &densityEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, densityEBO);
+
+    glBindVertexArray(0);
+
+    return densityVAO && densityVBO && densityNBO && densityEBO;
+}
+
+// Wizualizacje stanu cieczy i zlecenie następnego kroku symulacji
+// Krok liczy się w tle (FluidWorker) podczas renderowania i oczekiwania na klatkę,
+// więc wizualizacje pokazują stan sprzed kroku liczonego w tej klatce
+void Simulation::UpdateDensity() {
+    // Poprzedni krok musi się skończyć, zanim dotkniemy tablic Fluid
+    {
+        Timer::Scope scope(timing.fluidWait);
+        fluidWorker.Wait();
+    }
+    if (fluidWorker.LastStepNs()) mTimer.Record(timing.fluidStep, fluidWorker.LastStepNs());
+
+    // Nowa maska przeszkód z wczytanego modelu
+    if (fluidObstaclesPending) {
+        fluidObstacles = pendingFluidObstacles;
+        fluidObstaclesPending = false;
+        if (!fluid.SetObstacles(&fluidObstacles))
+            std::cerr << "[ERROR] Model nie będzie przeszkodą dla cieczy." << std::endl;
+    }
+
+    // Źródło barwnika i przepływ wzdłuż osi obrotu śruby (+Z)
+    int c = fluidSize / 2;
+    for (int k = -1; k <= 1; k++)
+        for (int j = -1; j <= 1; j++)
+            for (int i = -1; i <= 1; i++) {
+                fluid.AddDensity(c + i, c + j, c / 2 + k, 5.0f);
+                fluid.AddVelocity(c + i, c + j, c / 2 + k, 0.0f, 0.0f, 0.5f);
+            }
+
+    // Tekstura 3D -- wysyłane są tylko zmienione płaszczyzny z
+    if (simState[4]) {
+        Timer::Scope scope(timing.volume);
+        densityVolume.Update(fluid.density);
+    }
+
+    // Strzałki prędkości
+    if (simState[5]) {
+        Timer::Scope scope(timing.glyphs);
+        velocityGlyphs.Update(fluid.Vx, fluid.Vy, fluid.Vz);
+    }
+
+    // Linie prądu z bieżącego pola prędkości
+    if (simState[6]) {
+        Timer::Scope scope(timing.streamlines);
+        streamlines.Trace(fluid.Vx, fluid.Vy, fluid.Vz, streamlineStep);
+    }
+
+    // Powierzchnia izo barwnika
+    if (simState[3]) {
+        Timer::Scope scope(timing.isosurface);
+        UpdateDensitySurface();
+    }
+
+    fluidWorker.Start();
+}
+
+// Wyciągnięcie powierzchni barwnika i wysłanie jej na GPU
+void Simulation::UpdateDensitySurface() {
+    // Siatka cieczy rozpięta na tej samej kostce co siatka voxeli
+    float extent = cubeNum * voxelMeshScale;
+    glm::vec3 origin = -glm::vec3(extent * 0.5f);
+    densityExtractor.Extract(fluid.density, fluidSize, densityIso, extent / (fluidSize - 1), origin, densityMesh);
+
+    // Bufory GL rosną tylko gdy powierzchnia się nie mieści, w pozostałych klatkach glBufferSubData
+    GLsizeiptr vertexBytes = densityMesh.positions.size() * sizeof(float);
+    GLsizeiptr indexBytes = densityMesh.indices.size() * sizeof(uint32_t);
+    bool growVertices = vertexBytes > densityVertexBytes;
+    bool growIndices = indexBytes > densityIndexBytes;
+    if (growVertices) densityVertexBytes = std::max(vertexBytes, 2 * densityVertexBytes);
+    if (growIndices) densityIndexBytes = std::max(indexBytes, 2 * densityIndexBytes);
+
+    glBindVertexArray(densityVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, densityVBO);
+    if (growVertices) glBufferData(GL_ARRAY_BUFFER, densityVertexBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, densityMesh.positions.data());
+
+    glBindBuffer(GL_ARRAY_BUFFER, densityNBO);
+    if (growVertices) glBufferData(GL_ARRAY_BUFFER, densityVertexBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, densityMesh.normals.data());
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, densityEBO);
+    if (growIndices) glBufferData(GL_ELEMENT_ARRAY_BUFFER, densityIndexBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, densityMesh.indices.data());
+
+    glBindVertexArray(0);
+
+    densityIndexCount = static_cast<GLsizei>(densityMesh.indices.size());
+}
+
+// Renderowanie powierzchni barwnika tym samym shaderem co śruba
+void Simulation::DrawDensity() {
+    if (densityIndexCount == 0) return;
+
+    glUseProgram(shaderProgramProp);
+    glUniformMatrix4fv(uLocPropeller.model, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    glUniform3f(uLocPropeller.objectColor, 0.2f, 0.4f, 0.9f);
+
+    glBindVertexArray(densityVAO);
+    glDrawElements(GL_TRIANGLES, densityIndexCount, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+}
+
+bool Simulation::CreateVolume() {
+    if (!densityVolume.Create(fluidSize, volumeHalfFloat, volumeDensityMax)) return false;
+
+    // Kostka [0,1]^3, trójkąty przeciwnie do ruchu wskazówek patrząc z zewnątrz
+    std::vector<float> cube;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            if (!side) std::swap(u, v);
+
+            const float quad[6][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1} };
+            for (const float* q : quad) {
+                float p[3];
+                p[axis] = float(side);
+                p[u] = q[0];
+                p[v] = q[1];
+                cube.insert(cube.end(), p, p + 3);
+            }
+        }
+    }
+
+    glGenVertexArrays(1, &volumeVAO);
+    glBindVertexArray(volumeVAO);
+
+    glGenBuffers(1, &volumeVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, volumeVBO);
+    glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(float), cube.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+
+    // Tekstura głębokości sceny, rozmiar ustalany w DrawVolume według okna
+    glGenTextures(1, &sceneDepthTex);
+    glBindTexture(GL_TEXTURE_2D, sceneDepthTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    sceneDepthWidth = sceneDepthHeight = 0;
+
+    // Objętość rozpięta na tej samej kostce co siatka cieczy
+    float extent = cubeNum * voxelMeshScale;
+    volumeModel = glm::scale(glm::translate(glm::mat4(1.0f), -glm::vec3(extent * 0.5f)), glm::vec3(extent));
+
+    shaderProgramVolume = createShaderProgram(
+        "volume_vert_shader.glsl",
+        "volume_frag_shader.glsl"
+    );
+
+    if (!shaderProgramVolume) return false;
+
+    glUseProgram(shaderProgramVolume);
+
+    uLocVolume.model = glGetUniformLocation(shaderProgramVolume, "model");
+    uLocVolume.camLocal = glGetUniformLocation(shaderProgramVolume, "camLocal");
+    uLocVolume.volume = glGetUniformLocation(shaderProgramVolume, "volume");
+    uLocVolume.volumeColor = glGetUniformLocation(shaderProgramVolume, "volumeColor");
+    uLocVolume.opacity = glGetUniformLocation(shaderProgramVolume, "opacity");
+    uLocVolume.steps = glGetUniformLocation(shaderProgramVolume, "steps");
+    uLocVolume.clipToLocal = glGetUniformLocation(shaderProgramVolume, "clipToLocal");
+    uLocVolume.sceneDepth = glGetUniformLocation(shaderProgramVolume, "sceneDepth");
+
+    glUniform1i(uLocVolume.volume, 0);
+    glUniform1i(uLocVolume.sceneDepth, 1);
+    glUniform3f(uLocVolume.volumeColor, 0.2f, 0.4f, 0.9f);
+    glUniform1f(uLocVolume.opacity, volumeOpacity);
+    glUniform1i(uLocVolume.steps, volumeSteps);
+
+    return true;
+}
+
+// Raymarching gęstości: tylne ściany kostki, mieszanie z kolorem przemnożonym przez alfę
+// Rysowane na końcu bez testu głębokości (tylna ściana bywa zasłonięta, choć część promienia
+// przed sceną jest widoczna) -- zamiast tego shader ucina promień na głębokości sceny
+void Simulation::DrawVolume() {
+    glm::vec3 camLocal = glm::vec3(glm::inverse(volumeModel) * glm::vec4(camPos, 1.0f));
+    glm::mat4 clipToLocal = glm::inverse(projMatrix * viewMatrix * volumeModel);
+
+    glUseProgram(shaderProgramVolume);
+    glUniformMatrix4fv(uLocVolume.model, 1, GL_FALSE, glm::value_ptr(volumeModel));
+    glUniform3fv(uLocVolume.camLocal, 1, glm::value_ptr(camLocal));
+    glUniformMatrix4fv(uLocVolume.clipToLocal, 1, GL_FALSE, glm::value_ptr(clipToLocal));
+
+    // Głębokość po osiach, siatce voxeli, śmigle, izopowierzchni, strzałkach i liniach prądu
+    // kopiowana z domyślnego bufora ramki (rozmiar tekstury nadąża za oknem)
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, sceneDepthTex);
+    if (sceneDepthWidth != widthResize || sceneDepthHeight != heightResize) {
+        sceneDepthWidth = widthResize;
+        sceneDepthHeight = heightResize;
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, sceneDepthWidth, sceneDepthHeight, 0,
+                     GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    }
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, sceneDepthWidth, sceneDepthHeight);
+
+    densityVolume.Bind(GL_TEXTURE0);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glBindVertexArray(volumeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+bool Simulation::CreateGlyphs() {
+    // Siatka strzałek rozpięta na tej samej kostce co siatka cieczy
+    float extent = cubeNum * voxelMeshScale;
+    glm::vec3 origin = -glm::vec3(extent * 0.5f);
+    float cellSize = extent / (fluidSize - 1);
+
+    if (!velocityGlyphs.Create(fluidSize, glyphStride, cellSize, origin)) return false;
+
+    shaderProgramGlyph = createShaderProgram(
+        "glyph_vert_shader.glsl",
+        "glyph_frag_shader.glsl"
+    );
+
+    if (!shaderProgramGlyph) return false;
+
+    glUseProgram(shaderProgramGlyph);
+
+    uLocGlyph.glyphLength = glGetUniformLocation(shaderProgramGlyph, "glyphLength");
+    uLocGlyph.maxMagnitude = glGetUniformLocation(shaderProgramGlyph, "maxMagnitude");
+
+    // Najdłuższa strzałka sięga do sąsiedniego punktu siatki strzałek
+    glUniform1f(uLocGlyph.glyphLength, glyphStride * cellSize);
+
+    return true;
+}
+
+// Wszystkie strzałki jednym glDrawArraysInstanced
+void Simulation::DrawGlyphs() {
+    glUseProgram(shaderProgramGlyph);
+
+    glUniform1f(uLocGlyph.maxMagnitude, velocityGlyphs.MaxMagnitude());
+
+    velocityGlyphs.Draw();
+}
+
+bool Simulation::CreateStreamlines() {
+    float extent = cubeNum * voxelMeshScale;
+    glm::vec3 origin = -glm::vec3(extent * 0.5f);
+
+    if (!streamlines.Create(fluidSize, streamlineSeeds, streamlinePoints, extent / (fluidSize - 1), origin)) return false;
+
+    // Ziarna stałe w całym wnętrzu siatki cieczy, więc linie nie migoczą między klatkami
+    streamlines.SeedBox(glm::vec3(1.0f), glm::vec3(fluidSize - 2.0f), 1);
+
+    return true;
+}
+
+// Linie prądu shaderem linii (jeden glMultiDrawArrays)
+void Simulation::DrawStreamlines() {
+    glUseProgram(shaderProgramLine);
+
+    glUniformMatrix4fv(uLocLine.model, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    glUniform3f(uLocLine.lineColor, 0.9f, 0.9f, 0.2f);
+
+    glLineWidth(1.0f);
+    streamlines.Draw();
+}
+
 void Simulation::EarlyUpdate() {
+    // Modele wczytane w tle
+    pollLoadedModels();
+
     // Tworzenie macierzy projekcji perspektywy
     // Jeśli chcemy zmieniać rozmiar okna, przenieść tą funckję do Update
     SDL_GetWindowSize(mWindow, &widthResize, &heightResize);
@@ -552,6 +916,12 @@ void Simulation::EarlyUpdate() {
     // Aktualizacja kamery
     viewMatrix = glm::lookAt(camPos, camPos+camFront, camUp);
 
+    // Jedna aktualizacja bloku kamery na klatkę dla wszystkich shaderów
+    CameraBlock camera = { viewMatrix, projMatrix, glm::vec4(camPos, 1.0f) };
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &camera);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
     // Ogarniamy zmiany trybu 'capture'
     if (mouseCapture != wasCaptured) {
         if (mouseCapture) {
@@ -581,20 +951,30 @@ void Simulation::EarlyUpdate() {
 }
 
 void Simulation::Update() {
-    // Wyświetlenie FPS
-    // Jak na razie symulacja nie jest pod wielkim obciążeniem, więc wszystko jest dobrze
+    // Przebudowa zmienionych fragmentów siatki voxeli
+    {
+        Timer::Scope scope(timing.voxelMesh);
+        voxelMesh.Update(voxels);
+    }
+
+    // Symulacja cieczy
+    UpdateDensity();
+
+    // Wyświetlenie FPS i p99 czasu klatki z ostatnich próbek (pełne statystyki pod klawiszem T)
+    titleTimer += mTimer.DeltaTime();
+    if (titleTimer < titleInterval) return;
+    titleTimer = 0.0f;
+
     std::string FPS = std::to_string(1.0f / mTimer.DeltaTime());
     std::string ms = std::to_string(mTimer.DeltaTime() * 1000.0f);
-    SDL_SetWindowTitle(mWindow, (window_name + " - " + FPS + "FPS / " + ms + "ms.").c_str());
+    std::string p99 = std::to_string(mTimer.Summary(Timer::frameSection).p99);
+    SDL_SetWindowTitle(mWindow, (window_name + " - " + FPS + "FPS / " + ms + "ms / p99 " + p99 + "ms.").c_str());
 }
 
 void Simulation::LateUpdate() {
-    // Reset Timer'a, żeby liczył następne deltaTime
-     // Obrót śmigłem :)
+    // Obrót śmigłem :)
     propAngle += mTimer.DeltaTime() * glm::radians(80.0f); // Obrót 80°/s
     propModel = glm::rotate(glm::mat4(1.0f), propAngle, glm::vec3(0, 0, 1));
-
-    mTimer.Reset();
 }
 
 void Simulation::Render() {
@@ -610,6 +990,14 @@ void Simulation::Render() {
     if (simState[1]) DrawVoxelMesh();
     
     if (simState[2]) DrawPropeller();
+
+    if (simState[3]) DrawDensity();
+
+    if (simState[5]) DrawGlyphs();
+
+    if (simState[6]) DrawStreamlines();
+
+    if (simState[4]) DrawVolume();
     
     // Zamień bufor
     SDL_GL_SwapWindow(mWindow);
@@ -619,8 +1007,9 @@ void Simulation::Render() {
 void Simulation::Run() {
     while (running) {
 
-        // Aktualizowanie deltaTime
+        // Aktualizowanie deltaTime -- pełny czas poprzedniej klatki, łącznie z oczekiwaniem na jej termin
         mTimer.Update();
+        mTimer.Reset();
 
         while (SDL_PollEvent(&mEvents)) {
             if (mEvents.type == SDL_EVENT_QUIT) 
@@ -645,6 +1034,18 @@ void Simulation::Run() {
                     // Zminana trybu myszy za pomocą Q
                     case SDL_SCANCODE_Q: mouseCapture = !mouseCapture; break;
 
+                    // Statystyki czasów klatki i sekcji (T)
+                    case SDL_SCANCODE_T: mTimer.Report(std::cout); break;
+
+                    // Siatka voxeli: pełna / zajęta przez model (V)
+                    case SDL_SCANCODE_V: toggleObstacleView(); break;
+
+                    // Zmiana modelu za pomocą M (wczytanie w tle, bez przycięcia)
+                    case SDL_SCANCODE_M:
+                        model_path = model_path == propellerPath ? turbinePath : propellerPath;
+                        loadObj(model_path);
+                        break;
+
                     default: break;
                 }
 
@@ -659,12 +1060,18 @@ void Simulation::Run() {
 
         }
 
-        // Upewnienie się, że program będzie działał w danym zarkresie FPS
-        if (mTimer.DeltaTime() >= (1.0f / FRAME_RATE)) {
+        {
+            Timer::Scope scope(timing.update);
             EarlyUpdate();
             Update();
             LateUpdate();
+        }
+        {
+            Timer::Scope scope(timing.render);
             Render();
         }
+
+        // Uśpienie do następnej klatki -- w tym czasie w tle liczy się krok cieczy
+        framePacer.Wait();
     }
 }
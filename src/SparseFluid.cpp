@@ -0,0 +1,597 @@
+#include "SparseFluid.h"
+#include "FluidStencil.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+SparseFluid::SparseFluid(int size, float dt, int iter, float diffusion, float viscosity) {
+    this->size = size;
+    this->dt = dt;
+    this->iter = iter;
+    this->diff = diffusion;
+    this->visc = viscosity;
+
+    this->obstacles = nullptr;
+
+    std::fill(background, background + sparseFields, nullptr);
+    backgroundRes = 0;
+    fixedBlocks = false;
+
+    grid.Create(size, sparseFields);
+
+    int B = grid.BlocksPerAxis();
+    blockStamp.assign(size_t(B) * B * B, 0);
+    stamp = 0;
+}
+
+bool SparseFluid::SetObstacles(const VoxelGrid *grid) {
+    // Maska musi mieć tę samą rozdzielczość co siatka cieczy
+    if (grid && grid->Res() != this->size) {
+        std::cerr << "[ERROR] Maska przeszkód " << grid->Res() << "^3 nie pasuje do siatki cieczy "
+                  << this->size << "^3" << std::endl;
+        this->obstacles = nullptr;
+        return false;
+    }
+
+    this->obstacles = grid;
+    return true;
+}
+
+// Slot bloku z komórką (x, y, z); nowy blok dostaje wartości z tła i od razu trafia do listy
+// aktywnych bloków -- przy stałej liście (SetBlocks) nie ma kolejnego refreshBlocks, który by ją odświeżył
+int SparseFluid::activateAt(int x, int y, int z) {
+    int id = grid.BlockId(x >> sparseBlockBits, y >> sparseBlockBits, z >> sparseBlockBits);
+    if (grid.Slot(id) >= 0) return grid.Slot(id);
+
+    int slot = grid.Activate(id);
+    fillFromBackground(id);
+    linkBlocks();
+    return slot;
+}
+
+void SparseFluid::AddDensity(int x, int y, int z, float amount) {
+    int slot = activateAt(x, y, z);
+    grid.Data(sfDensity, slot)[BIX(x & sparseBlockMask, y & sparseBlockMask, z & sparseBlockMask)] += amount;
+}
+
+void SparseFluid::AddVelocity(int x, int y, int z, float amountX, float amountY, float amountZ) {
+    int slot = activateAt(x, y, z);
+    int index = BIX(x & sparseBlockMask, y & sparseBlockMask, z & sparseBlockMask);
+
+    grid.Data(sfVx, slot)[index] += amountX;
+    grid.Data(sfVy, slot)[index] += amountY;
+    grid.Data(sfVz, slot)[index] += amountZ;
+}
+
+float SparseFluid::Density(int x, int y, int z) const {
+    return grid.Get(sfDensity, x, y, z);
+}
+
+void SparseFluid::CopyDensity(float *out) const {
+    int N = this->size;
+    std::fill(out, out + size_t(N) * N * N, 0.0f);
+
+    for (const BlockLinks& b : links) {
+        const float *d = grid.Data(sfDensity, b.slot);
+        for (int lz = 0; lz < sparseBlockDim && b.z0 + lz < N; lz++)
+            for (int ly = 0; ly < sparseBlockDim && b.y0 + ly < N; ly++)
+                for (int lx = 0; lx < sparseBlockDim && b.x0 + lx < N; lx++)
+                    out[(b.x0 + lx) + size_t(b.y0 + ly) * N + size_t(b.z0 + lz) * N * N] = d[BIX(lx, ly, lz)];
+    }
+}
+
+void SparseFluid::SetBackground(const float *const fields[sparseFields], int res) {
+    std::copy(fields, fields + sparseFields, background);
+    backgroundRes = res;
+}
+
+void SparseFluid::SetBlocks(const std::vector<int>& ids) {
+    fixedBlocks = true;
+
+    std::vector<int> sorted(ids);
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nowe bloki (bez slotu przed Retain) dostają wartości z tła
+    std::vector<int> added;
+    for (int id : sorted)
+        if (grid.Slot(id) < 0) added.push_back(id);
+
+    grid.Retain(sorted);
+    linkBlocks();
+
+    for (int id : added) fillFromBackground(id);
+}
+
+void SparseFluid::fillFromBackground(int id) {
+    if (!backgroundRes) return;
+
+    int B = grid.BlocksPerAxis();
+    int x0 = (id % B) << sparseBlockBits, y0 = ((id / B) % B) << sparseBlockBits, z0 = (id / (B * B)) << sparseBlockBits;
+    int slot = grid.Slot(id);
+
+    for (int f = 0; f < sparseFields; f++) {
+        float *d = grid.Data(f, slot);
+        for (int lz = 0; lz < sparseBlockDim; lz++)
+            for (int ly = 0; ly < sparseBlockDim; ly++)
+                for (int lx = 0; lx < sparseBlockDim; lx++)
+                    d[BIX(lx, ly, lz)] = backgroundAt(f, x0 + lx, y0 + ly, z0 + lz);
+    }
+}
+
+void SparseFluid::Restrict(int f, float *coarse, float scale) const {
+    if (!backgroundRes) return;
+
+    int ratio = this->size / backgroundRes;
+    int R = backgroundRes;
+    float weight = scale / (ratio * ratio * ratio);
+
+    // Blok 8^3 pokrywa (8 / ratio)^3 komórek tła
+    int span = sparseBlockDim / ratio;
+    for (const BlockLinks& b : links) {
+        const float *d = grid.Data(f, b.slot);
+        for (int cz = 0; cz < span; cz++) {
+            for (int cy = 0; cy < span; cy++) {
+                for (int cx = 0; cx < span; cx++) {
+                    float sum = 0.0f;
+                    for (int dz = 0; dz < ratio; dz++)
+                        for (int dy = 0; dy < ratio; dy++)
+                            for (int dx = 0; dx < ratio; dx++)
+                                sum += d[BIX(cx * ratio + dx, cy * ratio + dy, cz * ratio + dz)];
+
+                    int x = b.x0 / ratio + cx, y = b.y0 / ratio + cy, z = b.z0 / ratio + cz;
+                    coarse[x + size_t(y) * R + size_t(z) * R * R] = sum * weight;
+                }
+            }
+        }
+    }
+}
+
+// Interpolacja trójliniowa tła w środku komórki (x, y, z) tej siatki
+float SparseFluid::backgroundAt(int f, int x, int y, int z) const {
+    if (!backgroundRes) return 0.0f;
+
+    int R = backgroundRes;
+    float ratio = float(this->size) / R;
+    const float *d = background[f];
+
+    float p[3] = { (x + 0.5f) / ratio - 0.5f, (y + 0.5f) / ratio - 0.5f, (z + 0.5f) / ratio - 0.5f };
+    int c0[3];
+    float w1[3];
+    for (int a = 0; a < 3; a++) {
+        p[a] = std::clamp(p[a], 0.0f, R - 1.001f);
+        c0[a] = static_cast<int>(p[a]);
+        w1[a] = p[a] - c0[a];
+    }
+
+    auto at = [&](int i, int j, int k) { return d[(c0[0] + i) + size_t(c0[1] + j) * R + size_t(c0[2] + k) * R * R]; };
+
+    float s1 = w1[0], t1 = w1[1], u1 = w1[2];
+    float s0 = 1.0f - s1, t0 = 1.0f - t1, u0 = 1.0f - u1;
+    return s0 * (t0 * (u0 * at(0, 0, 0) + u1 * at(0, 0, 1)) + t1 * (u0 * at(0, 1, 0) + u1 * at(0, 1, 1)))
+         + s1 * (t0 * (u0 * at(1, 0, 0) + u1 * at(1, 0, 1)) + t1 * (u0 * at(1, 1, 0) + u1 * at(1, 1, 1)));
+}
+
+size_t SparseFluid::Bytes() const {
+    return grid.Bytes() + blockStamp.size() * sizeof(uint32_t) + links.capacity() * sizeof(BlockLinks)
+           + (colorBlocks[0].capacity() + colorBlocks[1].capacity()) * sizeof(int);
+}
+
+// Nowa lista bloków: bloki z barwnikiem lub ruchem poszerzone o zasięg adwekcji w tym kroku
+void SparseFluid::refreshBlocks() {
+    int N = this->size;
+    int B = grid.BlocksPerAxis();
+
+    std::vector<int> live;
+    float maxSpeed = 0.0f;
+
+    for (int id : grid.Blocks()) {
+        int slot = grid.Slot(id);
+        const float *d = grid.Data(sfDensity, slot);
+        const float *u = grid.Data(sfVx, slot);
+        const float *v = grid.Data(sfVy, slot);
+        const float *w = grid.Data(sfVz, slot);
+
+        float maxDensity = 0.0f, maxVelocity = 0.0f;
+        for (int i = 0; i < sparseBlockCells; i++) {
+            maxDensity = std::max(maxDensity, std::fabs(d[i]));
+            maxVelocity = std::max(maxVelocity, std::max(std::fabs(u[i]), std::max(std::fabs(v[i]), std::fabs(w[i]))));
+        }
+
+        if (maxDensity > sparseDensityEpsilon || maxVelocity > sparseSpeedEpsilon) live.push_back(id);
+        maxSpeed = std::max(maxSpeed, maxVelocity);
+    }
+
+    // Cofnięcie w adwekcji sięga maxSpeed * dt * (N - 2) komórek wzdłuż każdej osi
+    int reach = 1 + static_cast<int>(maxSpeed * this->dt * (N - 2)) / sparseBlockDim;
+    reach = std::min(reach, B);
+
+    stamp++;
+    std::vector<int> ids;
+    for (int id : live) {
+        int bx = id % B, by = (id / B) % B, bz = id / (B * B);
+
+        for (int z = std::max(bz - reach, 0); z <= std::min(bz + reach, B - 1); z++)
+            for (int y = std::max(by - reach, 0); y <= std::min(by + reach, B - 1); y++)
+                for (int x = std::max(bx - reach, 0); x <= std::min(bx + reach, B - 1); x++) {
+                    int n = grid.BlockId(x, y, z);
+                    if (blockStamp[n] == stamp) continue;
+                    blockStamp[n] = stamp;
+                    ids.push_back(n);
+                }
+    }
+
+    // Posortowane id = kolejność z, y, x, jak w pętlach Fluid
+    std::sort(ids.begin(), ids.end());
+    grid.Retain(ids);
+    linkBlocks();
+}
+
+void SparseFluid::linkBlocks() {
+    int B = grid.BlocksPerAxis();
+    const std::vector<int>& blocks = grid.Blocks();
+
+    links.resize(blocks.size());
+    colorBlocks[0].clear();
+    colorBlocks[1].clear();
+    for (size_t n = 0; n < blocks.size(); n++) {
+        int id = blocks[n];
+        int bx = id % B, by = (id / B) % B, bz = id / (B * B);
+        colorBlocks[(bx + by + bz) & 1].push_back(static_cast<int>(n));
+
+        BlockLinks& b = links[n];
+        b.slot = grid.Slot(id);
+        b.x0 = bx << sparseBlockBits;
+        b.y0 = by << sparseBlockBits;
+        b.z0 = bz << sparseBlockBits;
+
+        b.face[0] = bx > 0     ? grid.Slot(grid.BlockId(bx - 1, by, bz)) : -1;
+        b.face[1] = bx < B - 1 ? grid.Slot(grid.BlockId(bx + 1, by, bz)) : -1;
+        b.face[2] = by > 0     ? grid.Slot(grid.BlockId(bx, by - 1, bz)) : -1;
+        b.face[3] = by < B - 1 ? grid.Slot(grid.BlockId(bx, by + 1, bz)) : -1;
+        b.face[4] = bz > 0     ? grid.Slot(grid.BlockId(bx, by, bz - 1)) : -1;
+        b.face[5] = bz < B - 1 ? grid.Slot(grid.BlockId(bx, by, bz + 1)) : -1;
+    }
+}
+
+// Kafelek: wnętrze bloku i po jednej warstwie z sąsiadów przez ściany (brak sąsiada = tło)
+// Krawędzie i narożniki kafelka nie są używane przez stencil 6-punktowy
+void SparseFluid::gatherTile(int f, const BlockLinks& b, float *tile) const {
+    const int D = sparseBlockDim, M = sparseBlockMask;
+    const float *self = grid.Data(f, b.slot);
+    const float *nb[6];
+    for (int n = 0; n < 6; n++) nb[n] = b.face[n] < 0 ? nullptr : grid.Data(f, b.face[n]);
+
+    for (int lz = 0; lz < D; lz++) {
+        for (int ly = 0; ly < D; ly++) {
+            std::copy_n(self + BIX(0, ly, lz), D, tile + TIX(0, ly, lz));
+            tile[TIX(-1, ly, lz)] = nb[0] ? nb[0][BIX(M, ly, lz)] : backgroundAt(f, b.x0 - 1, b.y0 + ly, b.z0 + lz);
+            tile[TIX(D, ly, lz)]  = nb[1] ? nb[1][BIX(0, ly, lz)] : backgroundAt(f, b.x0 + D, b.y0 + ly, b.z0 + lz);
+        }
+        for (int lx = 0; lx < D; lx++) {
+            tile[TIX(lx, -1, lz)] = nb[2] ? nb[2][BIX(lx, M, lz)] : backgroundAt(f, b.x0 + lx, b.y0 - 1, b.z0 + lz);
+            tile[TIX(lx, D, lz)]  = nb[3] ? nb[3][BIX(lx, 0, lz)] : backgroundAt(f, b.x0 + lx, b.y0 + D, b.z0 + lz);
+        }
+    }
+    for (int ly = 0; ly < D; ly++) {
+        for (int lx = 0; lx < D; lx++) {
+            tile[TIX(lx, ly, -1)] = nb[4] ? nb[4][BIX(lx, ly, M)] : backgroundAt(f, b.x0 + lx, b.y0 + ly, b.z0 - 1);
+            tile[TIX(lx, ly, D)]  = nb[5] ? nb[5][BIX(lx, ly, 0)] : backgroundAt(f, b.x0 + lx, b.y0 + ly, b.z0 + D);
+        }
+    }
+}
+
+// Interpolacja trójliniowa pola f, (x, y, z) w [0.5, size - 1.5]
+float SparseFluid::sample(int f, float x, float y, float z) const {
+    int i0 = static_cast<int>(x), j0 = static_cast<int>(y), k0 = static_cast<int>(z);
+
+    int lx = i0 & sparseBlockMask, ly = j0 & sparseBlockMask, lz = k0 & sparseBlockMask;
+    int slot = grid.SlotAt(i0, j0, k0);
+    float c[8];
+
+    if (slot >= 0 && lx < sparseBlockMask && ly < sparseBlockMask && lz < sparseBlockMask) {
+        // Wszystkie narożniki w jednym bloku
+        const float *d = grid.Data(f, slot) + BIX(lx, ly, lz);
+        const int dy = sparseBlockDim, dz = sparseBlockDim * sparseBlockDim;
+        c[0] = d[0];      c[1] = d[dz];
+        c[2] = d[dy];     c[3] = d[dy + dz];
+        c[4] = d[1];      c[5] = d[1 + dz];
+        c[6] = d[1 + dy]; c[7] = d[1 + dy + dz];
+    }
+    else if (slot < 0 && !backgroundRes && lx < sparseBlockMask && ly < sparseBlockMask && lz < sparseBlockMask) {
+        return 0.0f;
+    }
+    else {
+        // Narożniki w sąsiednich blokach lub w tle -- pozycja przycięta do siatki, więc bez sprawdzania zakresu
+        for (int n = 0; n < 8; n++) {
+            int i = i0 + ((n >> 2) & 1), j = j0 + ((n >> 1) & 1), k = k0 + (n & 1);
+            int cs = grid.SlotAt(i, j, k);
+            c[n] = cs < 0 ? backgroundAt(f, i, j, k) : grid.Data(f, cs)[BIX(i & sparseBlockMask, j & sparseBlockMask, k & sparseBlockMask)];
+        }
+    }
+
+    return TrilinearCell(c, x - i0, y - j0, z - k0);
+}
+
+// Zerowanie prędkości w komórkach przeszkód aktywnych bloków
+// Blok zaczyna się na wielokrotności 8, więc jego 8 bitów wiersza leży w jednym słowie maski
+void SparseFluid::apply_obstacles(int b, int f) {
+    if (!this->obstacles || b == 0) return;
+
+    int N = this->size;
+    for (const BlockLinks& bl : links) {
+        float *x = grid.Data(f, bl.slot);
+        for (int lz = 0; lz < sparseBlockDim && bl.z0 + lz < N; lz++) {
+            for (int ly = 0; ly < sparseBlockDim && bl.y0 + ly < N; ly++) {
+                const uint64_t *row = this->obstacles->Row(bl.y0 + ly, bl.z0 + lz);
+                uint64_t bits = (row[bl.x0 >> 6] >> (bl.x0 & 63)) & 0xFF;
+                while (bits) {
+                    x[BIX(__builtin_ctzll(bits), ly, lz)] = 0.0f;
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+}
+
+// Ściany siatki jak w Fluid::set_bounds, tylko w aktywnych blokach
+void SparseFluid::set_bounds(int b, int f) {
+    int N = this->size;
+
+    // Zakres komórek wnętrza [1, N - 2] w bloku zaczynającym się od o
+    auto lo = [&](int o) { return std::max(1, o) - o; };
+    auto hi = [&](int o) { return std::min(N - 1, o + sparseBlockDim) - o; };
+
+    for (const BlockLinks& bl : links) {
+        float *x = grid.Data(f, bl.slot);
+
+        int ilo = lo(bl.x0), ihi = hi(bl.x0);
+        int jlo = lo(bl.y0), jhi = hi(bl.y0);
+        int klo = lo(bl.z0), khi = hi(bl.z0);
+
+        bool minX = bl.x0 == 0, maxX = N - 1 < bl.x0 + sparseBlockDim;
+        bool minY = bl.y0 == 0, maxY = N - 1 < bl.y0 + sparseBlockDim;
+        bool minZ = bl.z0 == 0, maxZ = N - 1 < bl.z0 + sparseBlockDim;
+
+        if (minZ || maxZ) {
+            for (int ly = jlo; ly < jhi; ly++) {
+                for (int lx = ilo; lx < ihi; lx++) {
+                    int i = bl.x0 + lx, j = bl.y0 + ly;
+                    if (minZ) x[BIX(lx, ly, 0)] = b == 3 ? -x[BIX(lx, ly, 1)] : x[BIX(lx, ly, 1)];
+                    if (maxZ) {
+                        float v = grid.Get(f, i, j, N - 2);
+                        x[BIX(lx, ly, N - 1 - bl.z0)] = b == 3 ? -v : v;
+                    }
+                }
+            }
+        }
+        if (minY || maxY) {
+            for (int lz = klo; lz < khi; lz++) {
+                for (int lx = ilo; lx < ihi; lx++) {
+                    int i = bl.x0 + lx, k = bl.z0 + lz;
+                    if (minY) x[BIX(lx, 0, lz)] = b == 2 ? -x[BIX(lx, 1, lz)] : x[BIX(lx, 1, lz)];
+                    if (maxY) {
+                        float v = grid.Get(f, i, N - 2, k);
+                        x[BIX(lx, N - 1 - bl.y0, lz)] = b == 2 ? -v : v;
+                    }
+                }
+            }
+        }
+        if (minX || maxX) {
+            for (int lz = klo; lz < khi; lz++) {
+                for (int ly = jlo; ly < jhi; ly++) {
+                    int j = bl.y0 + ly, k = bl.z0 + lz;
+                    if (minX) x[BIX(0, ly, lz)] = b == 1 ? -x[BIX(1, ly, lz)] : x[BIX(1, ly, lz)];
+                    if (maxX) {
+                        float v = grid.Get(f, N - 2, j, k);
+                        x[BIX(N - 1 - bl.x0, ly, lz)] = b == 1 ? -v : v;
+                    }
+                }
+            }
+        }
+    }
+
+    // Narożniki -- średnia trzech sąsiadów, jeśli narożny blok jest aktywny
+    for (int c = 0; c < 8; c++) {
+        int i = (c & 1) ? N - 1 : 0, j = (c & 2) ? N - 1 : 0, k = (c & 4) ? N - 1 : 0;
+        int slot = grid.SlotAt(i, j, k);
+        if (slot < 0) continue;
+
+        int ni = (c & 1) ? N - 2 : 1, nj = (c & 2) ? N - 2 : 1, nk = (c & 4) ? N - 2 : 1;
+        grid.Data(f, slot)[BIX(i & sparseBlockMask, j & sparseBlockMask, k & sparseBlockMask)] =
+            CornerCell(grid.Get(f, ni, j, k), grid.Get(f, i, nj, k), grid.Get(f, i, j, nk));
+    }
+
+    apply_obstacles(b, f);
+}
+
+// Gauss-Seidel na kafelkach, bloki w kolejności czerwono-czarnej: najpierw bloki z (bx + by + bz)
+// parzystym, równolegle w ThreadPool, potem nieparzyste. Kafelek czyta tylko sąsiadów przez ściany,
+// czyli bloki drugiego koloru, więc wynik nie zależy od liczby wątków ani kolejności w 'links'.
+// Wewnątrz bloku komórki idą po kolei jak w Fluid::lin_solve.
+void SparseFluid::lin_solve(int b, int xf, int x0f, float a, float c) {
+    int N = this->size;
+    const int ty = sparseTileDim, tz = sparseTileDim * sparseTileDim;
+
+    float cRecip = 1.0f / c;
+
+    auto relaxBlock = [&](const BlockLinks& bl) {
+        float tile[sparseTileCells];
+        float *x = grid.Data(xf, bl.slot);
+        const float *x0 = grid.Data(x0f, bl.slot);
+        gatherTile(xf, bl, tile);
+
+        int ilo = std::max(1, bl.x0) - bl.x0, ihi = std::min(N - 1, bl.x0 + sparseBlockDim) - bl.x0;
+        int jlo = std::max(1, bl.y0) - bl.y0, jhi = std::min(N - 1, bl.y0 + sparseBlockDim) - bl.y0;
+        int klo = std::max(1, bl.z0) - bl.z0, khi = std::min(N - 1, bl.z0 + sparseBlockDim) - bl.z0;
+
+        for (int lz = klo; lz < khi; lz++) {
+            for (int ly = jlo; ly < jhi; ly++) {
+                for (int lx = ilo; lx < ihi; lx++) {
+                    int i = TIX(lx, ly, lz);
+                    tile[i] = RelaxCell(x0[BIX(lx, ly, lz)], a, cRecip,
+                                        tile[i + 1], tile[i - 1], tile[i + ty], tile[i - ty], tile[i + tz], tile[i - tz]);
+                }
+                for (int lx = ilo; lx < ihi; lx++) x[BIX(lx, ly, lz)] = tile[TIX(lx, ly, lz)];
+            }
+        }
+    };
+
+    ThreadPool& pool = ThreadPool::Instance();
+    for (int t = 0; t < this->iter; t++) {
+        for (int color = 0; color < 2; color++) {
+            const std::vector<int>& blocks = colorBlocks[color];
+            pool.ParallelFor(0, static_cast<int>(blocks.size()), [&](int begin, int end) {
+                for (int n = begin; n < end; n++) relaxBlock(links[blocks[n]]);
+            });
+        }
+        set_bounds(b, xf);
+    }
+}
+
+void SparseFluid::diffuse(int b, int x, int x0, float diff, float dt) {
+    int N = this->size;
+    float a = dt * diff * (N - 2) * (N - 2);
+    this->lin_solve(b, x, x0, a, 1 + 6 * a);
+}
+
+void SparseFluid::advect(int b, int df, int d0f, int velX, int velY, int velZ, float dt) {
+    int N = this->size;
+    float dt0 = dt * (N - 2);
+
+    ThreadPool::Instance().ParallelFor(0, static_cast<int>(links.size()), [&](int begin, int end) {
+        for (int n = begin; n < end; n++) {
+            const BlockLinks& bl = links[n];
+            float *d = grid.Data(df, bl.slot);
+            const float *u = grid.Data(velX, bl.slot);
+            const float *v = grid.Data(velY, bl.slot);
+            const float *w = grid.Data(velZ, bl.slot);
+
+            int ilo = std::max(1, bl.x0) - bl.x0, ihi = std::min(N - 1, bl.x0 + sparseBlockDim) - bl.x0;
+            int jlo = std::max(1, bl.y0) - bl.y0, jhi = std::min(N - 1, bl.y0 + sparseBlockDim) - bl.y0;
+            int klo = std::max(1, bl.z0) - bl.z0, khi = std::min(N - 1, bl.z0 + sparseBlockDim) - bl.z0;
+
+            for (int lz = klo; lz < khi; lz++) {
+                for (int ly = jlo; ly < jhi; ly++) {
+                    for (int lx = ilo; lx < ihi; lx++) {
+                        int i = BIX(lx, ly, lz);
+                        float x = ClampBacktrace(float(bl.x0 + lx) - dt0 * u[i], N);
+                        float y = ClampBacktrace(float(bl.y0 + ly) - dt0 * v[i], N);
+                        float z = ClampBacktrace(float(bl.z0 + lz) - dt0 * w[i], N);
+                        d[i] = sample(d0f, x, y, z);
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    set_bounds(b, df);
+}
+
+void SparseFluid::project(int velX, int velY, int velZ, int p, int div) {
+    divergence(velX, velY, velZ, p, div);
+
+    set_bounds(0, div);
+    set_bounds(0, p);
+    lin_solve(0, p, div, 1, 6);
+
+    subtract_gradient(velX, velY, velZ, p);
+}
+
+void SparseFluid::divergence(int velX, int velY, int velZ, int p, int div) {
+    int N = this->size;
+    const int ty = sparseTileDim, tz = sparseTileDim * sparseTileDim;
+
+    ThreadPool::Instance().ParallelFor(0, static_cast<int>(links.size()), [&](int begin, int end) {
+        float tu[sparseTileCells], tv[sparseTileCells], tw[sparseTileCells];
+
+        for (int n = begin; n < end; n++) {
+            const BlockLinks& bl = links[n];
+            float *dv = grid.Data(div, bl.slot);
+            float *pr = grid.Data(p, bl.slot);
+            gatherTile(velX, bl, tu);
+            gatherTile(velY, bl, tv);
+            gatherTile(velZ, bl, tw);
+
+            int ilo = std::max(1, bl.x0) - bl.x0, ihi = std::min(N - 1, bl.x0 + sparseBlockDim) - bl.x0;
+            int jlo = std::max(1, bl.y0) - bl.y0, jhi = std::min(N - 1, bl.y0 + sparseBlockDim) - bl.y0;
+            int klo = std::max(1, bl.z0) - bl.z0, khi = std::min(N - 1, bl.z0 + sparseBlockDim) - bl.z0;
+
+            for (int lz = klo; lz < khi; lz++) {
+                for (int ly = jlo; ly < jhi; ly++) {
+                    for (int lx = ilo; lx < ihi; lx++) {
+                        int t = TIX(lx, ly, lz), i = BIX(lx, ly, lz);
+                        dv[i] = DivergenceCell(tu[t + 1], tu[t - 1], tv[t + ty], tv[t - ty], tw[t + tz], tw[t - tz], N);
+                        pr[i] = 0;
+                    }
+                }
+            }
+        }
+    }, 1);
+}
+
+void SparseFluid::subtract_gradient(int velX, int velY, int velZ, int p) {
+    int N = this->size;
+    const int ty = sparseTileDim, tz = sparseTileDim * sparseTileDim;
+
+    ThreadPool::Instance().ParallelFor(0, static_cast<int>(links.size()), [&](int begin, int end) {
+        float tp[sparseTileCells];
+
+        for (int n = begin; n < end; n++) {
+            const BlockLinks& bl = links[n];
+            float *u = grid.Data(velX, bl.slot);
+            float *v = grid.Data(velY, bl.slot);
+            float *w = grid.Data(velZ, bl.slot);
+            gatherTile(p, bl, tp);
+
+            int ilo = std::max(1, bl.x0) - bl.x0, ihi = std::min(N - 1, bl.x0 + sparseBlockDim) - bl.x0;
+            int jlo = std::max(1, bl.y0) - bl.y0, jhi = std::min(N - 1, bl.y0 + sparseBlockDim) - bl.y0;
+            int klo = std::max(1, bl.z0) - bl.z0, khi = std::min(N - 1, bl.z0 + sparseBlockDim) - bl.z0;
+
+            for (int lz = klo; lz < khi; lz++) {
+                for (int ly = jlo; ly < jhi; ly++) {
+                    for (int lx = ilo; lx < ihi; lx++) {
+                        int t = TIX(lx, ly, lz), i = BIX(lx, ly, lz);
+                        u[i] -= GradientCell(tp[t + 1], tp[t - 1], N);
+                        v[i] -= GradientCell(tp[t + ty], tp[t - ty], N);
+                        w[i] -= GradientCell(tp[t + tz], tp[t - tz], N);
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    set_bounds(1, velX);
+    set_bounds(2, velY);
+    set_bounds(3, velZ);
+}
+
+// Ten sam krok co Fluid::FluidStep, poprzedzony odświeżeniem listy aktywnych bloków
+void SparseFluid::FluidStep() {
+    if (!fixedBlocks) refreshBlocks();
+
+    this->diffuse(1, sfVx0, sfVx, this->visc, this->dt);
+    this->diffuse(2, sfVy0, sfVy, this->visc, this->dt);
+    this->diffuse(3, sfVz0, sfVz, this->visc, this->dt);
+
+    this->project(sfVx0, sfVy0, sfVz0, sfVx, sfVy);
+
+    this->advect(1, sfVx, sfVx0, sfVx0, sfVy0, sfVz0, this->dt);
+    this->advect(2, sfVy, sfVy0, sfVx0, sfVy0, sfVz0, this->dt);
+    this->advect(3, sfVz, sfVz0, sfVx0, sfVy0, sfVz0, this->dt);
+
+    this->project(sfVx, sfVy, sfVz, sfVx0, sfVy0);
+
+    this->diffuse(0, sfS, sfDensity, this->diff, this->dt);
+    this->advect(0, sfDensity, sfS, sfVx, sfVy, sfVz, this->dt);
+}
+
+// Zanikanie barwnika -- tylko w aktywnych blokach, poza nimi gęstość i tak jest zerowa
+void SparseFluid::fadeDensity(float amount) {
+    float keep = 1.0f - amount;
+    for (int id : grid.Blocks()) {
+        float *d = grid.Data(sfDensity, grid.Slot(id));
+        for (int i = 0; i < sparseBlockCells; i++) d[i] *= keep;
+    }
+}
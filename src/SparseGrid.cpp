@@ -0,0 +1,103 @@
+#include "SparseGrid.h"
+
+#include <algorithm>
+
+SparseGrid::SparseGrid() {
+    mRes = 0;
+    mBlocksPerAxis = 0;
+    mChannels = 0;
+    mSlotCount = 0;
+}
+
+void SparseGrid::Create(int res, int channels) {
+    mRes = res;
+    mBlocksPerAxis = (res + sparseBlockMask) >> sparseBlockBits;
+    mChannels = channels;
+
+    mTable.assign(size_t(mBlocksPerAxis) * mBlocksPerAxis * mBlocksPerAxis, -1);
+    mData.assign(channels, std::vector<float>());
+
+    mFreeSlots.clear();
+    mBlocks.clear();
+    mSlotCount = 0;
+}
+
+int SparseGrid::Activate(int id) {
+    if (mTable[id] >= 0) return mTable[id];
+
+    int slot;
+    if (!mFreeSlots.empty()) {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        for (int c = 0; c < mChannels; c++) std::fill_n(Data(c, slot), sparseBlockCells, 0.0f);
+    }
+    else {
+        // Pula rośnie o jeden slot (vector sam rośnie geometrycznie)
+        slot = mSlotCount++;
+        for (int c = 0; c < mChannels; c++) mData[c].resize(size_t(mSlotCount) * sparseBlockCells, 0.0f);
+    }
+
+    mTable[id] = slot;
+    mBlocks.push_back(id);
+    return slot;
+}
+
+void SparseGrid::Retain(const std::vector<int>& ids) {
+    // Bloki spoza nowej listy wracają do puli
+    for (int id : mBlocks) {
+        if (!std::binary_search(ids.begin(), ids.end(), id)) {
+            mFreeSlots.push_back(mTable[id]);
+            mTable[id] = -1;
+        }
+    }
+
+    mBlocks.clear();
+    for (int id : ids) {
+        if (mTable[id] >= 0) mBlocks.push_back(id);
+        else Activate(id);
+    }
+
+    // Wolnych slotów więcej niż zajętych -- pula zmniejsza się do bieżącej objętości
+    if (mFreeSlots.size() > mBlocks.size() && mSlotCount > sparseMinSlots) compact();
+}
+
+void SparseGrid::compact() {
+    int live = static_cast<int>(mBlocks.size());
+
+    // Dziury poniżej 'live' wypełniają bloki ze slotów >= live
+    std::vector<int> holes;
+    for (int slot : mFreeSlots)
+        if (slot < live) holes.push_back(slot);
+
+    size_t next = 0;
+    for (int id : mBlocks) {
+        int slot = mTable[id];
+        if (slot < live) continue;
+
+        int hole = holes[next++];
+        for (int c = 0; c < mChannels; c++) std::copy_n(Data(c, slot), sparseBlockCells, Data(c, hole));
+        mTable[id] = hole;
+    }
+
+    mSlotCount = live;
+    mFreeSlots.clear();
+    for (std::vector<float>& data : mData) {
+        data.resize(size_t(live) * sparseBlockCells);
+        data.shrink_to_fit();
+    }
+}
+
+float SparseGrid::Get(int channel, int x, int y, int z) const {
+    if (x < 0 || y < 0 || z < 0 || x >= mRes || y >= mRes || z >= mRes) return 0.0f;
+
+    int slot = SlotAt(x, y, z);
+    if (slot < 0) return 0.0f;
+
+    return Data(channel, slot)[BIX(x & sparseBlockMask, y & sparseBlockMask, z & sparseBlockMask)];
+}
+
+size_t SparseGrid::Bytes() const {
+    size_t bytes = mTable.size() * sizeof(int32_t);
+    for (const std::vector<float>& data : mData) bytes += data.capacity() * sizeof(float);
+    return bytes;
+}
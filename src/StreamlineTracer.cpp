@@ -0,0 +1,244 @@
+#include "StreamlineTracer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Prędkość poniżej tej wartości kończy linię (punkt stagnacji)
+static const float minSpeed = 1e-6f;
+
+StreamlineTracer::StreamlineTracer() {
+    mRes = 0;
+    mMaxPoints = 0;
+    mCellSize = 1.0f;
+    mOrigin = glm::vec3(0.0f);
+    mPointCount = 0;
+
+    mVAO = 0;
+    mVBO = 0;
+}
+
+StreamlineTracer::~StreamlineTracer() {
+    Destroy();
+}
+
+bool StreamlineTracer::Create(int N, int seedCount, int maxPoints, float cellSize, const glm::vec3& origin) {
+    Destroy();
+
+    mRes = N;
+    mMaxPoints = std::max(maxPoints, 2);
+    mCellSize = cellSize;
+    mOrigin = origin;
+
+    // Liczba ziaren zaokrąglona w górę do pełnych paczek
+    int count = (seedCount + tracerLanes - 1) / tracerLanes * tracerLanes;
+    mSeedX.assign(count, 0.0f);
+    mSeedY.assign(count, 0.0f);
+    mSeedZ.assign(count, 0.0f);
+
+    mPoints.assign(size_t(count) * mMaxPoints * 3, 0.0f);
+    mFirsts.resize(count);
+    mCounts.assign(count, 0);
+    for (int i = 0; i < count; i++) mFirsts[i] = i * mMaxPoints;
+    mPointCount = 0;
+
+    glGenVertexArrays(1, &mVAO);
+    glGenBuffers(1, &mVBO);
+    if (!mVAO || !mVBO) return false;
+
+    glBindVertexArray(mVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    glBufferData(GL_ARRAY_BUFFER, mPoints.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    return true;
+}
+
+void StreamlineTracer::Destroy() {
+    if (mVAO) glDeleteVertexArrays(1, &mVAO);
+    if (mVBO) glDeleteBuffers(1, &mVBO);
+    mVAO = 0;
+    mVBO = 0;
+
+    mSeedX.clear();
+    mSeedY.clear();
+    mSeedZ.clear();
+    mPoints.clear();
+    mFirsts.clear();
+    mCounts.clear();
+    mPointCount = 0;
+    mRes = 0;
+}
+
+void StreamlineTracer::SeedBox(const glm::vec3& lo, const glm::vec3& hi, unsigned rngSeed) {
+    std::mt19937 rng(rngSeed);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+    for (size_t i = 0; i < mSeedX.size(); i++) {
+        mSeedX[i] = lo.x + (hi.x - lo.x) * u(rng);
+        mSeedY[i] = lo.y + (hi.y - lo.y) * u(rng);
+        mSeedZ[i] = lo.z + (hi.z - lo.z) * u(rng);
+    }
+}
+
+// Interpolacja trójliniowa trzech składowych naraz (wspólne indeksy i wagi) dla paczki punktów
+// Pozycje są przycinane do siatki, więc martwe pasy można liczyć bez rozgałęzień
+static inline void sampleLanes(const float* vx, const float* vy, const float* vz, int N,
+                               const float* px, const float* py, const float* pz,
+                               float* ux, float* uy, float* uz) {
+    const float hi = float(N - 1) - 1e-3f;
+    const size_t plane = size_t(N) * N;
+
+    for (int l = 0; l < tracerLanes; l++) {
+        float x = std::min(std::max(px[l], 0.0f), hi);
+        float y = std::min(std::max(py[l], 0.0f), hi);
+        float z = std::min(std::max(pz[l], 0.0f), hi);
+
+        int i = int(x), j = int(y), k = int(z);
+        float fx = x - i, fy = y - j, fz = z - k;
+
+        size_t c = i + j * size_t(N) + k * plane;
+
+        // Cztery interpolacje wzdłuż x, dwie wzdłuż y, jedna wzdłuż z
+        auto trilinear = [&](const float* f) {
+            const float* a = f + c;
+            float x00 = a[0] + fx * (a[1] - a[0]);
+            float x10 = a[N] + fx * (a[N + 1] - a[N]);
+            float x01 = a[plane] + fx * (a[plane + 1] - a[plane]);
+            float x11 = a[plane + N] + fx * (a[plane + N + 1] - a[plane + N]);
+            float y0 = x00 + fy * (x10 - x00);
+            float y1 = x01 + fy * (x11 - x01);
+            return y0 + fz * (y1 - y0);
+        };
+
+        float sx = trilinear(vx), sy = trilinear(vy), sz = trilinear(vz);
+        ux[l] = sx;
+        uy[l] = sy;
+        uz[l] = sz;
+    }
+}
+
+// Kierunek pola (znormalizowana prędkość) -- linie prądu mają stałą długość kroku
+static inline void directionLanes(const float* vx, const float* vy, const float* vz, int N,
+                                  const float* px, const float* py, const float* pz,
+                                  float* dx, float* dy, float* dz, float* speed) {
+    sampleLanes(vx, vy, vz, N, px, py, pz, dx, dy, dz);
+
+    for (int l = 0; l < tracerLanes; l++) {
+        float s = std::sqrt(dx[l] * dx[l] + dy[l] * dy[l] + dz[l] * dz[l]);
+        float inv = s > minSpeed ? 1.0f / s : 0.0f;
+        dx[l] *= inv;
+        dy[l] *= inv;
+        dz[l] *= inv;
+        speed[l] = s;
+    }
+}
+
+void StreamlineTracer::traceBatch(int first, const float* vx, const float* vy, const float* vz, float step) {
+    const int N = mRes;
+    // Komórki brzegowe należą do set_bounds, linia kończy się przed nimi
+    const float lo = 0.5f, hi = float(N) - 1.5f;
+
+    float px[tracerLanes], py[tracerLanes], pz[tracerLanes];
+    float qx[tracerLanes], qy[tracerLanes], qz[tracerLanes];
+    float k1x[tracerLanes], k1y[tracerLanes], k1z[tracerLanes];
+    float k2x[tracerLanes], k2y[tracerLanes], k2z[tracerLanes];
+    float k3x[tracerLanes], k3y[tracerLanes], k3z[tracerLanes];
+    float k4x[tracerLanes], k4y[tracerLanes], k4z[tracerLanes];
+    float speed[tracerLanes];
+    bool alive[tracerLanes];
+
+    std::copy(&mSeedX[first], &mSeedX[first] + tracerLanes, px);
+    std::copy(&mSeedY[first], &mSeedY[first] + tracerLanes, py);
+    std::copy(&mSeedZ[first], &mSeedZ[first] + tracerLanes, pz);
+
+    for (int l = 0; l < tracerLanes; l++) {
+        alive[l] = px[l] >= lo && px[l] <= hi && py[l] >= lo && py[l] <= hi && pz[l] >= lo && pz[l] <= hi;
+        mCounts[first + l] = 0;
+    }
+
+    auto emit = [&](int l) {
+        float* out = &mPoints[(size_t(first + l) * mMaxPoints + mCounts[first + l]) * 3];
+        out[0] = mOrigin.x + px[l] * mCellSize;
+        out[1] = mOrigin.y + py[l] * mCellSize;
+        out[2] = mOrigin.z + pz[l] * mCellSize;
+        mCounts[first + l]++;
+    };
+
+    for (int l = 0; l < tracerLanes; l++)
+        if (alive[l]) emit(l);
+
+    const float h = step, h2 = 0.5f * step, h6 = step / 6.0f;
+
+    for (int n = 1; n < mMaxPoints; n++) {
+        bool any = false;
+        for (int l = 0; l < tracerLanes; l++) any |= alive[l];
+        if (!any) break;
+
+        directionLanes(vx, vy, vz, N, px, py, pz, k1x, k1y, k1z, speed);
+        for (int l = 0; l < tracerLanes; l++) {
+            alive[l] = alive[l] && speed[l] > minSpeed;
+            qx[l] = px[l] + h2 * k1x[l];
+            qy[l] = py[l] + h2 * k1y[l];
+            qz[l] = pz[l] + h2 * k1z[l];
+        }
+
+        directionLanes(vx, vy, vz, N, qx, qy, qz, k2x, k2y, k2z, speed);
+        for (int l = 0; l < tracerLanes; l++) {
+            qx[l] = px[l] + h2 * k2x[l];
+            qy[l] = py[l] + h2 * k2y[l];
+            qz[l] = pz[l] + h2 * k2z[l];
+        }
+
+        directionLanes(vx, vy, vz, N, qx, qy, qz, k3x, k3y, k3z, speed);
+        for (int l = 0; l < tracerLanes; l++) {
+            qx[l] = px[l] + h * k3x[l];
+            qy[l] = py[l] + h * k3y[l];
+            qz[l] = pz[l] + h * k3z[l];
+        }
+
+        directionLanes(vx, vy, vz, N, qx, qy, qz, k4x, k4y, k4z, speed);
+        for (int l = 0; l < tracerLanes; l++) {
+            px[l] += h6 * (k1x[l] + 2.0f * k2x[l] + 2.0f * k3x[l] + k4x[l]);
+            py[l] += h6 * (k1y[l] + 2.0f * k2y[l] + 2.0f * k3y[l] + k4y[l]);
+            pz[l] += h6 * (k1z[l] + 2.0f * k2z[l] + 2.0f * k3z[l] + k4z[l]);
+        }
+
+        for (int l = 0; l < tracerLanes; l++) {
+            if (!alive[l]) continue;
+            alive[l] = px[l] >= lo && px[l] <= hi && py[l] >= lo && py[l] <= hi && pz[l] >= lo && pz[l] <= hi;
+            if (alive[l]) emit(l);
+        }
+    }
+}
+
+void StreamlineTracer::Trace(const float* vx, const float* vy, const float* vz, float step) {
+    if (mSeedX.empty()) return;
+
+    const int batches = static_cast<int>(mSeedX.size()) / tracerLanes;
+
+    ThreadPool::Instance().ParallelFor(0, batches, [&](int begin, int end) {
+        for (int b = begin; b < end; b++)
+            traceBatch(b * tracerLanes, vx, vy, vz, step);
+    });
+
+    mPointCount = 0;
+    for (GLsizei count : mCounts) mPointCount += count;
+
+    // Linie mają stałe miejsca w buforze, wysyłany jest cały bufor
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    glBufferData(GL_ARRAY_BUFFER, mPoints.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, mPoints.size() * sizeof(float), mPoints.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamlineTracer::Draw() const {
+    if (mPointCount == 0) return;
+
+    glBindVertexArray(mVAO);
+    glMultiDrawArrays(GL_LINE_STRIP, mFirsts.data(), mCounts.data(), static_cast<GLsizei>(mCounts.size()));
+    glBindVertexArray(0);
+}
@@ -0,0 +1,100 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// Zagnieżdżone ParallelFor (z wnętrza zadania) wykonują się szeregowo
+static thread_local bool insidePool = false;
+
+ThreadPool::ThreadPool() {
+    mBody = nullptr;
+    mEnd = 0;
+    mGrain = 1;
+    mNext = 0;
+    mActive = 0;
+    mGeneration = 0;
+    mStop = false;
+
+    // Jeden rdzeń zostaje dla wątku głównego (renderowanie)
+    unsigned hw = std::thread::hardware_concurrency();
+    int workers = hw > 1 ? static_cast<int>(hw) - 1 : 0;
+
+    for (int i = 0; i < workers; i++)
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+
+    for (auto& worker : mWorkers) worker.join();
+}
+
+int ThreadPool::ThreadCount() const {
+    return static_cast<int>(mWorkers.size()) + 1;
+}
+
+void ThreadPool::runChunks() {
+    insidePool = true;
+
+    int i;
+    while ((i = mNext.fetch_add(mGrain)) < mEnd)
+        (*mBody)(i, std::min(i + mGrain, mEnd));
+
+    insidePool = false;
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&] { return mStop || mGeneration != seen; });
+            if (mStop) return;
+            seen = mGeneration;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mActive == 0) mDone.notify_one();
+    }
+}
+
+void ThreadPool::ParallelFor(int begin, int end, const std::function<void(int, int)>& body, int grain) {
+    if (begin >= end) return;
+
+    if (grain <= 0)
+        grain = std::max(1, (end - begin) / (4 * ThreadCount()));
+
+    // Brak workerów, wywołanie zagnieżdżone albo pula zajęta przez inny wątek -- szeregowo
+    if (mWorkers.empty() || insidePool || end - begin <= grain || !mSubmit.try_lock()) {
+        for (int i = begin; i < end; i += grain)
+            body(i, std::min(i + grain, end));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBody = &body;
+        mEnd = end;
+        mGrain = grain;
+        mNext = begin;
+        mActive = static_cast<int>(mWorkers.size());
+        mGeneration++;
+    }
+    mWake.notify_all();
+
+    runChunks();
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [&] { return mActive == 0; });
+        mBody = nullptr;
+    }
+
+    mSubmit.unlock();
+}
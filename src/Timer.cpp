@@ -1,27 +1,91 @@
 #include "Timer.h"
 
+#include <cmath>
+#include <iomanip>
+
+TimingStats::TimingStats() {
+    std::fill(mSamples, mSamples + timingWindow, 0);
+    std::fill(mHistogram, mHistogram + timingBuckets, 0);
+    mNext = 0;
+    mCount = 0;
+}
+
+void TimingStats::Record(uint64_t ns) {
+    // Przedział histogramu: liczba bitów czasu w mikrosekundach
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+    while (us && bucket < timingBuckets - 1) {
+        us >>= 1;
+        bucket++;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSamples[mNext] = ns;
+    mNext = (mNext + 1) % timingWindow;
+    mCount++;
+    mHistogram[bucket]++;
+}
+
+TimingSummary TimingStats::Summary() const {
+    uint64_t samples[timingWindow];
+    int n;
+    TimingSummary summary = {};
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        summary.count = mCount;
+        n = static_cast<int>(std::min<uint64_t>(mCount, timingWindow));
+        std::copy(mSamples, mSamples + n, samples);
+    }
+    if (n == 0) return summary;
+
+    std::sort(samples, samples + n);
+
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += double(samples[i]);
+
+    // Percentyl metodą najbliższej rangi
+    auto percentile = [&](double p) {
+        int rank = static_cast<int>(std::ceil(p * n)) - 1;
+        return samples[std::min(std::max(rank, 0), n - 1)] * 1e-6;
+    };
+
+    summary.mean = sum / n * 1e-6;
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.max = samples[n - 1] * 1e-6;
+    return summary;
+}
+
+void TimingStats::Histogram(uint64_t out[timingBuckets]) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::copy(mHistogram, mHistogram + timingBuckets, out);
+}
+
 Timer::Timer() {
     // Resetuje licznik czasu przy tworzeniu obiektu
     Reset();      
 
+    mDeltaTime = 0.0f;
+
     // Domyślna skala czasu = 1 (normalna prędkość)
     mTimeScale = 1.0f; 
+
+    AddSection("frame");
 }
 
 Timer::~Timer() {
     std::cout << "Timer -- Destroyed" << std::endl;
 }
 
-// Resetuje timer – zeruje czas rozpoczęcia, upłynięte milisekundy i deltaTime
+// Resetuje timer – zeruje czas rozpoczęcia i upłynięte nanosekundy
+// deltaTime zostaje do końca klatki (Reset wołany jest zaraz po Update na początku klatki)
 void Timer::Reset() {
-    // Pobiera aktualny czas w milisekundach od startu SDL
-    mStartTicks = SDL_GetTicks(); 
+    // Pobiera aktualny czas w nanosekundach od startu SDL
+    mStartTicks = SDL_GetTicksNS(); 
 
     // Zeruje upłynięty czas
     mElapsedTicks = 0;   
-
-    // Zeruje deltaTime         
-    mDeltaTime = 0.0f;            
 }
 
 // Ustawia skalę czasu (np. spowolnienie lub przyspieszenie)
@@ -39,15 +103,74 @@ double Timer::TimeScale() {
     return mTimeScale;
 }
 
-// Aktualizuje timer – oblicza deltaTime
+// Aktualizuje timer – oblicza deltaTime i zapisuje czas klatki w statystykach
 void Timer::Update() {
-    // Oblicza ile milisekund upłynęło od ostatniego resetu
-    mElapsedTicks = SDL_GetTicks() - mStartTicks;
+    // Oblicza ile nanosekund upłynęło od ostatniego resetu
+    mElapsedTicks = SDL_GetTicksNS() - mStartTicks;
 
-    // Konwertuje milisekundy na sekundy
-    mDeltaTime = mElapsedTicks * 0.001f;
+    // Konwertuje nanosekundy na sekundy
+    mDeltaTime = mElapsedTicks * 1e-9;
+
+    Record(frameSection, mElapsedTicks);
 
     // Można zastosować skalę czasu, np. mDeltaTime *= mTimeScale;
 }
 
+Uint64 Timer::Now() const {
+    return SDL_GetTicksNS();
+}
+
+// Sekcje rejestrowane są przy starcie (przed uruchomieniem wątków, które do nich zapisują)
+int Timer::AddSection(const std::string& name) {
+    mSectionNames.push_back(name);
+    mSections.emplace_back(new TimingStats());
+    return static_cast<int>(mSections.size()) - 1;
+}
+
+void Timer::Record(int section, Uint64 ns) {
+    mSections[section]->Record(ns);
+}
+
+TimingSummary Timer::Summary(int section) const {
+    return mSections[section]->Summary();
+}
+
+void Timer::Report(std::ostream& out) const {
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+
+    out << "Czasy [ms] (ostatnie " << timingWindow << " próbek):\n";
+    out << std::left << std::setw(16) << "sekcja" << std::right
+        << std::setw(10) << "liczba" << std::setw(10) << "średnia" << std::setw(10) << "p50"
+        << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << '\n';
+
+    for (size_t i = 0; i < mSections.size(); i++) {
+        TimingSummary s = mSections[i]->Summary();
+        if (s.count == 0) continue;
+
+        out << std::left << std::setw(16) << mSectionNames[i] << std::right
+            << std::setw(10) << s.count << std::setw(10) << s.mean << std::setw(10) << s.p50
+            << std::setw(10) << s.p95 << std::setw(10) << s.p99 << std::setw(10) << s.max << '\n';
+    }
 
+    // Histogramy od startu: tylko niepuste przedziały
+    out << "Histogramy (od startu):\n";
+    for (size_t i = 0; i < mSections.size(); i++) {
+        uint64_t histogram[timingBuckets];
+        mSections[i]->Histogram(histogram);
+
+        bool any = false;
+        for (int b = 0; b < timingBuckets; b++) {
+            if (!histogram[b]) continue;
+            if (!any) out << "  " << mSectionNames[i] << ":";
+            any = true;
+
+            uint64_t hi = uint64_t(1) << b;
+            out << " <" << hi << "us:" << histogram[b];
+        }
+        if (any) out << '\n';
+    }
+
+    out.flags(flags);
+    out << std::flush;
+}
@@ -0,0 +1,154 @@
+#include "VelocityGlyphs.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+VelocityGlyphs::VelocityGlyphs() {
+    mRes = 0;
+    mStride = 1;
+    mPerAxis = 0;
+
+    mVAO = 0;
+    mArrowVBO = 0;
+    mInstanceVBO = 0;
+    mArrowVertices = 0;
+
+    mMaxMagnitude = 0.0f;
+}
+
+VelocityGlyphs::~VelocityGlyphs() {
+    Destroy();
+}
+
+bool VelocityGlyphs::Create(int N, int stride, float cellSize, const glm::vec3& origin) {
+    Destroy();
+
+    mRes = N;
+    mStride = std::max(stride, 1);
+    mPerAxis = N / mStride;
+
+    // Strzałki w środkach bloków stride^3, pozycje są stałe
+    const size_t count = size_t(mPerAxis) * mPerAxis * mPerAxis;
+    mInstances.assign(count, GlyphInstance{ {0, 0, 0}, {1, 0, 0}, 0 });
+    mPlaneMax.assign(mPerAxis, 0.0f);
+    mMaxMagnitude = 0.0f;
+
+    for (int k = 0; k < mPerAxis; k++)
+        for (int j = 0; j < mPerAxis; j++)
+            for (int i = 0; i < mPerAxis; i++) {
+                GlyphInstance& g = mInstances[i + mPerAxis * (j + size_t(mPerAxis) * k)];
+                glm::vec3 p = origin + glm::vec3(i, j, k) * float(mStride) * cellSize + float(mStride / 2) * cellSize;
+                g.position[0] = p.x;
+                g.position[1] = p.y;
+                g.position[2] = p.z;
+            }
+
+    // Strzałka o długości 1 wzdłuż +X: trzon i dwa ramiona grotu
+    const GLfloat arrow[] = {
+        0.0f,  0.0f,   0.0f,    1.0f, 0.0f, 0.0f,
+        1.0f,  0.0f,   0.0f,    0.7f, 0.15f, 0.0f,
+        1.0f,  0.0f,   0.0f,    0.7f, -0.15f, 0.0f
+    };
+    mArrowVertices = 6;
+
+    glGenVertexArrays(1, &mVAO);
+    glGenBuffers(1, &mArrowVBO);
+    glGenBuffers(1, &mInstanceVBO);
+    if (!mVAO || !mArrowVBO || !mInstanceVBO) return false;
+
+    glBindVertexArray(mVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mArrowVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(arrow), arrow, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Atrybuty instancji: pozycja, kierunek, moduł
+    const GLsizei instanceStride = sizeof(GlyphInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(GlyphInstance), mInstances.data(), GL_STREAM_DRAW);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, instanceStride, (void*)offsetof(GlyphInstance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, instanceStride, (void*)offsetof(GlyphInstance, direction));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, instanceStride, (void*)offsetof(GlyphInstance, magnitude));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glBindVertexArray(0);
+
+    return true;
+}
+
+void VelocityGlyphs::Destroy() {
+    if (mVAO) glDeleteVertexArrays(1, &mVAO);
+    if (mArrowVBO) glDeleteBuffers(1, &mArrowVBO);
+    if (mInstanceVBO) glDeleteBuffers(1, &mInstanceVBO);
+    mVAO = 0;
+    mArrowVBO = 0;
+    mInstanceVBO = 0;
+
+    mInstances.clear();
+    mPlaneMax.clear();
+    mRes = 0;
+    mPerAxis = 0;
+}
+
+void VelocityGlyphs::Update(const float* vx, const float* vy, const float* vz) {
+    if (mInstances.empty()) return;
+
+    const int N = mRes;
+    const int half = mStride / 2;
+
+    // Próbkowanie równolegle po płaszczyznach z siatki strzałek
+    ThreadPool::Instance().ParallelFor(0, mPerAxis, [&](int begin, int end) {
+        for (int k = begin; k < end; k++) {
+            float planeMax = 0.0f;
+            GlyphInstance* g = &mInstances[size_t(mPerAxis) * mPerAxis * k];
+            const size_t z = size_t(k * mStride + half);
+
+            for (int j = 0; j < mPerAxis; j++) {
+                const size_t row = (j * mStride + half) * size_t(N) + z * N * N;
+
+                for (int i = 0; i < mPerAxis; i++, g++) {
+                    size_t idx = row + i * mStride + half;
+                    float x = vx[idx], y = vy[idx], w = vz[idx];
+                    float m = std::sqrt(x * x + y * y + w * w);
+
+                    // Zerowa prędkość: dowolny kierunek, strzałka i tak ma długość 0
+                    float inv = m > 0.0f ? 1.0f / m : 0.0f;
+                    g->direction[0] = m > 0.0f ? x * inv : 1.0f;
+                    g->direction[1] = y * inv;
+                    g->direction[2] = w * inv;
+                    g->magnitude = m;
+
+                    planeMax = std::max(planeMax, m);
+                }
+            }
+            mPlaneMax[k] = planeMax;
+        }
+    }, 1);
+
+    mMaxMagnitude = *std::max_element(mPlaneMax.begin(), mPlaneMax.end());
+
+    // Osierocenie starego bufora -- sterownik nie czeka na trwające rysowanie
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, mInstances.size() * sizeof(GlyphInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, mInstances.size() * sizeof(GlyphInstance), mInstances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VelocityGlyphs::Draw() const {
+    if (mInstances.empty()) return;
+
+    glBindVertexArray(mVAO);
+    glDrawArraysInstanced(GL_LINES, 0, mArrowVertices, InstanceCount());
+    glBindVertexArray(0);
+}
@@ -0,0 +1,196 @@
+#include "VolumeTexture.h"
+#include "ThreadPool.h"
+#include "HalfFloat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+VolumeTexture::VolumeTexture() {
+    mRes = 0;
+    mHalfFloat = true;
+    mInvMax = 1.0f;
+    mPlaneBytes = 0;
+
+    mTexture = 0;
+    std::fill(mPBOs, mPBOs + volumePboCount, 0);
+    std::fill(mFences, mFences + volumePboCount, nullptr);
+    mNextPBO = 0;
+}
+
+VolumeTexture::~VolumeTexture() {
+    Destroy();
+}
+
+bool VolumeTexture::Create(int N, bool halfFloat, float maxValue) {
+    Destroy();
+
+    mRes = N;
+    mHalfFloat = halfFloat;
+    mInvMax = 1.0f / maxValue;
+    mPlaneBytes = size_t(N) * N * (halfFloat ? sizeof(uint16_t) : sizeof(uint8_t));
+
+    // Zera w obu formatach kodowane są bajtami 0, więc tekstura startuje zgodna z kopią
+    mUploaded.assign(mPlaneBytes * N, 0);
+    mStaging.assign(mPlaneBytes * N, 0);
+    mChanged.assign(N, 0);
+
+    glGenTextures(1, &mTexture);
+    if (!mTexture) return false;
+
+    glBindTexture(GL_TEXTURE_3D, mTexture);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, halfFloat ? GL_R16F : GL_R8, N, N, N, 0,
+                 GL_RED, halfFloat ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE, mUploaded.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    // Każdy bufor mieści całą objętość (najgorszy przypadek: zmieniły się wszystkie płaszczyzny)
+    glGenBuffers(volumePboCount, mPBOs);
+    for (int i = 0; i < volumePboCount; i++) {
+        if (!mPBOs[i]) return false;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPBOs[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, mPlaneBytes * N, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    mNextPBO = 0;
+    return true;
+}
+
+void VolumeTexture::Destroy() {
+    for (int i = 0; i < volumePboCount; i++) {
+        if (mFences[i]) glDeleteSync(mFences[i]);
+        mFences[i] = nullptr;
+    }
+
+    if (mPBOs[0]) glDeleteBuffers(volumePboCount, mPBOs);
+    std::fill(mPBOs, mPBOs + volumePboCount, 0);
+
+    if (mTexture) glDeleteTextures(1, &mTexture);
+    mTexture = 0;
+
+    mUploaded.clear();
+    mStaging.clear();
+    mChanged.clear();
+    mRes = 0;
+}
+
+void VolumeTexture::quantizePlane(const float* src, uint8_t* dst) const {
+    const size_t count = size_t(mRes) * mRes;
+
+    if (mHalfFloat) {
+        uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+        for (size_t i = 0; i < count; i++)
+            out[i] = FloatToHalf(src[i] * mInvMax);
+    }
+    else {
+        for (size_t i = 0; i < count; i++) {
+            float v = std::min(std::max(src[i] * mInvMax, 0.0f), 1.0f);
+            dst[i] = static_cast<uint8_t>(v * 255.0f + 0.5f);
+        }
+    }
+}
+
+int VolumeTexture::Update(const float* field) {
+    if (!mTexture) return 0;
+
+    const size_t plane = size_t(mRes) * mRes;
+
+    // Kwantyzacja i porównanie z wysłaną zawartością, równolegle po płaszczyznach z
+    ThreadPool::Instance().ParallelFor(0, mRes, [&](int begin, int end) {
+        for (int z = begin; z < end; z++) {
+            uint8_t* staged = &mStaging[z * mPlaneBytes];
+            quantizePlane(field + z * plane, staged);
+            mChanged[z] = std::memcmp(staged, &mUploaded[z * mPlaneBytes], mPlaneBytes) != 0;
+        }
+    }, 1);
+
+    int changed = 0;
+    for (int z = 0; z < mRes; z++) changed += mChanged[z];
+    if (changed == 0) return 0;
+
+    // Kolejny bufor z pierścienia; jeśli GPU jeszcze z niego czyta, czekamy na jego fence.
+    // Gdy się nie doczekamy, klatka jest pomijana -- mUploaded się nie zmienia, więc te same
+    // płaszczyzny zostaną wykryte i wysłane przy następnym Update.
+    int slot = mNextPBO;
+
+    if (mFences[slot]) {
+        GLenum wait = glClientWaitSync(mFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        if (wait == GL_TIMEOUT_EXPIRED) return 0;
+
+        glDeleteSync(mFences[slot]);
+        mFences[slot] = nullptr;
+
+        if (wait == GL_WAIT_FAILED) {
+            std::cerr << "[ERROR] Oczekiwanie na bufor PBO tekstury 3D nie powiodło się." << std::endl;
+            return 0;
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPBOs[slot]);
+    uint8_t* mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, changed * mPlaneBytes,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+    if (!mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+
+    // Zmienione płaszczyzny upakowane kolejno w buforze
+    size_t offset = 0;
+    for (int z = 0; z < mRes; z++) {
+        if (!mChanged[z]) continue;
+        std::memcpy(mapped + offset, &mStaging[z * mPlaneBytes], mPlaneBytes);
+        offset += mPlaneBytes;
+    }
+
+    // GL_FALSE -- zawartość bufora została utracona w trakcie mapowania
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+
+    // Dopiero teraz dane są w drodze do tekstury; niezmienione płaszczyzny są identyczne w obu kopiach,
+    // więc zamiana wystarcza
+    mUploaded.swap(mStaging);
+    mNextPBO = (mNextPBO + 1) % volumePboCount;
+
+    // Jeden glTexSubImage3D na każdy ciągły zakres zmienionych płaszczyzn
+    glBindTexture(GL_TEXTURE_3D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    offset = 0;
+    for (int z = 0; z < mRes;) {
+        if (!mChanged[z]) { z++; continue; }
+
+        int z1 = z;
+        while (z1 < mRes && mChanged[z1]) z1++;
+
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, z, mRes, mRes, z1 - z, GL_RED,
+                        mHalfFloat ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+        offset += (z1 - z) * mPlaneBytes;
+        z = z1;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    mFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    return changed;
+}
+
+void VolumeTexture::Bind(GLenum unit) const {
+    glActiveTexture(unit);
+    glBindTexture(GL_TEXTURE_3D, mTexture);
+}
@@ -0,0 +1,229 @@
+#include "VoxelChunkMesh.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// Najmniejszy blok w buforze (2^6 = 64 wierzchołki)
+static const int minSizeClass = 6;
+
+static int sizeClassFor(GLsizei count) {
+    int sizeClass = minSizeClass;
+    while ((GLsizei(1) << sizeClass) < count) sizeClass++;
+    return sizeClass;
+}
+
+VoxelChunkMesh::VoxelChunkMesh() {
+    mRes = 0;
+    mChunksPerAxis = 0;
+    mScale = 1.0f;
+    mOffset = glm::vec3(0.0f);
+
+    mVAO = 0;
+    mVBO = 0;
+    mCapacity = 0;
+    mUsed = 0;
+
+    mAnyDirty = false;
+    mVertexCount = 0;
+}
+
+VoxelChunkMesh::~VoxelChunkMesh() {
+    Destroy();
+}
+
+bool VoxelChunkMesh::Create(int res, float scale, const glm::vec3& offset) {
+    Destroy();
+
+    mRes = res;
+    mChunksPerAxis = (res + voxelChunkSize - 1) / voxelChunkSize;
+    mScale = scale;
+    mOffset = offset;
+
+    mChunks.assign(size_t(mChunksPerAxis) * mChunksPerAxis * mChunksPerAxis, Chunk{0, 0, -1, true});
+    mFreeBlocks.assign(32, std::vector<GLint>());
+    mAnyDirty = true;
+
+    glGenVertexArrays(1, &mVAO);
+    glGenBuffers(1, &mVBO);
+    if (!mVAO || !mVBO) return false;
+
+    // Początkowa pojemność: bufor rośnie dwukrotnie, gdy zabraknie miejsca
+    mCapacity = 0;
+    mUsed = 0;
+    grow(GLsizei(1) << 16);
+
+    return true;
+}
+
+void VoxelChunkMesh::Destroy() {
+    if (mVAO) glDeleteVertexArrays(1, &mVAO);
+    if (mVBO) glDeleteBuffers(1, &mVBO);
+    mVAO = 0;
+    mVBO = 0;
+
+    mChunks.clear();
+    mFreeBlocks.clear();
+    mFirsts.clear();
+    mCounts.clear();
+    mVertexCount = 0;
+}
+
+// Powiększenie bufora z zachowaniem zawartości (kopiowanie po stronie GPU)
+void VoxelChunkMesh::grow(GLsizei minCapacity) {
+    GLsizei capacity = std::max<GLsizei>(mCapacity * 2, minCapacity);
+    const GLsizeiptr vertexBytes = 3 * sizeof(float);
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity * vertexBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    if (mUsed) {
+        glBindBuffer(GL_COPY_READ_BUFFER, mVBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, mUsed * vertexBytes);
+    }
+
+    glDeleteBuffers(1, &mVBO);
+    mVBO = buffer;
+    mCapacity = capacity;
+
+    glBindVertexArray(mVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+GLint VoxelChunkMesh::allocate(int sizeClass) {
+    std::vector<GLint>& freeList = mFreeBlocks[sizeClass];
+    if (!freeList.empty()) {
+        GLint first = freeList.back();
+        freeList.pop_back();
+        return first;
+    }
+
+    GLsizei size = GLsizei(1) << sizeClass;
+    if (mUsed + size > mCapacity) grow(mUsed + size);
+
+    GLint first = mUsed;
+    mUsed += size;
+    return first;
+}
+
+void VoxelChunkMesh::release(Chunk& chunk) {
+    if (chunk.sizeClass >= 0) mFreeBlocks[chunk.sizeClass].push_back(chunk.first);
+    chunk.sizeClass = -1;
+    chunk.count = 0;
+}
+
+void VoxelChunkMesh::MarkDirty(int x, int y, int z) {
+    // Ściany komórki (x, y, z) i jej 6 sąsiadów
+    static const int offsets[7][3] = { {0,0,0}, {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+
+    for (const auto& o : offsets) {
+        int nx = x + o[0], ny = y + o[1], nz = z + o[2];
+        if (nx < 0 || ny < 0 || nz < 0 || nx >= mRes || ny >= mRes || nz >= mRes) continue;
+
+        int cx = nx / voxelChunkSize, cy = ny / voxelChunkSize, cz = nz / voxelChunkSize;
+        mChunks[cx + size_t(cy) * mChunksPerAxis + size_t(cz) * mChunksPerAxis * mChunksPerAxis].dirty = true;
+    }
+    mAnyDirty = true;
+}
+
+void VoxelChunkMesh::MarkAllDirty() {
+    for (Chunk& chunk : mChunks) chunk.dirty = true;
+    mAnyDirty = true;
+}
+
+void VoxelChunkMesh::MarkChanged(const VoxelGrid& before, const VoxelGrid& after) {
+    if (before.Res() != mRes || after.Res() != mRes) {
+        MarkAllDirty();
+        return;
+    }
+
+    const int words = after.WordsPerRow();
+    for (int z = 0; z < mRes; z++) {
+        for (int y = 0; y < mRes; y++) {
+            const uint64_t* a = before.Row(y, z);
+            const uint64_t* b = after.Row(y, z);
+
+            for (int w = 0; w < words; w++) {
+                uint64_t changed = a[w] ^ b[w];
+                while (changed) {
+                    MarkDirty((w << 6) + __builtin_ctzll(changed), y, z);
+                    changed &= changed - 1;
+                }
+            }
+        }
+    }
+}
+
+int VoxelChunkMesh::Update(const VoxelGrid& grid) {
+    if (!mAnyDirty || grid.Res() != mRes) return 0;
+    mAnyDirty = false;
+
+    std::vector<int> dirty;
+    for (size_t c = 0; c < mChunks.size(); c++)
+        if (mChunks[c].dirty) dirty.push_back(static_cast<int>(c));
+
+    // Siatkowanie fragmentów na wątkach puli, wysyłanie na GPU tylko w wątku OpenGL
+    std::vector<std::vector<float>> meshes(dirty.size());
+
+    ThreadPool::Instance().ParallelFor(0, static_cast<int>(dirty.size()), [&](int begin, int end) {
+        for (int d = begin; d < end; d++) {
+            int c = dirty[d];
+            int cx = c % mChunksPerAxis;
+            int cy = (c / mChunksPerAxis) % mChunksPerAxis;
+            int cz = c / (mChunksPerAxis * mChunksPerAxis);
+
+            glm::ivec3 lo = glm::ivec3(cx, cy, cz) * voxelChunkSize;
+            glm::ivec3 hi = glm::min(lo + voxelChunkSize, glm::ivec3(mRes));
+            GreedyMeshRegion(grid, lo, hi, mScale, mOffset, meshes[d]);
+        }
+    }, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+
+    for (size_t d = 0; d < dirty.size(); d++) {
+        Chunk& chunk = mChunks[dirty[d]];
+        chunk.dirty = false;
+
+        GLsizei count = static_cast<GLsizei>(meshes[d].size() / 3);
+        if (count == 0) {
+            release(chunk);
+            continue;
+        }
+
+        // Nowy blok tylko, gdy wierzchołki nie mieszczą się w dotychczasowym
+        if (chunk.sizeClass < 0 || count > (GLsizei(1) << chunk.sizeClass)) {
+            release(chunk);
+            chunk.sizeClass = sizeClassFor(count);
+            chunk.first = allocate(chunk.sizeClass);
+            glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+        }
+
+        chunk.count = count;
+        glBufferSubData(GL_ARRAY_BUFFER, chunk.first * 3 * sizeof(float), meshes[d].size() * sizeof(float), meshes[d].data());
+    }
+
+    // Lista zakresów do narysowania
+    mFirsts.clear();
+    mCounts.clear();
+    mVertexCount = 0;
+    for (const Chunk& chunk : mChunks) {
+        if (!chunk.count) continue;
+        mFirsts.push_back(chunk.first);
+        mCounts.push_back(chunk.count);
+        mVertexCount += chunk.count;
+    }
+
+    return static_cast<int>(dirty.size());
+}
+
+void VoxelChunkMesh::Draw() const {
+    if (mFirsts.empty()) return;
+
+    glBindVertexArray(mVAO);
+    glMultiDrawArrays(GL_TRIANGLES, mFirsts.data(), mCounts.data(), static_cast<GLsizei>(mFirsts.size()));
+    glBindVertexArray(0);
+}
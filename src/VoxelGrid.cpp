@@ -0,0 +1,77 @@
+#include "VoxelGrid.h"
+
+#include <algorithm>
+
+VoxelGrid::VoxelGrid() {
+    mRes = 0;
+    mWords = 0;
+}
+
+VoxelGrid::VoxelGrid(int res) {
+    Resize(res);
+}
+
+void VoxelGrid::Resize(int res) {
+    mRes = res;
+    mWords = (res + 63) / 64;
+    mBits.assign(size_t(mWords) * res * res, 0);
+}
+
+void VoxelGrid::Clear() {
+    std::fill(mBits.begin(), mBits.end(), 0);
+}
+
+void VoxelGrid::Fill() {
+    // Ostatnie słowo wiersza tylko do x < res
+    const uint64_t tail = (mRes & 63) ? (uint64_t(1) << (mRes & 63)) - 1 : ~uint64_t(0);
+
+    for (size_t row = 0; row < size_t(mRes) * mRes; row++) {
+        uint64_t* words = &mBits[row * mWords];
+        std::fill(words, words + mWords, ~uint64_t(0));
+        words[mWords - 1] = tail;
+    }
+}
+
+void VoxelGrid::FaceRow(int dir, int y, int z, uint64_t* out) const {
+    const uint64_t* row = Row(y, z);
+    const int n = mWords;
+
+    switch (dir) {
+        // Sąsiad x+1: wiersz przesunięty w prawo z przeniesieniem bitu z następnego słowa
+        case 0:
+            for (int w = 0; w < n; w++) {
+                uint64_t next = (row[w] >> 1) | (w + 1 < n ? row[w + 1] << 63 : 0);
+                out[w] = row[w] & ~next;
+            }
+            break;
+
+        // Sąsiad x-1: wiersz przesunięty w lewo z przeniesieniem z poprzedniego słowa
+        case 1:
+            for (int w = 0; w < n; w++) {
+                uint64_t prev = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+                out[w] = row[w] & ~prev;
+            }
+            break;
+
+        // Sąsiedzi w osiach Y i Z to po prostu sąsiednie wiersze
+        default: {
+            int ny = y + (dir == 2) - (dir == 3);
+            int nz = z + (dir == 4) - (dir == 5);
+
+            if (ny < 0 || ny >= mRes || nz < 0 || nz >= mRes) {
+                std::copy(row, row + n, out);
+                break;
+            }
+
+            const uint64_t* neighbor = Row(ny, nz);
+            for (int w = 0; w < n; w++) out[w] = row[w] & ~neighbor[w];
+            break;
+        }
+    }
+}
+
+size_t VoxelGrid::Count() const {
+    size_t count = 0;
+    for (uint64_t word : mBits) count += __builtin_popcountll(word);
+    return count;
+}
@@ -0,0 +1,200 @@
+#include "VoxelMesh.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// Maska bitów [lo, hi) w jednym słowie, 0 <= lo < hi <= 64
+static inline uint64_t bitRange(int lo, int hi) {
+    uint64_t upper = hi >= 64 ? ~uint64_t(0) : (uint64_t(1) << hi) - 1;
+    return upper & ~((uint64_t(1) << lo) - 1);
+}
+
+// Długość ciągu ustawionych bitów zaczynającego się w bicie 'a'
+static int runLength(const uint64_t* row, int words, int a) {
+    int length = 0;
+    for (int w = a >> 6; w < words; w++) {
+        int shift = (w == (a >> 6)) ? (a & 63) : 0;
+        uint64_t zeros = ~(row[w] >> shift);
+        if (shift) zeros &= (uint64_t(1) << (64 - shift)) - 1;
+
+        if (zeros) return length + __builtin_ctzll(zeros);
+        length += 64 - shift;
+    }
+    return length;
+}
+
+// Czy wszystkie bity [a, a + w) są ustawione
+static bool rangeSet(const uint64_t* row, int a, int w) {
+    for (int i = a; i < a + w; ) {
+        int lo = i & 63;
+        int hi = std::min(64, lo + (a + w - i));
+        uint64_t mask = bitRange(lo, hi);
+        if ((row[i >> 6] & mask) != mask) return false;
+        i += hi - lo;
+    }
+    return true;
+}
+
+static void clearRange(uint64_t* row, int a, int w) {
+    for (int i = a; i < a + w; ) {
+        int lo = i & 63;
+        int hi = std::min(64, lo + (a + w - i));
+        row[i >> 6] &= ~bitRange(lo, hi);
+        i += hi - lo;
+    }
+}
+
+// Kopiuje bity [start, start + count) wiersza src na początek dst (words słów)
+static void extractBits(const uint64_t* src, int start, int count, uint64_t* dst, int words) {
+    const int shift = start & 63;
+    const int base = start >> 6;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t lo = src[base + w] >> shift;
+        uint64_t hi = (shift && (base + w + 1) * 64 < start + count) ? src[base + w + 1] << (64 - shift) : 0;
+        dst[w] = lo | hi;
+    }
+
+    if (count & 63) dst[words - 1] &= (uint64_t(1) << (count & 63)) - 1;
+}
+
+// Jeden przekrój prostopadły do osi 'axis' z widocznymi ścianami w kierunku 'dir',
+// ograniczony do prostopadłościanu [lo, hi) -- ściany łączone są tylko wewnątrz niego.
+// Maska przekroju: wiersze bitowe wzdłuż osi R, kolejne wiersze wzdłuż osi C
+static void meshSlice(const VoxelGrid& grid, int dir, int slice, const glm::ivec3& lo, const glm::ivec3& hi,
+                      float scale, const glm::vec3& offset,
+                      std::vector<uint64_t>& mask, std::vector<uint64_t>& rowBuffer, std::vector<float>& out) {
+    const int res = grid.Res();
+    const int axis = dir / 2;
+    const int sign = (dir % 2) ? -1 : 1;
+
+    // Osie X: (R, C) = (Y, Z), Y: (X, Z), Z: (X, Y) -- bity siatki biegną wzdłuż X
+    const int axisR = axis == 0 ? 1 : 0;
+    const int axisC = axis == 2 ? 1 : 2;
+
+    const int extentR = hi[axisR] - lo[axisR];
+    const int extentC = hi[axisC] - lo[axisC];
+    const int words = (extentR + 63) / 64;
+
+    std::fill(mask.begin(), mask.begin() + size_t(extentC) * words, 0);
+    bool any = false;
+
+    if (axis == 0) {
+        // Ściany X: bit 'slice' z każdego wiersza (y, z), sąsiad to bit slice +- 1
+        const int neighbor = slice + sign;
+        const bool neighborInside = neighbor >= 0 && neighbor < res;
+
+        for (int c = 0; c < extentC; c++) {
+            uint64_t* dst = &mask[size_t(c) * words];
+            for (int r = 0; r < extentR; r++) {
+                const uint64_t* row = grid.Row(lo.y + r, lo.z + c);
+                bool solid = (row[slice >> 6] >> (slice & 63)) & 1;
+                bool covered = neighborInside && ((row[neighbor >> 6] >> (neighbor & 63)) & 1);
+                if (solid && !covered) {
+                    dst[r >> 6] |= uint64_t(1) << (r & 63);
+                    any = true;
+                }
+            }
+        }
+    }
+    else {
+        // Ściany Y i Z: całe wiersze wzdłuż X naraz
+        const bool fullRow = lo.x == 0 && hi.x == res;
+
+        for (int c = 0; c < extentC; c++) {
+            uint64_t* dst = &mask[size_t(c) * words];
+            uint64_t* faces = fullRow ? dst : rowBuffer.data();
+
+            if (axis == 1) grid.FaceRow(dir, slice, lo.z + c, faces);
+            else           grid.FaceRow(dir, lo.y + c, slice, faces);
+
+            if (!fullRow) extractBits(faces, lo.x, extentR, dst, words);
+
+            for (int w = 0; w < words && !any; w++) any = dst[w] != 0;
+        }
+    }
+    if (!any) return;
+
+    const float plane = static_cast<float>(slice + (sign > 0 ? 1 : 0));
+
+    // (R, C, axis) w prawoskrętnej kolejności zachowuje orientację ścian
+    const bool cyclic = axisR == (axis + 1) % 3;
+    static const int orderCCW[6] = { 0, 1, 2, 2, 3, 0 };
+    static const int orderCW[6]  = { 0, 3, 2, 2, 1, 0 };
+    const int* order = ((sign > 0) == cyclic) ? orderCCW : orderCW;
+
+    for (int b = 0; b < extentC; b++) {
+        uint64_t* row = &mask[size_t(b) * words];
+
+        for (int w0 = 0; w0 < words; ) {
+            if (!row[w0]) { w0++; continue; }
+
+            // Początek i szerokość prostokąta wzdłuż R
+            int a = (w0 << 6) + __builtin_ctzll(row[w0]);
+            int w = runLength(row, words, a);
+
+            // Wysokość wzdłuż C, dopóki kolejne wiersze zawierają cały odcinek
+            int h = 1;
+            while (b + h < extentC && rangeSet(&mask[size_t(b + h) * words], a, w)) h++;
+
+            for (int k = 0; k < h; k++) clearRange(&mask[size_t(b + k) * words], a, w);
+
+            glm::vec3 p[4];
+            const float cr[4] = { float(a), float(a + w), float(a + w), float(a) };
+            const float cc[4] = { float(b), float(b), float(b + h), float(b + h) };
+            for (int i = 0; i < 4; i++) {
+                p[i][axis] = plane;
+                p[i][axisR] = cr[i] + lo[axisR];
+                p[i][axisC] = cc[i] + lo[axisC];
+                p[i] = p[i] * scale - offset;
+            }
+
+            for (int i = 0; i < 6; i++) {
+                out.push_back(p[order[i]].x);
+                out.push_back(p[order[i]].y);
+                out.push_back(p[order[i]].z);
+            }
+        }
+    }
+}
+
+void GreedyMeshRegion(const VoxelGrid& grid, const glm::ivec3& lo, const glm::ivec3& hi,
+                      float scale, const glm::vec3& offset, std::vector<float>& out) {
+    out.clear();
+
+    const glm::ivec3 extent = hi - lo;
+    const int maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+
+    std::vector<uint64_t> mask(size_t(maxExtent) * ((maxExtent + 63) / 64));
+    std::vector<uint64_t> rowBuffer(grid.WordsPerRow());
+
+    for (int dir = 0; dir < voxelFaceDirs; dir++) {
+        const int axis = dir / 2;
+        for (int slice = lo[axis]; slice < hi[axis]; slice++)
+            meshSlice(grid, dir, slice, lo, hi, scale, offset, mask, rowBuffer, out);
+    }
+}
+
+void GreedyMeshVoxels(const VoxelGrid& grid, float scale, const glm::vec3& offset, std::vector<float>& out) {
+    const int res = grid.Res();
+    const int tasks = voxelFaceDirs * res;
+    std::vector<std::vector<float>> parts(tasks);
+
+    const glm::ivec3 lo(0), hi(res);
+
+    ThreadPool::Instance().ParallelFor(0, tasks, [&](int begin, int end) {
+        std::vector<uint64_t> mask(size_t(res) * grid.WordsPerRow());
+        std::vector<uint64_t> rowBuffer(grid.WordsPerRow());
+
+        for (int t = begin; t < end; t++)
+            meshSlice(grid, t / res, t % res, lo, hi, scale, offset, mask, rowBuffer, parts[t]);
+    });
+
+    // Złączenie wyników przekrojów w ustalonej kolejności
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+
+    out.clear();
+    out.reserve(total);
+    for (const auto& part : parts) out.insert(out.end(), part.begin(), part.end());
+}
@@ -5,18 +5,31 @@
 //            turbine.exe
 //-------------------------------------------------------
 // Kompilacja LINUX: 
-//            g++ src/*.cpp src/*.c -Iinclude -L/usr/local/lib -o turbine -lSDL3 -lGL 
+//            g++ src/*.cpp src/*.c -Iinclude -L/usr/local/lib -o turbine -lSDL3 -lGL -pthread 
 //            ./turbine
 //-------------------------------------------------------
 // Jeśli będą problemy z pamięcią: 
-//            g++ -g -O1 -fsanitize=address,undefined -fno-omit-frame-pointer src/*.cpp src/*.c -Iinclude -L/usr/local/lib -o turbine -lSDL3 -lGL  
+//            g++ -g -O1 -fsanitize=address,undefined -fno-omit-frame-pointer src/*.cpp src/*.c -Iinclude -L/usr/local/lib -o turbine -lSDL3 -lGL -pthread  
 //            ./turbine                   
 //-------------------------------------------------------
+// Pomiary solvera bez okna (pola 16-bitowe szybciej z -mf16c / -march=native):
+//            ./turbine --bench-precision [rozmiar] [kroki]
+//            ./turbine --bench-divergence [rozmiar] [kroki] [float|half|bfloat16]
+//            ./turbine --bench-layout [rozmiar] [kroki]
+//            ./turbine --bench-advection [rozmiar] [kroki na obrót]
+//            ./turbine --bench-ensemble [rozmiar] [członków] [kroki]
+//            ./turbine --bench-sparse [rozmiar] [kroki] [rozmiar porównania z Fluid]
+//            ./turbine --bench-nested [rozmiar] [kroki]
+//-------------------------------------------------------
 
+#include "FluidBench.h"
 #include "Simulation.h"
 
 int main(int argc, char** argv) {
-    std::cout << "Symulacja rozpoczęta...\n\nNaciśnij: \n1 - Renderowanie osi XYZ\n2 - Renderowanie kostki (siatki)\n3 - Renderowanie śmigła\n.\n.\n.\nQ - przełącz tryb myszy\nEsc - wyjdź z symulacji\n" << std::endl;
+    int exitCode = 0;
+    if (FluidBench::Dispatch(argc, argv, exitCode)) return exitCode;
+
+    std::cout << "Symulacja rozpoczęta...\n\nNaciśnij: \n1 - Renderowanie osi XYZ\n2 - Renderowanie kostki (siatki)\n3 - Renderowanie śmigła\n4 - Renderowanie gęstości barwnika\n5 - Renderowanie objętościowe barwnika\n6 - Strzałki prędkości\n7 - Linie prądu\nM - zmiana modelu (śmigło / turbina)\nV - siatka voxeli: pełna / zajęta przez model\nT - statystyki czasów klatki\n.\n.\n.\nQ - przełącz tryb myszy\nEsc - wyjdź z symulacji\n" << std::endl;
 
     Simulation& sim = Simulation::Instance();
 